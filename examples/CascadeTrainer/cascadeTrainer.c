@@ -0,0 +1,275 @@
+/*
+% MIT License
+%
+% Copyright (c) 2016 OneCV
+%
+% Permission is hereby granted, free of charge, to any person obtaining a copy
+% of this software and associated documentation files (the "Software"), to deal
+% in the Software without restriction, including without limitation the rights
+% to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+% copies of the Software, and to permit persons to whom the Software is
+% furnished to do so, subject to the following conditions:
+%
+% The above copyright notice and this permission notice shall be included in all
+% copies or substantial portions of the Software.
+%
+% THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+% IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+% FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+% AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+% LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+% OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+% SOFTWARE.
+*/
+
+/* ------------------------------------------------------------------------- /
+ *
+ * Module: cascadeTrainer.c
+ * Author: OneCV
+ *
+ * Description:
+ * Offline haar-cascade trainer: BMP folders in, muLoadSimpleDetector
+ * text format (and optionally a CascadeParaTable header) out.
+ *
+ -------------------------------------------------------------------------- */
+
+#include <ctype.h>
+#if defined(WIN32) || defined(WIN64)
+#include <io.h>
+#if defined(_MSC_VER) && _MSC_VER < 1900
+#define snprintf _snprintf	/* returns -1 on truncation, caught by the checks below */
+#endif
+#else
+#include <dirent.h>
+#endif
+#include "muGadget.h"
+
+#define MAX_FILES 100000
+
+static int isBMP(const char *name)
+{
+	size_t len = strlen(name);
+
+	return len > 4 && name[len-4] == '.' &&
+		tolower(name[len-3]) == 'b' && tolower(name[len-2]) == 'm' && tolower(name[len-1]) == 'p';
+}
+
+/* BGR or gray BMP to a gray image */
+static muImage_t *loadGray(const char *filename)
+{
+	muImage_t *bmp, *gray;
+	int i;
+
+	bmp = muLoadBMP(filename);
+	if(bmp == NULL)
+		return NULL;
+	if(bmp->channels == 1)
+		return bmp;
+
+	gray = muCreateImage(muSize(bmp->width, bmp->height), MU_IMG_DEPTH_8U, 1);
+	for(i=0; i<bmp->width*bmp->height; i++)
+	{
+		MU_8U *p = bmp->imagedata + i*3;
+		gray->imagedata[i] = (MU_8U)((p[0]*29 + p[1]*150 + p[2]*77) >> 8);
+	}
+	muReleaseImage(&bmp);
+
+	return gray;
+}
+
+/* Load every BMP of a folder, resized to size when size is not zero */
+static int loadFolder(const char *folder, muSize_t size, muImage_t **images, int maxNum)
+{
+	char path[1024];
+	int num = 0, len;
+	muImage_t *img;
+#if defined(WIN32) || defined(WIN64)
+	struct _finddata_t fd;
+	intptr_t handle;
+
+	len = snprintf(path, sizeof(path), "%s\\*.bmp", folder);
+	if(len < 0 || len >= (int)sizeof(path))
+		return 0;
+	handle = _findfirst(path, &fd);
+	if(handle == -1)
+		return 0;
+	do
+	{
+		/* names that do not fit path are skipped */
+		len = snprintf(path, sizeof(path), "%s\\%s", folder, fd.name);
+		if(len < 0 || len >= (int)sizeof(path))
+			continue;
+#else
+	DIR *dir;
+	struct dirent *entry;
+
+	dir = opendir(folder);
+	if(dir == NULL)
+		return 0;
+	while((entry = readdir(dir)) != NULL && num < maxNum)
+	{
+		if(!isBMP(entry->d_name))
+			continue;
+		/* names that do not fit path are skipped */
+		len = snprintf(path, sizeof(path), "%s/%s", folder, entry->d_name);
+		if(len < 0 || len >= (int)sizeof(path))
+			continue;
+#endif
+		img = loadGray(path);
+		if(img == NULL)
+			continue;
+		if(size.width > 0 && (img->width != size.width || img->height != size.height))
+		{
+			muImage_t *resized = muCreateImage(size, MU_IMG_DEPTH_8U, 1);
+			muResize(img, resized, MU_INTER_NN);
+			muReleaseImage(&img);
+			img = resized;
+		}
+		images[num++] = img;
+#if defined(WIN32) || defined(WIN64)
+	} while(_findnext(handle, &fd) == 0 && num < maxNum);
+	_findclose(handle);
+#else
+	}
+	closedir(dir);
+#endif
+
+	return num;
+}
+
+/* The text cascade and the CascadeParaTable share the same number order */
+static int writeParaTable(const char *cascadeFile, const char *tableFile)
+{
+	FILE *in, *out;
+	double value;
+	int i, j, k, n, rn, count = 0, stages = 0, classifiers = 0;
+
+	in = fopen(cascadeFile, "r");
+	if(in == NULL)
+		return -1;
+	while(fscanf(in, "%lf", &value) == 1)
+		count++;
+
+	/* count classifiers from the stage headers */
+	rewind(in);
+	fscanf(in, "%lf %lf %d", &value, &value, &stages);
+	for(i=0; i<stages; i++)
+	{
+		fscanf(in, "%d", &n);
+		classifiers += n;
+		for(j=0; j<n; j++)
+		{
+			fscanf(in, "%lf %d", &value, &rn);
+			for(k=0; k<rn*5+4; k++)
+				fscanf(in, "%lf", &value);
+		}
+		fscanf(in, "%lf %lf %lf", &value, &value, &value);
+	}
+
+	out = fopen(tableFile, "w");
+	if(out == NULL)
+	{
+		fclose(in);
+		return -1;
+	}
+	fprintf(out, "#define NumStages %d\n#define NumClassifiers %d\n#define NumParas %d\n\n",
+		stages, classifiers, count);
+	fprintf(out, "double CascadeParaTable[NumParas] = {");
+	rewind(in);
+	for(i=0; i<count && fscanf(in, "%lf", &value) == 1; i++)
+		fprintf(out, "%s%.9g", i ? ", " : "", value);
+	fprintf(out, "};\n");
+
+	fclose(in);
+	fclose(out);
+
+	return 0;
+}
+
+static void help()
+{
+	printf(
+"Usage: cascadeTrainer -pos <folder> -neg <folder> [OPTION]\n"
+"\t-o filename      output cascade (MuDetector.txt)\n"
+"\t-table filename  also write a CascadeParaTable header\n"
+"\t-w width         window width (24, at least 9)\n"
+"\t-h height        window height (24, at least 9)\n"
+"\t-stages n        maximum number of stages (10)\n"
+"\t-hit rate        minimum hit rate per stage (0.995)\n"
+"\t-fa rate         maximum false alarm per stage (0.5)\n"
+"\t-negs n          negative windows per stage (1000)\n"
+"\t-features n      random feature pool size (2000)\n"
+"\t-weak n          maximum weak classifiers per stage (0: no limit)\n"
+"\t-seed n          feature pool seed (0)\n"
+	);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *posDir = NULL, *negDir = NULL, *output = "MuDetector.txt", *table = NULL;
+	MuCascadeTrainParams params;
+	muImage_t **pos, **neg;
+	int i, posNum, negNum;
+	muError_t ret;
+
+	params.winSize = muSize(24, 24);
+	params.maxStages = 10;
+	params.maxWeakCount = 0;
+	params.numFeatures = 2000;
+	params.negPerStage = 1000;
+	params.minHitRate = 0.995;
+	params.maxFalseAlarm = 0.5;
+	params.seed = 0;
+
+	for(i=1; i+1<argc; i+=2)
+	{
+		if(!strcmp(argv[i], "-pos")) posDir = argv[i+1];
+		else if(!strcmp(argv[i], "-neg")) negDir = argv[i+1];
+		else if(!strcmp(argv[i], "-o")) output = argv[i+1];
+		else if(!strcmp(argv[i], "-table")) table = argv[i+1];
+		else if(!strcmp(argv[i], "-w")) params.winSize.width = atoi(argv[i+1]);
+		else if(!strcmp(argv[i], "-h")) params.winSize.height = atoi(argv[i+1]);
+		else if(!strcmp(argv[i], "-stages")) params.maxStages = atoi(argv[i+1]);
+		else if(!strcmp(argv[i], "-hit")) params.minHitRate = atof(argv[i+1]);
+		else if(!strcmp(argv[i], "-fa")) params.maxFalseAlarm = atof(argv[i+1]);
+		else if(!strcmp(argv[i], "-negs")) params.negPerStage = atoi(argv[i+1]);
+		else if(!strcmp(argv[i], "-features")) params.numFeatures = atoi(argv[i+1]);
+		else if(!strcmp(argv[i], "-weak")) params.maxWeakCount = atoi(argv[i+1]);
+		else if(!strcmp(argv[i], "-seed")) params.seed = (MU_32U)atoi(argv[i+1]);
+		else
+		{
+			help();
+			return -1;
+		}
+	}
+	if(posDir == NULL || negDir == NULL)
+	{
+		help();
+		return -1;
+	}
+
+	pos = (muImage_t **)malloc(MAX_FILES*sizeof(muImage_t *));
+	neg = (muImage_t **)malloc(MAX_FILES*sizeof(muImage_t *));
+	posNum = loadFolder(posDir, params.winSize, pos, MAX_FILES);
+	negNum = loadFolder(negDir, muSize(0, 0), neg, MAX_FILES);
+	printf("positives: %d, negative images: %d\n", posNum, negNum);
+
+	ret = muTrainCascade(pos, posNum, neg, negNum, &params, output);
+	if(ret != MU_ERR_SUCCESS)
+		muDebugError(ret);
+	else
+	{
+		printf("cascade written to %s\n", output);
+		if(table != NULL && writeParaTable(output, table) != 0)
+			printf("Error in writing %s\n", table);
+	}
+
+	for(i=0; i<posNum; i++)
+		muReleaseImage(&pos[i]);
+	for(i=0; i<negNum; i++)
+		muReleaseImage(&neg[i]);
+	free(pos);
+	free(neg);
+
+	return ret == MU_ERR_SUCCESS ? 0 : -1;
+}
@@ -52,6 +52,9 @@ void help()
 "\t4. muImage region Operating Test\n"
 "\t5. muDrawRectangle Test\n"
 "\t6. muRGB2HSV Test\n"
+"\t7. muGaussianIIR Accuracy Test\n"
+"\t8. Packed Bit Mask Test\n"
+"\t9. muObjectLearning_Update Test\n"
 	);
 }
 
@@ -133,6 +136,42 @@ int main(int argc, char *argv[])
 					logError("muRGB2HSV must give a input file testModue.exe -i test.bmp -n 6\n");
 				}
 				break;
+			case 7:
+				logInfo("muGaussianIIR test\n");
+				status = testGaussianIIR();
+				if(status)
+				{
+					logInfo("Failed\n");
+				}
+				else
+				{
+					logInfo("Passed\n");
+				}
+				break;
+			case 8:
+				logInfo("muBitMask test\n");
+				status = testBitMask();
+				if(status)
+				{
+					logInfo("Failed\n");
+				}
+				else
+				{
+					logInfo("Passed\n");
+				}
+				break;
+			case 9:
+				logInfo("muObjectLearning_Update test\n");
+				status = testObjectLearningUpdate();
+				if(status)
+				{
+					logInfo("Failed\n");
+				}
+				else
+				{
+					logInfo("Passed\n");
+				}
+				break;
 			default:
 				break;
 		}
@@ -4,3 +4,6 @@
 
 
 extern int testRGB2HSV(char *);
+extern int testGaussianIIR();
+extern int testBitMask();
+extern int testObjectLearningUpdate();
@@ -120,6 +120,166 @@ int testRGB2HSV(char *rgbFile)
 	return 0;
 }
 
+/* muGaussianIIR against a direct convolution with a sampled Gaussian, replicated borders */
+int testGaussianIIR()
+{
+	muImage_t *src, *dst;
+	muSize_t size;
+	MU_64F sigma[4] = {0.8, 2.0, 5.0, 20.0};
+	MU_64F *kernel, *tmp, sum, err, sErr, maxErr;
+	MU_32S i, j, k, r, s, x, y;
+	MU_32F *in, *out;
+
+	size.width = 73;
+	size.height = 51;
+	src = muCreateImage(size, MU_IMG_DEPTH_32F, 1);
+	dst = muCreateImage(size, MU_IMG_DEPTH_32F, 1);
+	tmp = (MU_64F *)malloc(size.width*size.height*sizeof(MU_64F));
+	in = (MU_32F *)src->imagedata;
+	out = (MU_32F *)dst->imagedata;
+
+	//noise on the left, horizontal bars on the right
+	srand(1);
+	for(i=0; i<size.height; i++)
+		for(j=0; j<size.width; j++)
+			in[i*size.width+j] = (MU_32F)(j < 30 ? rand()%256 : ((i/8)%2)*255);
+
+	maxErr = 0;
+	for(s=0; s<4; s++)
+	{
+		r = (MU_32S)ceil(5*sigma[s]);
+		kernel = (MU_64F *)malloc((2*r+1)*sizeof(MU_64F));
+		sum = 0;
+		for(k=-r; k<=r; k++)
+		{
+			kernel[k+r] = exp(-k*k/(2*sigma[s]*sigma[s]));
+			sum += kernel[k+r];
+		}
+		for(k=0; k<=2*r; k++)
+			kernel[k] /= sum;
+
+		muGaussianIIR(src, dst, sigma[s]);
+		sErr = 0;
+
+		for(i=0; i<size.height; i++)
+			for(j=0; j<size.width; j++)
+			{
+				tmp[i*size.width+j] = 0;
+				for(k=-r; k<=r; k++)
+				{
+					x = j+k < 0 ? 0 : (j+k >= size.width ? size.width-1 : j+k);
+					tmp[i*size.width+j] += kernel[k+r]*in[i*size.width+x];
+				}
+			}
+
+		for(i=0; i<size.height; i++)
+			for(j=0; j<size.width; j++)
+			{
+				sum = 0;
+				for(k=-r; k<=r; k++)
+				{
+					y = i+k < 0 ? 0 : (i+k >= size.height ? size.height-1 : i+k);
+					sum += kernel[k+r]*tmp[y*size.width+j];
+				}
+				err = fabs(out[i*size.width+j] - sum);
+				if(err > sErr)
+					sErr = err;
+			}
+
+		printf("sigma %.1f max error %f\n", sigma[s], sErr);
+		if(sErr > maxErr)
+			maxErr = sErr;
+		free(kernel);
+	}
+
+	free(tmp);
+	muReleaseImage(&src);
+	muReleaseImage(&dst);
+
+	//the recursive approximation stays within 0.05% of the peak
+	return maxErr < 0.25 ? 0 : -1;
+}
+
+/* packed masks against the 8U mask functions they replace */
+int testBitMask()
+{
+	muImage_t *a, *b, *ref, *out;
+	muBitMask_t *pa, *pb, *pr;
+	muSize_t size, ksize;
+	muRect_t roi;
+	MU_32U count, refCount;
+	MU_32S i, x, y, op, errors;
+
+	size.width = 131;
+	size.height = 47;
+	a = muCreateImage(size, MU_IMG_DEPTH_8U, 1);
+	b = muCreateImage(size, MU_IMG_DEPTH_8U, 1);
+	ref = muCreateImage(size, MU_IMG_DEPTH_8U, 1);
+	out = muCreateImage(size, MU_IMG_DEPTH_8U, 1);
+	pa = muCreateBitMask(size);
+	pb = muCreateBitMask(size);
+	pr = muCreateBitMask(size);
+
+	srand(1);
+	for(i=0; i<size.width*size.height; i++)
+	{
+		a->imagedata[i] = rand()%3 ? 255 : 0;
+		b->imagedata[i] = rand()%2 ? 255 : 0;
+	}
+
+	muPackBitMask(a, pa);
+	muPackBitMask(b, pb);
+	errors = 0;
+
+	//round trip
+	muUnpackBitMask(pa, out);
+	errors += memcmp(a->imagedata, out->imagedata, size.width*size.height) != 0;
+
+	muAnd(a, b, ref);
+	muBitAnd(pa, pb, pr);
+	muUnpackBitMask(pr, out);
+	errors += memcmp(ref->imagedata, out->imagedata, size.width*size.height) != 0;
+
+	muOr(a, b, ref);
+	muBitOr(pa, pb, pr);
+	muUnpackBitMask(pr, out);
+	errors += memcmp(ref->imagedata, out->imagedata, size.width*size.height) != 0;
+
+	muSub(a, b, ref);
+	muBitSub(pa, pb, pr);
+	muUnpackBitMask(pr, out);
+	errors += memcmp(ref->imagedata, out->imagedata, size.width*size.height) != 0;
+
+	roi = muRect(37, 5, 70, 30);
+	refCount = 0;
+	for(y=roi.y; y<roi.y+roi.height; y++)
+		for(x=roi.x; x<roi.x+roi.width; x++)
+			refCount += a->imagedata[y*size.width+x] != 0;
+	muBitCount(pa, &roi, &count);
+	errors += count != refCount;
+
+	for(op=MU_MORPH_ERODE; op<=MU_MORPH_BLACKHAT; op++)
+	{
+		ksize.width = 3 + 2*op;
+		ksize.height = 2 + op;
+		muMorphology(a, ref, op, ksize);
+		muBitMorphology(pa, pr, op, ksize);
+		muUnpackBitMask(pr, out);
+		errors += memcmp(ref->imagedata, out->imagedata, size.width*size.height) != 0;
+	}
+
+	printf("bit mask mismatches %d\n", errors);
+
+	muReleaseBitMask(&pa);
+	muReleaseBitMask(&pb);
+	muReleaseBitMask(&pr);
+	muReleaseImage(&a);
+	muReleaseImage(&b);
+	muReleaseImage(&ref);
+	muReleaseImage(&out);
+
+	return errors ? -1 : 0;
+}
 
 int testMuCore()
 {
@@ -0,0 +1,181 @@
+#include "testModule.h"
+
+/* white box: the online update keeps its sample rings and sweep in file statics */
+#include "../../mugadget/src/muObjectLearning.c"
+
+#define TEST_LEARN_IMAGES 3
+
+/* active feature values of every window of one image, window-major */
+static float *testLearningWindows(muImage_t *img, const int *active, int activeNum, muSize_t win, int *winNum)
+{
+	muSize_t frameSize, sumSize;
+	int *sum;
+	double *sqsum;
+	float *values;
+	int ix, iy, j, n, endX, endY;
+
+	frameSize.width = img->width;
+	frameSize.height = img->height;
+	sumSize.width = img->width+1;
+	sumSize.height = img->height+1;
+	endX = img->width-win.width;
+	endY = img->height-win.height;
+
+	sum = (int *)malloc(sizeof(int)*sumSize.width*sumSize.height);
+	sqsum = (double *)malloc(sizeof(double)*sumSize.width*sumSize.height);
+	values = (float *)malloc(sizeof(float)*(endX+1)*(endY+1)*activeNum);
+	muCalcIntegralImage(img->imagedata, sum, sqsum, frameSize);
+	setLearningImage(LearnedModel, sum, sqsum, sumSize);
+
+	n = 0;
+	for(iy=0; iy<=endY; iy++)
+		for(ix=0; ix<=endX; ix++, n++)
+		{
+			int offset = iy*sumSize.width+ix;
+			double norm = muLearningWindowNorm(LearnedModel, offset);
+
+			for(j=0; j<activeNum; j++)
+				values[n*activeNum+j] = (float)(muLearningHaarSum(&LearnedModel->pool[active[j]], offset)*norm);
+		}
+
+	free(sum);
+	free(sqsum);
+	*winNum = n;
+	return values;
+}
+
+/* index of the window whose active feature values are slot s of the rings, -1 if none */
+static int testLearningFindSlot(float *const *values, const int *winNum, const int *active, int activeNum,
+								const float *ring, int stride, int s)
+{
+	int i, w, j;
+
+	for(i=0; i<TEST_LEARN_IMAGES; i++)
+		for(w=0; w<winNum[i]; w++)
+		{
+			const float *v = values[i] + w*activeNum;
+
+			for(j=0; j<activeNum; j++)
+			{
+				float r = ring[active[j]*stride + s];
+
+				if(fabs(v[j] - r) > 1e-4*(1 + fabs(r)))
+					break;
+			}
+			if(j == activeNum)
+				return i*winNum[0] + w;
+		}
+
+	return -1;
+}
+
+/* muObjectLearning_Update on a sorted model: every ring slot holds one real window
+ * in every feature row, and the re-scored stages equal a fresh sweep over those windows */
+int testObjectLearningUpdate()
+{
+	muImage_t *img[TEST_LEARN_IMAGES];
+	MuSimpleDetector *detector;
+	muRect_t box, boxB;
+	muSize_t size;
+	float *values[TEST_LEARN_IMAGES];
+	float *pos, *neg;
+	int *posWin, *negWin;
+	int winNum[TEST_LEARN_IMAGES];
+	int active[MAX_SELECTED+MAX_CANDIDATE];
+	int activeNum, i, j, k, x, y, errors;
+	muError_t ret;
+
+	size.width = 96;
+	size.height = 72;
+	for(i=0; i<TEST_LEARN_IMAGES; i++)
+		img[i] = muCreateImage(size, MU_IMG_DEPTH_8U, 1);
+
+	//learning frame, background frame and the next frame with the object moved by (2, 1)
+	srand(3);
+	box = muRect(36, 24, 24, 24);
+	boxB = muRect(38, 25, 24, 24);
+	for(y=0; y<size.height; y++)
+		for(x=0; x<size.width; x++)
+		{
+			img[0]->imagedata[y*size.width+x] = (MU_8U)(rand()%160);
+			img[1]->imagedata[y*size.width+x] = (MU_8U)(rand()%256);
+			img[2]->imagedata[y*size.width+x] = (MU_8U)(rand()%160);
+		}
+	for(y=0; y<box.height; y++)
+		for(x=0; x<box.width; x++)
+		{
+			MU_8U v = (MU_8U)(((x/6 + y/8)%2)*150 + 60 + rand()%20);
+
+			img[0]->imagedata[(box.y+y)*size.width+box.x+x] = v;
+			img[2]->imagedata[(boxB.y+y)*size.width+boxB.x+x] = v;
+		}
+
+	muObjectLearning_InitEx(img[0], &box, img[1], MU_LEARNING_SORTED);
+	detector = muLoadSimpleDetector("MuDetector.txt");
+	ret = muObjectLearning_Update(img[2], &boxB, detector);
+	if(ret != MU_ERR_SUCCESS)
+	{
+		printf("muObjectLearning_Update returned %d\n", ret);
+		return -1;
+	}
+
+	activeNum = SelectedNum + CandidateNum;
+	memcpy(active, SelectedIndex, SelectedNum*sizeof(int));
+	memcpy(active+SelectedNum, CandidateIndex, CandidateNum*sizeof(int));
+	for(i=0; i<TEST_LEARN_IMAGES; i++)
+		values[i] = testLearningWindows(img[i], active, activeNum, LearnedModel->orig_window_size, &winNum[i]);
+
+	//every ring slot must be one window seen by learning or update
+	errors = 0;
+	posWin = (int *)malloc(LearnedPosNum*sizeof(int));
+	negWin = (int *)malloc(LearnedNegNum*sizeof(int));
+	for(k=0; k<LearnedPosNum; k++)
+	{
+		posWin[k] = testLearningFindSlot(values, winNum, active, activeNum, HaarValuePos[0], MAX_POS, k);
+		errors += posWin[k] < 0;
+	}
+	for(k=0; k<LearnedNegNum; k++)
+	{
+		negWin[k] = testLearningFindSlot(values, winNum, active, activeNum, HaarValueNeg[0], MAX_NEG, k);
+		errors += negWin[k] < 0;
+	}
+	printf("object learning: %d of %d ring slots are no real window\n", errors, LearnedPosNum + LearnedNegNum);
+
+	//fresh sweep of every stage over the windows of the rings
+	pos = (float *)malloc(MAX_POS*sizeof(float));
+	neg = (float *)malloc(MAX_NEG*sizeof(float));
+	for(j=0; j<SelectedNum && !errors; j++)
+	{
+		MuLearningHaarClassifier weak;
+		MuHaarTreeNode *node = &detector->stage_classifier[j].classifier[0].node;
+
+		for(k=0; k<LearnedPosNum; k++)
+			pos[k] = values[posWin[k]/winNum[0]][(posWin[k]%winNum[0])*activeNum + j];
+		for(k=0; k<LearnedNegNum; k++)
+			neg[k] = values[negWin[k]/winNum[0]][(negWin[k]%winNum[0])*activeNum + j];
+		qsort(pos, LearnedPosNum, sizeof(float), muCompareFloat);
+		qsort(neg, LearnedNegNum, sizeof(float), muCompareFloat);
+		muSweepThreshold(pos, LearnedPosNum, neg, LearnedNegNum, LearnedPosNum, &weak);
+
+		if(fabs(node->threshold - weak.threshold) > 1e-4*(1 + fabs(weak.threshold)) ||
+		   node->right != (weak.polar == 1 ? 1.f : 0.f))
+		{
+			printf("stage %d: threshold %f, fresh sweep %f\n", j, node->threshold, weak.threshold);
+			errors++;
+		}
+	}
+
+	free(pos);
+	free(neg);
+	free(posWin);
+	free(negWin);
+	for(i=0; i<TEST_LEARN_IMAGES; i++)
+	{
+		free(values[i]);
+		muReleaseImage(&img[i]);
+	}
+	muReleaseSimpleDetector(detector);
+	muObjectLearning_Release();
+
+	return errors ? -1 : 0;
+}
@@ -75,6 +75,17 @@ MU_API(muError_t) muRemoveSubImage(muImage_t *src, const muRect_t rect, const MU
 /* Get the sub image to dst YUV422*/
 MU_API(muError_t)  muGetSubYUV422Image(const muImage_t *src, muImage_t *dst, const muRect_t rect);
 
+/* Describes a YUV frame living in external buffers, a zero stride means tightly packed
+   and NULL chroma planes are taken to follow the previous plane contiguously */
+MU_API(muError_t)  muInitPlanarImage(muPlanarImage_t *img, muSize_t size, MU_32S format,
+                                     MU_8U *p0, MU_32S s0, MU_8U *p1, MU_32S s1, MU_8U *p2, MU_32S s2);
+
+/* Fills an image header which refers to one plane in place (no copy, do not release its data) */
+MU_API(muError_t)  muGetPlaneHeader(const muPlanarImage_t *src, MU_32S plane, muImage_t *dst);
+
+/* Get the sub frame of a multi-plane image as a view on the same buffers */
+MU_API(muError_t)  muGetSubPlanarImage(const muPlanarImage_t *src, muPlanarImage_t *dst, const muRect_t rect);
+
 /* Return the particular element of image (idx0:height, idx1:width, idx2:channel) */
 /* The functions return 0 if the requested node does not exist */
 MU_API(MU_32S)  muGet2D(const muImage_t *image, MU_32S idx0, MU_32S idx1);
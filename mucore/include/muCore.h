@@ -44,6 +44,21 @@
 
 /************************* Gradients, Edges and Corners *********************************/
 
+/* muGradient operators */
+#define MU_GRAD_SOBEL   0
+#define MU_GRAD_PREWITT 1
+
+/* muGradient outputs, combine with | */
+#define MU_GRAD_DX      0x01 /* d/dx in a 16S image */
+#define MU_GRAD_DY      0x02 /* d/dy in a 16S image */
+#define MU_GRAD_MAG     0x04 /* |dx|+|dy| in an 8U (saturated), 16S or 32F image */
+#define MU_GRAD_DIR     0x08 /* direction quantized to 0/45/90/135 in an 8U image */
+#define MU_GRAD_L2      0x10 /* MU_GRAD_MAG is sqrt(dx^2+dy^2) */
+#define MU_GRAD_ANGLE   0x20 /* MU_GRAD_DIR is the angle in degrees [0, 360) in a 32F image */
+
+/* Computes the selected gradient outputs of a 3x3 operator in one pass */
+MU_API(muError_t) muGradient(const muImage_t *src, MU_32S op, MU_32S flags, muImage_t *dx, muImage_t *dy, muImage_t *mag, muImage_t *dir);
+
 /* Calculates an image derivative using generalized Sobel
    (aperture_size = 1,3,5,7) or Scharr (aperture_size = -1) operator.
    Scharr can be used only for the first dx or dy derivative */
@@ -64,7 +79,8 @@ MU_API(muError_t) muNoRefBlurMetric(muImage_t *src, MU_64F *bm);
 /****************** Sampling, Interpolation and Geometrical Transforms ******************/
 
 #define  MU_INTER_NN        0
-#define  MU_INTER_LINEAR    1 // not support
+#define  MU_INTER_LINEAR    1 // not support by muResize
+#define  MU_INTER_AREA      2 // muYUVtoGrayScale only
 
 /* Resizes image (input array is resized to fit the destination array) */
 MU_API(muError_t) muResize( const muImage_t* src, muImage_t* dst,
@@ -85,12 +101,15 @@ MU_API(muError_t) muDownScaleMemcpy422( const muImage_t* src, muImage_t* dst, MU
 /* DownScale */
 MU_API(muError_t) muDownScaleMemcpy420( const muImage_t* src, muImage_t* dst, MU_32S v_scale, MU_32S h_scale);
 
+/* Fused front-end: luma of a YUV frame to a gray image of the dst size (area, bilinear or nearest) */
+MU_API(muError_t) muYUVtoGrayScale(const muPlanarImage_t *src, muImage_t *dst, MU_32S interpolation);
+
 /* Neareast Image Rotation */
 MU_API(muImage_t*) muImageRotate(const muImage_t *src, MU_64F angle);
 
 /*************************** Filters and Color Conversion *******************************/
 
-#define MU_BORDER_NONE      0 // (default and only support currently)
+#define MU_BORDER_NONE      0 // (default, the only mode of muFilter33/55)
                                // not treat the border pixels, the output image will have black border
 #define MU_BORDER_CONSTANT  1 // border is filled with the fixed value, passed as last parameter of the function.
 #define MU_BORDER_REPLICATE 2 // the pixels from the top and bottom rows, the left-most and right-most columns are replicated to fill the border.
@@ -100,11 +119,29 @@ MU_API(muError_t) muFilter55( const muImage_t* src, muImage_t* dst, const MU_8S
 /* Convolves the image with the 3*3 kernel */
 MU_API(muError_t) muFilter33( const muImage_t* src, muImage_t* dst, const MU_8S kernel[], const MU_8U norm);
 
-/* 3x3 median filter by bubble sort */
+/* Separable convolution with a row and a column kernel of any odd size, dst = (ky * (kx * src)) / norm */
+MU_API(muError_t) muSepFilter(const muImage_t *src, muImage_t *dst, const MU_32F kx[], MU_32S kxlen,
+                              const MU_32F ky[], MU_32S kylen, MU_32F norm, MU_32S border, MU_32F borderValue);
+MU_API(muError_t) muSepFilterInt(const muImage_t *src, muImage_t *dst, const MU_32S kx[], MU_32S kxlen,
+                                 const MU_32S ky[], MU_32S kylen, MU_32S norm, MU_32S border, MU_32S borderValue);
+/* Gaussian smoothing, ksize <= 0 derives the kernel size from sigma */
+MU_API(muError_t) muGaussianBlur(const muImage_t *src, muImage_t *dst, MU_32S ksize, MU_64F sigma, MU_32S border);
+/* Recursive Gaussian smoothing (replicated borders), the cost does not depend on sigma */
+MU_API(muError_t) muGaussianIIR(const muImage_t *src, muImage_t *dst, MU_64F sigma);
+
+/* Box filter, window sum or (normalize) mean with a cost independent of ksize */
+MU_API(muError_t) muBoxFilter(const muImage_t *src, muImage_t *dst, muSize_t ksize, MU_32S normalize, MU_32S border);
+/* Local mean and variance maps (32F) of the ksize window, mean or var may be NULL */
+MU_API(muError_t) muLocalMeanVar(const muImage_t *src, muImage_t *mean, muImage_t *var, muSize_t ksize, MU_32S border);
+
+/* 3x3 median filter, same as muMedianFilter(src, dst, 3, MU_BORDER_NONE) */
 MU_API(muError_t) muMedian33( const muImage_t *src, muImage_t *dst);
 
 MU_API(muError_t) muFastMedian33(muImage_t *src, muImage_t *dst);
 
+/* Median filter of any odd ksize up to 255, sorting network for 3x3/5x5, constant-time histogram beyond */
+MU_API(muError_t) muMedianFilter(const muImage_t *src, muImage_t *dst, MU_32S ksize, MU_32S border);
+
 
 /* This routine stretchs the original data to the user-defined value. */
 MU_API(muError_t) muContraststretching(muImage_t *src, muImage_t *dst, MU_8U maxvalue);
@@ -120,6 +157,25 @@ MU_API(muError_t) muISOThresholding(const muImage_t *src, muImage_t *dst);
 
 MU_API(muError_t) muMeanThresholding(const muImage_t *src, muImage_t *dst, MU_8U offset);
 
+/* Global threshold selectors of muHistThreshold / muAutoThresholding */
+#define MU_THRESH_OTSU    0
+#define MU_THRESH_ISODATA 1
+#define MU_THRESH_MEAN    2
+
+/* Selects a global threshold from a 256 bin histogram, -1 for an unknown method */
+MU_API(MU_32S) muHistThreshold(const MU_32U *hist, MU_32S method);
+
+/* Selects a global threshold and binarizes in one call: dst = 255 where src > th */
+MU_API(muError_t) muAutoThresholding(const muImage_t *src, muImage_t *dst, MU_32S method, MU_32S *th);
+
+/* Local threshold selectors of muAdaptiveThreshold */
+#define MU_ADAPTIVE_MEAN     0 /* mean - param */
+#define MU_ADAPTIVE_GAUSSIAN 1 /* Gaussian weighted mean - param */
+#define MU_ADAPTIVE_SAUVOLA  2 /* mean*(1 + param*(stddev/128 - 1)) */
+
+/* Binarizes against a threshold computed over the blockSize x blockSize window of every pixel */
+MU_API(muError_t) muAdaptiveThreshold(const muImage_t *src, muImage_t *dst, MU_32S method, MU_32S blockSize, MU_64F param);
+
 /* This routine transform the RGB plane to the Y plane. */
 MU_API(muError_t) muRGB2GrayLevel(const muImage_t * src, muImage_t * dst);
 
@@ -132,10 +188,23 @@ MU_API(muError_t) muYUV422toRGB(const muImage_t *src, muImage_t *dst);
 /* This routine transform the yuv420 plane to the RGB. */
 MU_API(muError_t) muYUV420toRGB(const muImage_t *src, muImage_t *dst);
 
-/* This routine transform the RGB plane to the Hue plane. */
+/* Output pixel formats for muYUVtoRGB */
+#define MU_PIX_RGB   0
+#define MU_PIX_BGR   1
+#define MU_PIX_RGBA  2
+#define MU_PIX_GRAY  3
+
+/* This routine transform the YUV planes given by pointers and strides to RGB, BGR, RGBA or gray. */
+MU_API(muError_t) muYUVtoRGB(const MU_8U *p0, MU_32S s0, const MU_8U *p1, MU_32S s1, const MU_8U *p2, MU_32S s2,
+                             MU_32S yuvformat, muImage_t *dst, MU_32S pixformat);
+
+/* This routine transform a multi-plane YUV frame to RGB, BGR, RGBA or gray, reading the planes in place. */
+MU_API(muError_t) muPlanarImagetoRGB(const muPlanarImage_t *src, muImage_t *dst, MU_32S pixformat);
+
+/* This routine transform the RGB plane to the Hue plane (16U: 0~360, 8U: hue/2). */
 MU_API(muError_t) muRGB2Hue(const muImage_t * src, muImage_t * dst);
 
-/* This routine transform the RGB plane to the HSV/HSB plane. */
+/* This routine transform the RGB plane to the HSV/HSB plane (16U: h 0~360, 8U: h/2; s, v 0~100). */
 MU_API(muError_t) muRGB2HSV(const muImage_t *rgb, muImage_t *hsv);
 
 /* This routine transform the gray to RGBA plane to the Hue plane. */
@@ -147,12 +216,40 @@ MU_API(muError_t) muRGB2XYZ(const muImage_t *src, muImage_t *dst);
 /* This routine transform the RGB to XYZ plane. */
 MU_API(muError_t) muXYZ2LAB(const muImage_t *src, muImage_t *dst);
 
+/* This routine transform the RGB plane to LAB in one fixed-point pass (32F or 8U output). */
+MU_API(muError_t) muRGB2LAB(const muImage_t *src, muImage_t *dst);
+
+/* Compiles a per-pixel color predicate or mapping into a 3D LUT */
+MU_API(muColorLUT_t*) muCreateColorLUT(MU_32S bits, MU_32S channels, muColorMapFunc_t func, MU_VOID *userdata);
+
+/* Compiles an inclusive muRGB2HSV range (hmin > hmax wraps through 0) into a mask LUT, bits 1~6 */
+MU_API(muColorLUT_t*) muCreateHSVRangeLUT(MU_32S bits, MU_32S hmin, MU_32S hmax, MU_32S smin, MU_32S smax,
+                                          MU_32S vmin, MU_32S vmax);
+
+/* Releases a color LUT */
+MU_API(muError_t) muReleaseColorLUT(muColorLUT_t **lut);
+
+/* Maps an image through a LUT, MU_INTER_NN (direct index) or MU_INTER_LINEAR (trilinear) */
+MU_API(muError_t) muApplyColorLUT(const muImage_t *src, muImage_t *dst, const muColorLUT_t *lut, MU_32S interpolation);
+
+/* Caches a compiled LUT on disk */
+MU_API(muError_t) muSaveColorLUT(const char *filename, const muColorLUT_t *lut);
+
+/* Loads a LUT written by muSaveColorLUT */
+MU_API(muColorLUT_t*) muLoadColorLUT(const char *filename);
+
 /********* Image Segmentation, Connected Components and Contour Retrieval ***************/
 
 /* Retrieves bounding boxes of white (non-zero) connected
    components in the black (zero) background */
 MU_API(muError_t) mu4ConnectedComponent8u(muImage_t * src, muImage_t * dst, MU_8U *numlabel);
 
+/* Two-pass union-find labeling into a 32S image with 4 or 8-connectivity, the same pass fills
+   the statistics of every component, released with muReleaseComponentStats */
+MU_API(muError_t) muConnectedComponents(const muImage_t *src, muImage_t *labels, MU_32S connectivity, muComponentStat_t **stats, MU_32S *num);
+
+MU_API(muError_t) muReleaseComponentStats(muComponentStat_t **stats);
+
 /* ?? */
 MU_API(muSeq_t*) muFindBoundingBox(const muImage_t * image, MU_8U numlabel,  muDoubleThreshold_t th);
 
@@ -198,6 +295,20 @@ MU_API (muError_t) muGrayDilate33(const muImage_t *src, muImage_t *dst, MU_8U *s
    If element pointer is NULL, 3x3 rectangular element is used */
 MU_API (muError_t) muGrayErode33(const muImage_t *src, muImage_t *dst, MU_8U *se);
 
+/* muMorphology operations */
+#define MU_MORPH_ERODE    0
+#define MU_MORPH_DILATE   1
+#define MU_MORPH_OPEN     2
+#define MU_MORPH_CLOSE    3
+#define MU_MORPH_TOPHAT   4 /* src - open */
+#define MU_MORPH_BLACKHAT 5 /* close - src */
+
+/* Morphology with a ksize rectangle of any size at a constant cost per pixel, dst may be src */
+MU_API (muError_t) muMorphology(const muImage_t *src, muImage_t *dst, MU_32S op, muSize_t ksize);
+
+/* muMorphology on packed masks, dst may be src */
+MU_API (muError_t) muBitMorphology(const muBitMask_t *src, muBitMask_t *dst, MU_32S op, muSize_t ksize);
+
 
 /********* Logic processing ***************/
 
@@ -210,6 +321,62 @@ MU_API (muError_t) muOr(const muImage_t *src1, muImage_t *src2, muImage_t *dst);
 /* Sub operation between images */
 MU_API (muError_t) muSub(const muImage_t *src1, muImage_t *src2, muImage_t *dst);
 
+/* Binary mask packed 64 pixels per word, NULL for an empty size */
+MU_API (muBitMask_t*) muCreateBitMask(muSize_t size);
+
+MU_API (muError_t) muReleaseBitMask(muBitMask_t **mask);
+
+/* Non-zero pixels of an 8U image become set bits */
+MU_API (muError_t) muPackBitMask(const muImage_t *src, muBitMask_t *dst);
+
+/* Set bits become 255, the others 0 */
+MU_API (muError_t) muUnpackBitMask(const muBitMask_t *src, muImage_t *dst);
+
+/* muAnd, muOr and muSub of two packed masks, dst may be src1 or src2 */
+MU_API (muError_t) muBitAnd(const muBitMask_t *src1, const muBitMask_t *src2, muBitMask_t *dst);
+
+MU_API (muError_t) muBitOr(const muBitMask_t *src1, const muBitMask_t *src2, muBitMask_t *dst);
+
+MU_API (muError_t) muBitSub(const muBitMask_t *src1, const muBitMask_t *src2, muBitMask_t *dst);
+
+/* Number of set pixels inside roi, or in the whole mask with roi NULL */
+MU_API (muError_t) muBitCount(const muBitMask_t *src, const muRect_t *roi, MU_32U *count);
+
+
+/********* Run-length encoded masks ***************/
+
+/* Mask kept as runs of set pixels, NULL for an empty size */
+MU_API (muRLEMask_t*) muCreateRLEMask(muSize_t size);
+
+MU_API (muError_t) muReleaseRLEMask(muRLEMask_t **mask);
+
+/* Runs of th.min < v <= th.max with v = src, or v = |src - ref| when ref is not NULL */
+MU_API (muError_t) muRLEThreshold(const muImage_t *src, const muImage_t *ref, muDoubleThreshold_t th, muRLEMask_t *dst);
+
+/* Runs become 255, the rest 0 */
+MU_API (muError_t) muDecodeRLEMask(const muRLEMask_t *src, muImage_t *dst);
+
+/* muAnd, muOr and muSub on runs, dst may be src1 or src2 */
+MU_API (muError_t) muRLEAnd(const muRLEMask_t *src1, const muRLEMask_t *src2, muRLEMask_t *dst);
+
+MU_API (muError_t) muRLEOr(const muRLEMask_t *src1, const muRLEMask_t *src2, muRLEMask_t *dst);
+
+MU_API (muError_t) muRLESub(const muRLEMask_t *src1, const muRLEMask_t *src2, muRLEMask_t *dst);
+
+MU_API (muError_t) muRLEArea(const muRLEMask_t *src, MU_32U *area);
+
+/* 0 x 0 at (0, 0) for an empty mask */
+MU_API (muError_t) muRLEBoundingRect(const muRLEMask_t *src, muRect_t *rect);
+
+/* Dilation by a ksize rectangle anchored as in muMorphology, dst may be src */
+MU_API (muError_t) muRLEDilate(const muRLEMask_t *src, muRLEMask_t *dst, muSize_t ksize);
+
+/* 4 or 8-connected components, labels 1..num for each of the src->count runs */
+MU_API (muError_t) muRLELabel(const muRLEMask_t *src, MU_32S connectivity, MU_32S *labels, MU_32S *num);
+
+/* muFindBoundingBox from the muRLELabel labels */
+MU_API (muSeq_t*) muRLEFindBoundingBox(const muRLEMask_t *src, const MU_32S *labels, MU_32S num, muDoubleThreshold_t th);
+
 
 /********* Histogram-based processing ***************/
 MU_API (muError_t) muHistogram(const muImage_t *src, MU_32U *dst);
@@ -220,6 +387,21 @@ MU_API (muError_t) muHistogramBlk(muImage_t* src, MU_16U* histBlkResult, MU_8U w
 
 MU_API (MU_16U*) muCreateHistogramBlk(MU_32S blkNumH, MU_32S blkNumV);
 
+/* Block histograms over a grid of roi, NULL for invalid parameters or 16U counters too small for a block */
+MU_API (muBlockHist_t*) muCreateBlockHist(muRect_t roi, muSize_t block, MU_32S bins, MU_32S depth);
+
+MU_API (muError_t) muReleaseBlockHist(muBlockHist_t **bh);
+
+/* Counts every block, or with a mask only the blocks holding a non-zero mask pixel */
+MU_API (muError_t) muCalcBlockHist(const muImage_t *src, const muImage_t *mask, muBlockHist_t *bh);
+
+/* Contrast-limited adaptive histogram equalization, smooth in [0, 1) blends the LUTs of successive frames */
+MU_API (muCLAHE_t*) muCreateCLAHE(muSize_t tiles, MU_64F clipLimit, MU_64F smooth);
+
+MU_API (muError_t) muReleaseCLAHE(muCLAHE_t **c);
+
+MU_API (muError_t) muCLAHE(const muImage_t *src, muImage_t *dst, muCLAHE_t *c);
+
 /******** Motion detection ********/
 MU_API (muError_t) muLKOpticalFlow(muImage_t *imageI, muImage_t *imageJ, MU_32S *vectorX, MU_32S *vectorY, MU_32S *lostTable);
 
@@ -164,6 +164,7 @@ typedef enum _muResolution
 #define MU_MAX(a,b) (a) >= (b) ? (a) : (b)
 #define MU_MIN(a,b) (a) <= (b) ? (a) : (b)
 #define MU_IMIN(a,b) ((a) ^ (((a)^(b)) & (((a) < (b)) - 1)))
+#define MU_IMAX(a,b) ((a) ^ (((a)^(b)) & (((a) > (b)) - 1)))
 
 #define MU_DBG(fmt, ...)	printf("[MULIB]"fmt,##__VA_ARGS__)
 
@@ -238,6 +239,46 @@ typedef struct _muImage
 
 }muImage_t;
 
+/********************************** Multi-plane image ***********************************/
+
+/* YUV layouts, the planes are kept in memory order */
+#define MU_YUV_I420  0 // Y, U, V planes, 2x2 subsampled chroma
+#define MU_YUV_YV12  1 // Y, V, U planes, 2x2 subsampled chroma
+#define MU_YUV_NV12  2 // Y plane, interleaved UV plane
+#define MU_YUV_NV21  3 // Y plane, interleaved VU plane
+#define MU_YUV_YUYV  4 // packed Y0 U Y1 V
+#define MU_YUV_UYVY  5 // packed U Y0 V Y1
+#define MU_YUV_I422  6 // Y, U, V planes, 2x1 subsampled chroma
+
+#define MU_MAX_PLANES 3
+
+/* Describes a frame whose planes live in separate (possibly foreign) buffers,
+   e.g. decoder or camera output. The descriptor never owns the plane data. */
+typedef struct _muPlanarImage
+{
+    MU_32S format;                /* MU_YUV_XXX */
+    MU_32S width;                 /* luma width in pixels */
+    MU_32S height;                /* luma height in pixels */
+    MU_32S planes;                /* number of planes in use */
+    MU_8U* data[MU_MAX_PLANES];   /* plane pointers */
+    MU_32S step[MU_MAX_PLANES];   /* plane strides in bytes */
+    MU_32S xsub[MU_MAX_PLANES];   /* horizontal subsampling factor of each plane */
+    MU_32S ysub[MU_MAX_PLANES];   /* vertical subsampling factor of each plane */
+
+}muPlanarImage_t;
+
+/* 3D color lookup table: (1<<bits)+1 nodes per axis, 256>>bits apart; node (i0,i1,i2) in channel
+   memory order is at table[((i2*n + i1)*n + i0)*channels] with n = (1<<bits)+1 */
+typedef MU_VOID (*muColorMapFunc_t)(const MU_8U *in, MU_8U *out, MU_VOID *userdata);
+
+typedef struct _muColorLUT
+{
+    MU_32S bits;      /* grid resolution, 1~8 */
+    MU_32S channels;  /* output values per pixel, 1 for a mask */
+    MU_8U* table;     /* grid nodes */
+
+}muColorLUT_t;
+
 /*************************************** muRect *****************************************/
 
 typedef struct _muRect
@@ -409,6 +450,16 @@ typedef struct _muBoundingBox
 
 }muBoundingBox_t;
 
+typedef struct _muComponentStat
+{
+	MU_32S label;
+	MU_32S area;
+	MU_32S minx, miny, maxx, maxy;  /* bounding box, inclusive */
+	MU_64F m10, m01;                /* sums of x and of y over the component */
+	muPoint2D64f_t centroid;        /* (m10/area, m01/area) */
+
+}muComponentStat_t;
+
 
 typedef struct _muSize
 {
@@ -463,6 +514,57 @@ typedef struct _muIntegralImg
     muSize_t imgSize;
 } muIntegralImg_t;
 
+/****mu block histogram****/
+typedef struct _muBlockHist
+{
+	muRect_t roi;    /* region split into blocks */
+	muSize_t block;  /* block size, the last column and row of blocks take the rest */
+	muSize_t grid;   /* number of blocks horizontally and vertically */
+	MU_32S bins;     /* counters per block, value v counts in bin v*bins/256 */
+	MU_32S depth;    /* MU_IMG_DEPTH_16U or MU_IMG_DEPTH_32U counters */
+	MU_VOID *data;   /* grid.width*grid.height blocks of bins counters, row by row */
+
+}muBlockHist_t;
+
+/****mu CLAHE****/
+typedef struct _muCLAHE
+{
+	muSize_t tiles;    /* tile grid */
+	MU_64F clipLimit;  /* histogram clip in multiples of the mean bin count, <= 0 for none */
+	MU_64F smooth;     /* weight of the previous LUTs in [0, 1), 0 for none */
+	muSize_t size;     /* image size of the kept LUTs */
+	MU_32F *lut;       /* LUTs of the last call, 256 per tile */
+
+}muCLAHE_t;
+
+/****mu bit mask****/
+typedef struct _muBitMask
+{
+	muSize_t size;   /* mask width and height in pixels */
+	MU_32S step;     /* 64-bit words per row */
+	MU_64U *data;    /* pixel (x, y) is bit x&63 of data[y*step + x/64], bits past the width stay 0 */
+
+}muBitMask_t;
+
+/****mu run-length encoded mask****/
+typedef struct _muRun
+{
+	MU_32S y;        /* row */
+	MU_32S start;    /* first pixel */
+	MU_32S end;      /* one past the last pixel */
+
+}muRun_t;
+
+typedef struct _muRLEMask
+{
+	muSize_t size;     /* mask width and height in pixels */
+	MU_32S count;      /* number of runs */
+	MU_32S capacity;   /* runs allocated */
+	muRun_t *runs;     /* runs row by row and left to right, runs of a row never overlap or touch */
+	MU_32S *rowStart;  /* size.height+1 entries, the runs of row y are runs[rowStart[y] .. rowStart[y+1]) */
+
+}muRLEMask_t;
+
 
 /************************************* muParameter *****************************************/
 typedef struct _muDoubleThreshold
@@ -278,6 +278,197 @@ muError_t muSetZero( muImage_t* image )
 	return MU_ERR_SUCCESS;
 }
 
+/****************************************************************************************\
+ *          Multi-plane images referring to external buffers                              *
+ \****************************************************************************************/
+
+/* bytes per sample of a plane */
+static MU_32S muPlaneElemSize(MU_32S format, MU_32S plane)
+{
+	switch(format)
+	{
+		case MU_YUV_NV12:
+		case MU_YUV_NV21:
+		return plane == 1 ? 2 : 1;
+
+		case MU_YUV_YUYV:
+		case MU_YUV_UYVY:
+		return 2;
+
+		default:
+		return 1;
+	}
+}
+
+/* Describes a YUV frame living in external buffers, a zero stride means tightly packed
+   and NULL chroma planes are taken to follow the previous plane contiguously */
+muError_t muInitPlanarImage(muPlanarImage_t *img, muSize_t size, MU_32S format,
+							MU_8U *p0, MU_32S s0, MU_8U *p1, MU_32S s1, MU_8U *p2, MU_32S s2)
+{
+	MU_8U *p[MU_MAX_PLANES];
+	MU_32S s[MU_MAX_PLANES];
+	MU_32S i, rowbytes;
+
+	if(img == NULL || p0 == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	if(size.width <= 0 || size.height <= 0)
+	{
+		return MU_ERR_INVALID_PARAMETER;
+	}
+
+	p[0] = p0; p[1] = p1; p[2] = p2;
+	s[0] = s0; s[1] = s1; s[2] = s2;
+
+	img->format = format;
+	img->width  = size.width;
+	img->height = size.height;
+	for(i=0; i<MU_MAX_PLANES; i++)
+	{
+		img->data[i] = NULL;
+		img->step[i] = 0;
+		img->xsub[i] = 1;
+		img->ysub[i] = 1;
+	}
+
+	switch(format)
+	{
+		case MU_YUV_I420:
+		case MU_YUV_YV12:
+		case MU_YUV_I422:
+		img->planes = 3;
+		img->xsub[1] = img->xsub[2] = 2;
+		img->ysub[1] = img->ysub[2] = format == MU_YUV_I422 ? 1 : 2;
+		break;
+
+		case MU_YUV_NV12:
+		case MU_YUV_NV21:
+		img->planes = 2;
+		img->xsub[1] = 2;
+		img->ysub[1] = 2;
+		break;
+
+		case MU_YUV_YUYV:
+		case MU_YUV_UYVY:
+		/* one packed plane, a macro pixel holds two luma samples */
+		img->planes = 1;
+		break;
+
+		default:
+		return MU_ERR_NOT_SUPPORT;
+	}
+
+	for(i=0; i<img->planes; i++)
+	{
+		if(img->planes == 1)
+			rowbytes = ((size.width + 1) / 2) * 4;
+		else
+			rowbytes = ((size.width + img->xsub[i] - 1) / img->xsub[i]) * muPlaneElemSize(format, i);
+
+		img->step[i] = s[i] == 0 ? rowbytes : s[i];
+		if(img->step[i] < rowbytes)
+		{
+			return MU_ERR_INVALID_PARAMETER;
+		}
+
+		if(p[i] == NULL)
+		{
+			p[i] = img->data[i-1] + img->step[i-1]*((size.height + img->ysub[i-1] - 1) / img->ysub[i-1]);
+		}
+		img->data[i] = p[i];
+	}
+
+	return MU_ERR_SUCCESS;
+}
+
+/* Fills an image header which refers to one plane in place (no copy, do not release its data).
+   muImage_t has no row stride, so only planes with step == width*channels can be referred. */
+muError_t muGetPlaneHeader(const muPlanarImage_t *src, MU_32S plane, muImage_t *dst)
+{
+	MU_32S channels;
+
+	if(src == NULL || dst == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	if(plane < 0 || plane >= src->planes)
+	{
+		return MU_ERR_INVALID_PARAMETER;
+	}
+
+	channels = muPlaneElemSize(src->format, plane);
+
+	dst->channels  = channels;
+	dst->depth     = MU_IMG_DEPTH_8U;
+	dst->dataorder = MU_IMG_DATAORDER_PIXEL;
+	dst->origin    = MU_IMG_ORIGIN_TL;
+	dst->width     = (src->width + src->xsub[plane] - 1) / src->xsub[plane];
+	dst->height    = (src->height + src->ysub[plane] - 1) / src->ysub[plane];
+	dst->roi       = 0;
+	dst->imagedata = src->data[plane];
+	dst->phyaddr   = 0;
+
+	if(src->step[plane] != dst->width*channels)
+	{
+		return MU_ERR_NOT_SUPPORT;
+	}
+
+	return MU_ERR_SUCCESS;
+}
+
+/* Get the sub frame of a multi-plane image as a view on the same buffers, the
+   rect origin has to be aligned to the chroma subsampling */
+muError_t muGetSubPlanarImage(const muPlanarImage_t *src, muPlanarImage_t *dst, const muRect_t rect)
+{
+	MU_32S i;
+
+	if(src == NULL || dst == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	if(rect.x < 0 || rect.y < 0 || rect.width <= 0 || rect.height <= 0 ||
+	   rect.x + rect.width > src->width || rect.y + rect.height > src->height)
+	{
+		return MU_ERR_INVALID_PARAMETER;
+	}
+
+	/* packed 4:2:2 can only start on a macro pixel */
+	if(src->planes == 1 && (rect.x & 1))
+	{
+		return MU_ERR_INVALID_PARAMETER;
+	}
+
+	for(i=0; i<src->planes; i++)
+	{
+		if(rect.x % src->xsub[i] || rect.y % src->ysub[i])
+		{
+			return MU_ERR_INVALID_PARAMETER;
+		}
+	}
+
+	*dst = *src;
+	dst->width  = rect.width;
+	dst->height = rect.height;
+
+	if(src->planes == 1)
+	{
+		dst->data[0] = src->data[0] + rect.y*src->step[0] + rect.x*2;
+		return MU_ERR_SUCCESS;
+	}
+
+	for(i=0; i<src->planes; i++)
+	{
+		dst->data[i] = src->data[i] + (rect.y / src->ysub[i])*src->step[i] +
+					   (rect.x / src->xsub[i])*muPlaneElemSize(src->format, i);
+	}
+
+	return MU_ERR_SUCCESS;
+}
+
 /****************************************************************************************\
  *          Dynamic Structure setting, create, insert, delete                             *
  \****************************************************************************************/
@@ -0,0 +1,443 @@
+/*
+% MIT License
+%
+% Copyright (c) 2016 OneCV
+%
+% Permission is hereby granted, free of charge, to any person obtaining a copy
+% of this software and associated documentation files (the "Software"), to deal
+% in the Software without restriction, including without limitation the rights
+% to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+% copies of the Software, and to permit persons to whom the Software is
+% furnished to do so, subject to the following conditions:
+%
+% The above copyright notice and this permission notice shall be included in all
+% copies or substantial portions of the Software.
+%
+% THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+% IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+% FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+% AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+% LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+% OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+% SOFTWARE.
+*/
+
+/* ------------------------------------------------------------------------- /
+ *
+ * Module: muColorLUT.c
+ * Author: OneCV
+ *
+ * Description:
+ *  This file is presented the 3D color lookup tables. A per-pixel color
+ *  predicate or mapping is sampled once on a regular grid and applied to
+ *  images by direct indexing or trilinear interpolation.
+ *
+ -------------------------------------------------------------------------- */
+
+/* MU include files */
+#include "muCore.h"
+
+#define MU_LUT_MAGIC   0x54554C4D   // "MLUT"
+#define MU_LUT_VERSION 1
+
+/* color value of grid node i, the last node (256) is sampled at 255, so the last cell is one
+   value narrower than the others */
+static MU_32S muLUTNodeValue(MU_32S i, MU_32S shift)
+{
+	MU_32S v = i << shift;
+
+	return v > 255 ? 255 : v;
+}
+
+static muColorLUT_t* muAllocColorLUT(MU_32S bits, MU_32S channels)
+{
+	muColorLUT_t *lut;
+	MU_32S n;
+
+	if(bits < 1 || bits > 8 || channels < 1 || channels > 4)
+	{
+		MU_DBG("muCreateColorLUT bits must be 1~8 and channels 1~4\n");
+		return NULL;
+	}
+
+	lut = (muColorLUT_t *)malloc(sizeof(muColorLUT_t));
+	if(lut == NULL)
+	{
+		return NULL;
+	}
+
+	n = (1 << bits) + 1;
+	lut->bits = bits;
+	lut->channels = channels;
+	lut->table = (MU_8U *)malloc(n*n*n*channels);
+	if(lut->table == NULL)
+	{
+		free(lut);
+		return NULL;
+	}
+
+	return lut;
+}
+
+/*===========================================================================================*/
+/*   muCreateColorLUT                                                                        */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine compiles a per-pixel color function into a 3D lookup table.                */
+/*                                                                                           */
+/*   NOTE                                                                                    */
+/*   The grid has (1<<bits)+1 nodes per axis with a step of 256>>bits, e.g. bits = 5 gives   */
+/*   33x33x33 nodes. func is called once per node with the 3 channel values in memory order */
+/*   (b, g, r for the BGR images of this library) and writes channels output values.         */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   MU_32S bits --> grid resolution, 1~8                                                    */
+/*   MU_32S channels --> output values per pixel, 1 for a mask, up to 4                      */
+/*   muColorMapFunc_t func --> the predicate or mapping                                      */
+/*   MU_VOID *userdata --> passed to func                                                    */
+/*===========================================================================================*/
+muColorLUT_t* muCreateColorLUT(MU_32S bits, MU_32S channels, muColorMapFunc_t func, MU_VOID *userdata)
+{
+	muColorLUT_t *lut;
+	MU_32S n, shift, i2;
+
+	if(func == NULL)
+	{
+		return NULL;
+	}
+
+	lut = muAllocColorLUT(bits, channels);
+	if(lut == NULL)
+	{
+		return NULL;
+	}
+
+	n = (1 << bits) + 1;
+	shift = 8 - bits;
+
+#pragma omp parallel for
+	for(i2=0; i2<n; i2++)
+	{
+		MU_32S i0, i1;
+		MU_8U c[3];
+		MU_8U *node;
+
+		c[2] = (MU_8U)muLUTNodeValue(i2, shift);
+		for(i1=0; i1<n; i1++)
+		{
+			c[1] = (MU_8U)muLUTNodeValue(i1, shift);
+			node = lut->table + (i2*n + i1)*n*channels;
+			for(i0=0; i0<n; i0++, node+=channels)
+			{
+				c[0] = (MU_8U)muLUTNodeValue(i0, shift);
+				func(c, node, userdata);
+			}
+		}
+	}
+
+	return lut;
+}
+
+/*===========================================================================================*/
+/*   muCreateHSVRangeLUT                                                                     */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine compiles "pixel is within this HSV range" into a 1 channel mask LUT (255   */
+/*   inside, 0 outside).                                                                     */
+/*                                                                                           */
+/*   NOTE                                                                                    */
+/*   The ranges are inclusive and follow muRGB2HSV (h 0~360, s 0~100, v 0~100); the grid     */
+/*   nodes go through muRGB2HSV itself. hmin > hmax selects a range wrapping through 0,      */
+/*   e.g. 340~20 for red. Every node goes through the HSV test, so bits stops at 6: 65x65x65 */
+/*   nodes, a 275 KB mask, where 8 would take 257^3 nodes (17 MB).                           */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   MU_32S bits --> grid resolution, 1~6 (5 gives the usual 33x33x33 nodes)                 */
+/*===========================================================================================*/
+muColorLUT_t* muCreateHSVRangeLUT(MU_32S bits, MU_32S hmin, MU_32S hmax, MU_32S smin, MU_32S smax,
+								  MU_32S vmin, MU_32S vmax)
+{
+	muColorLUT_t *lut;
+	muImage_t *grid, *hsv;
+	MU_32S n, shift, i, total, h, s, v, inh;
+	MU_16U *p;
+
+	if(bits < 1 || bits > 6)
+	{
+		MU_DBG("muCreateHSVRangeLUT bits must be 1~6\n");
+		return NULL;
+	}
+
+	lut = muAllocColorLUT(bits, 1);
+	if(lut == NULL)
+	{
+		return NULL;
+	}
+
+	n = (1 << bits) + 1;
+	shift = 8 - bits;
+	total = n*n*n;
+
+	grid = muCreateImage(muSize(n, n*n), MU_IMG_DEPTH_8U, 3);
+	hsv = muCreateImage(muSize(n, n*n), MU_IMG_DEPTH_16U, 3);
+	if(grid == NULL || hsv == NULL || grid->imagedata == NULL || hsv->imagedata == NULL)
+	{
+		if(grid)
+			muReleaseImage(&grid);
+		if(hsv)
+			muReleaseImage(&hsv);
+		muReleaseColorLUT(&lut);
+		return NULL;
+	}
+
+	for(i=0; i<total; i++)
+	{
+		grid->imagedata[i*3]   = (MU_8U)muLUTNodeValue(i % n, shift);
+		grid->imagedata[i*3+1] = (MU_8U)muLUTNodeValue((i / n) % n, shift);
+		grid->imagedata[i*3+2] = (MU_8U)muLUTNodeValue(i / (n*n), shift);
+	}
+
+	muRGB2HSV(grid, hsv);
+
+	p = (MU_16U *)hsv->imagedata;
+	for(i=0; i<total; i++)
+	{
+		h = p[i*3]; s = p[i*3+1]; v = p[i*3+2];
+		if(hmin <= hmax)
+			inh = h >= hmin && h <= hmax;
+		else
+			inh = h >= hmin || h <= hmax;
+		lut->table[i] = (inh && s >= smin && s <= smax && v >= vmin && v <= vmax) ? 255 : 0;
+	}
+
+	muReleaseImage(&grid);
+	muReleaseImage(&hsv);
+
+	return lut;
+}
+
+/* Releases a color LUT */
+muError_t muReleaseColorLUT(muColorLUT_t **lut)
+{
+	if(lut == NULL || *lut == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	free((*lut)->table);
+	free(*lut);
+	*lut = NULL;
+
+	return MU_ERR_SUCCESS;
+}
+
+/*===========================================================================================*/
+/*   muApplyColorLUT                                                                         */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine maps every pixel of a 3 channel image through a 3D LUT into a mask or a    */
+/*   mapped image with lut->channels channels.                                               */
+/*                                                                                           */
+/*   NOTE                                                                                    */
+/*   MU_INTER_NN uses the nearest grid node; the node offset of every channel value is       */
+/*   tabulated, so a pixel costs three small table reads and one node fetch. MU_INTER_LINEAR */
+/*   blends the 8 surrounding nodes in fixed point; on a mask this gives a soft 0~255 value. */
+/*   The last node of an axis holds value 255, so 255 maps exactly onto func(255).           */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muImage_t *src --> 3 channel 8U image                                                   */
+/*   muImage_t *dst --> 8U image with lut->channels channels                                 */
+/*   muColorLUT_t *lut --> compiled table                                                    */
+/*   MU_32S interpolation --> MU_INTER_NN or MU_INTER_LINEAR                                 */
+/*===========================================================================================*/
+muError_t muApplyColorLUT(const muImage_t *src, muImage_t *dst, const muColorLUT_t *lut, MU_32S interpolation)
+{
+	MU_32S ofs[3][256];
+	MU_16U frac[256];
+	MU_32S n, cn, shift, step, half, i, j, total;
+	const MU_8U *in;
+	MU_8U *out;
+	const MU_8U *tab;
+	muError_t ret;
+
+	if(lut == NULL || lut->table == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	ret = muCheckDepth(4, src, MU_IMG_DEPTH_8U, dst, MU_IMG_DEPTH_8U);
+	if(ret)
+	{
+		return ret;
+	}
+
+	if(src->channels != 3 || dst->channels != lut->channels ||
+	   src->width != dst->width || src->height != dst->height)
+	{
+		return MU_ERR_NOT_SUPPORT;
+	}
+
+	if(interpolation != MU_INTER_NN && interpolation != MU_INTER_LINEAR)
+	{
+		return MU_ERR_NOT_SUPPORT;
+	}
+
+	n = (1 << lut->bits) + 1;
+	cn = lut->channels;
+	shift = 8 - lut->bits;
+	step = 1 << shift;
+	half = interpolation == MU_INTER_NN ? step >> 1 : 0;
+	for(i=0; i<256; i++)
+	{
+		ofs[0][i] = ((i + half) >> shift)*cn;
+		ofs[1][i] = ((i + half) >> shift)*n*cn;
+		ofs[2][i] = ((i + half) >> shift)*n*n*cn;
+		/* Q8 position between node i>>shift and the next one, which is at 255 for the last cell */
+		if(i < 256 - step)
+			frac[i] = (MU_16U)((i & (step - 1)) << lut->bits);
+		else
+			frac[i] = (MU_16U)(step > 1 ? ((i - (256 - step))*256 + (step - 1)/2)/(step - 1) : 0);
+	}
+
+	total = src->width*src->height;
+	in = src->imagedata;
+	out = dst->imagedata;
+	tab = lut->table;
+
+	if(interpolation == MU_INTER_NN)
+	{
+		if(cn == 1)
+		{
+#pragma omp parallel for
+			for(i=0; i<total; i++)
+			{
+				out[i] = tab[ofs[0][in[i*3]] + ofs[1][in[i*3+1]] + ofs[2][in[i*3+2]]];
+			}
+		}
+		else
+		{
+#pragma omp parallel for private(j)
+			for(i=0; i<total; i++)
+			{
+				const MU_8U *node = tab + ofs[0][in[i*3]] + ofs[1][in[i*3+1]] + ofs[2][in[i*3+2]];
+				for(j=0; j<cn; j++)
+					out[i*cn+j] = node[j];
+			}
+		}
+		return MU_ERR_SUCCESS;
+	}
+
+#pragma omp parallel for private(j)
+	for(i=0; i<total; i++)
+	{
+		const MU_8U *p;
+		MU_32S f0, f1, f2, s0, s1, s2;
+		MU_32S c00, c01, c10, c11, c0, c1;
+
+		p  = tab + ofs[0][in[i*3]] + ofs[1][in[i*3+1]] + ofs[2][in[i*3+2]];
+		f0 = frac[in[i*3]];
+		f1 = frac[in[i*3+1]];
+		f2 = frac[in[i*3+2]];
+		s0 = cn;
+		s1 = n*cn;
+		s2 = n*n*cn;
+
+		for(j=0; j<cn; j++, p++)
+		{
+			/* Q8 lerps along channel 0, then 1, then 2 */
+			c00 = (p[0] << 8)       + (p[s0] - p[0])*f0;
+			c01 = (p[s1] << 8)      + (p[s1+s0] - p[s1])*f0;
+			c10 = (p[s2] << 8)      + (p[s2+s0] - p[s2])*f0;
+			c11 = (p[s2+s1] << 8)   + (p[s2+s1+s0] - p[s2+s1])*f0;
+			c0  = (c00 << 8) + (c01 - c00)*f1;
+			c1  = (c10 << 8) + (c11 - c10)*f1;
+			out[i*cn+j] = (MU_8U)((((MU_64S)c0 << 8) + (MU_64S)(c1 - c0)*f2 + (1 << 23)) >> 24);
+		}
+	}
+
+	return MU_ERR_SUCCESS;
+}
+
+/*===========================================================================================*/
+/*   muSaveColorLUT / muLoadColorLUT                                                         */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   Cache a compiled LUT on disk: magic, version, bits, channels, then the node table.      */
+/*===========================================================================================*/
+muError_t muSaveColorLUT(const char *filename, const muColorLUT_t *lut)
+{
+	FILE *fp;
+	MU_32S head[4];
+	MU_32S n, size;
+
+	if(filename == NULL || lut == NULL || lut->table == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	fp = fopen(filename, "wb");
+	if(fp == NULL)
+	{
+		MU_DBG("muSaveColorLUT can't open %s\n", filename);
+		return MU_ERR_INVALID_PARAMETER;
+	}
+
+	n = (1 << lut->bits) + 1;
+	size = n*n*n*lut->channels;
+	head[0] = MU_LUT_MAGIC;
+	head[1] = MU_LUT_VERSION;
+	head[2] = lut->bits;
+	head[3] = lut->channels;
+
+	if(fwrite(head, sizeof(MU_32S), 4, fp) != 4 || fwrite(lut->table, 1, size, fp) != (size_t)size)
+	{
+		fclose(fp);
+		return MU_ERR_UNKNOWN;
+	}
+
+	fclose(fp);
+
+	return MU_ERR_SUCCESS;
+}
+
+muColorLUT_t* muLoadColorLUT(const char *filename)
+{
+	FILE *fp;
+	MU_32S head[4];
+	MU_32S n, size;
+	muColorLUT_t *lut = NULL;
+
+	if(filename == NULL)
+	{
+		return NULL;
+	}
+
+	fp = fopen(filename, "rb");
+	if(fp == NULL)
+	{
+		MU_DBG("muLoadColorLUT can't open %s\n", filename);
+		return NULL;
+	}
+
+	if(fread(head, sizeof(MU_32S), 4, fp) == 4 && head[0] == MU_LUT_MAGIC && head[1] == MU_LUT_VERSION)
+	{
+		lut = muAllocColorLUT(head[2], head[3]);
+		if(lut)
+		{
+			n = (1 << lut->bits) + 1;
+			size = n*n*n*lut->channels;
+			if(fread(lut->table, 1, size, fp) != (size_t)size)
+			{
+				muReleaseColorLUT(&lut);
+			}
+		}
+	}
+	else
+	{
+		MU_DBG("muLoadColorLUT %s is not a color LUT\n", filename);
+	}
+
+	fclose(fp);
+
+	return lut;
+}
@@ -35,6 +35,10 @@
 /* MU include files */
 #include "muCore.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 /*===========================================================================================*/
 /*   muContraststretch                                                                       */
 /*                                                                                           */
@@ -190,115 +194,474 @@ static muError_t muYUV422p2sp(muImage_t *src)
 }
 
 /*===========================================================================================*/
-/*   muYUV420toRGB                                                                          */
+/*   YUV to RGB kernels                                                                      */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   The chroma terms are computed in Q8 fixed point,                                        */
+/*     rdif = (v*359)>>8, gdif = ((u*88)>>8)+((v*183)>>8), bdif = (u*454)>>8                */
+/*   which is bit exact with the original v + ((v*103)>>8) style expressions. With SSE2      */
+/*   16 pixels are converted per step, the chroma terms of one chroma row are computed once  */
+/*   and applied to both luma rows sharing it. The scalar path handles tails and other CPUs. */
+/*===========================================================================================*/
+
+#define MU_YUV_RV  359
+#define MU_YUV_GU  88
+#define MU_YUV_GV  183
+#define MU_YUV_BU  454
+
+MU_INLINE MU_8U muClampU8(MU_32S x)
+{
+	x &= ~(x >> 31);
+	return (MU_8U)((x | ((255 - x) >> 31)) & 255);
+}
+
+MU_INLINE void muYUVPixel(MU_32S y, MU_32S rdif, MU_32S gdif, MU_32S bdif, MU_8U *dst, MU_32S pixformat)
+{
+	MU_8U r, g, b;
+
+	r = muClampU8(y + rdif);
+	g = muClampU8(y - gdif);
+	b = muClampU8(y + bdif);
+
+	if(pixformat == MU_PIX_BGR)
+	{
+		dst[0] = b; dst[1] = g; dst[2] = r;
+	}
+	else
+	{
+		dst[0] = r; dst[1] = g; dst[2] = b;
+		if(pixformat == MU_PIX_RGBA)
+			dst[3] = 255;
+	}
+}
+
+#if defined(__SSE2__)
+static void muYUVBlock16(const MU_8U *y, __m128i rd, __m128i gd, __m128i bd, MU_8U *dst, MU_32S pixformat)
+{
+	MU_8U tr[16], tg[16], tb[16];
+	const __m128i zero = _mm_setzero_si128();
+	__m128i yv, ylo, yhi, r, g, b, rg, ba;
+	MU_32S i;
+
+	yv  = _mm_loadu_si128((const __m128i *)y);
+	ylo = _mm_unpacklo_epi8(yv, zero);
+	yhi = _mm_unpackhi_epi8(yv, zero);
+
+	r = _mm_packus_epi16(_mm_add_epi16(ylo, _mm_unpacklo_epi16(rd, rd)), _mm_add_epi16(yhi, _mm_unpackhi_epi16(rd, rd)));
+	g = _mm_packus_epi16(_mm_sub_epi16(ylo, _mm_unpacklo_epi16(gd, gd)), _mm_sub_epi16(yhi, _mm_unpackhi_epi16(gd, gd)));
+	b = _mm_packus_epi16(_mm_add_epi16(ylo, _mm_unpacklo_epi16(bd, bd)), _mm_add_epi16(yhi, _mm_unpackhi_epi16(bd, bd)));
+
+	if(pixformat == MU_PIX_RGBA)
+	{
+		const __m128i alpha = _mm_set1_epi8(-1);
+
+		rg = _mm_unpacklo_epi8(r, g);
+		ba = _mm_unpacklo_epi8(b, alpha);
+		_mm_storeu_si128((__m128i *)(dst), _mm_unpacklo_epi16(rg, ba));
+		_mm_storeu_si128((__m128i *)(dst + 16), _mm_unpackhi_epi16(rg, ba));
+		rg = _mm_unpackhi_epi8(r, g);
+		ba = _mm_unpackhi_epi8(b, alpha);
+		_mm_storeu_si128((__m128i *)(dst + 32), _mm_unpacklo_epi16(rg, ba));
+		_mm_storeu_si128((__m128i *)(dst + 48), _mm_unpackhi_epi16(rg, ba));
+		return;
+	}
+
+	/* SSE2 has no byte shuffle, the 3 channel interleave is done from registers spilled to the stack */
+	if(pixformat == MU_PIX_BGR)
+	{
+		_mm_storeu_si128((__m128i *)tr, b);
+		_mm_storeu_si128((__m128i *)tb, r);
+	}
+	else
+	{
+		_mm_storeu_si128((__m128i *)tr, r);
+		_mm_storeu_si128((__m128i *)tb, b);
+	}
+	_mm_storeu_si128((__m128i *)tg, g);
+
+	for(i=0; i<16; i++)
+	{
+		dst[0] = tr[i];
+		dst[1] = tg[i];
+		dst[2] = tb[i];
+		dst += 3;
+	}
+}
+#endif
+
+/*  Converts one chroma row and the one or two luma rows sharing it. cstep is 1 for planar
+    chroma and 2 for interleaved chroma. y1/d1 are NULL when only one luma row is present. */
+static void muYUVRowPairtoRGB(const MU_8U *y0, const MU_8U *y1, const MU_8U *u, const MU_8U *v, MU_32S cstep,
+							  MU_8U *d0, MU_8U *d1, MU_32S width, MU_32S pixformat)
+{
+	MU_32S i, k, cn;
+	MU_32S uu, vv, rdif, gdif, bdif;
+
+	cn = pixformat == MU_PIX_RGBA ? 4 : 3;
+	i = 0;
+
+#if defined(__SSE2__)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i bias = _mm_set1_epi16(128);
+		const __m128i mask = _mm_set1_epi16(0x00ff);
+		const __m128i crv = _mm_set1_epi16(MU_YUV_RV*2);
+		const __m128i cgu = _mm_set1_epi16(MU_YUV_GU*2);
+		const __m128i cgv = _mm_set1_epi16(MU_YUV_GV*2);
+		const __m128i cbu = _mm_set1_epi16(MU_YUV_BU*2);
+		__m128i cu, cv, t, rd, gd, bd;
+
+		for(; i+16<=width; i+=16)
+		{
+			if(cstep == 1)
+			{
+				cu = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(u + (i>>1))), zero);
+				cv = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(v + (i>>1))), zero);
+			}
+			else if(u < v)
+			{
+				t  = _mm_loadu_si128((const __m128i *)(u + i));
+				cu = _mm_and_si128(t, mask);
+				cv = _mm_srli_epi16(t, 8);
+			}
+			else
+			{
+				t  = _mm_loadu_si128((const __m128i *)(v + i));
+				cv = _mm_and_si128(t, mask);
+				cu = _mm_srli_epi16(t, 8);
+			}
+
+			/* (c-128)<<7 times 2*coef, the high half is (c-128)*coef>>8 */
+			cu = _mm_slli_epi16(_mm_sub_epi16(cu, bias), 7);
+			cv = _mm_slli_epi16(_mm_sub_epi16(cv, bias), 7);
+			rd = _mm_mulhi_epi16(cv, crv);
+			gd = _mm_add_epi16(_mm_mulhi_epi16(cu, cgu), _mm_mulhi_epi16(cv, cgv));
+			bd = _mm_mulhi_epi16(cu, cbu);
+
+			muYUVBlock16(y0 + i, rd, gd, bd, d0 + i*cn, pixformat);
+			if(y1)
+				muYUVBlock16(y1 + i, rd, gd, bd, d1 + i*cn, pixformat);
+		}
+	}
+#endif
+
+	for(; i<width; i+=2)
+	{
+		k  = (i>>1)*cstep;
+		uu = u[k] - 128;
+		vv = v[k] - 128;
+		rdif = (vv*MU_YUV_RV) >> 8;
+		gdif = ((uu*MU_YUV_GU) >> 8) + ((vv*MU_YUV_GV) >> 8);
+		bdif = (uu*MU_YUV_BU) >> 8;
+
+		muYUVPixel(y0[i], rdif, gdif, bdif, d0 + i*cn, pixformat);
+		if(i+1 < width)
+			muYUVPixel(y0[i+1], rdif, gdif, bdif, d0 + (i+1)*cn, pixformat);
+		if(y1)
+		{
+			muYUVPixel(y1[i], rdif, gdif, bdif, d1 + i*cn, pixformat);
+			if(i+1 < width)
+				muYUVPixel(y1[i+1], rdif, gdif, bdif, d1 + (i+1)*cn, pixformat);
+		}
+	}
+}
+
+/*  Splits a packed YUYV (yfirst = 1) or UYVY (yfirst = 0) row into a luma row and an
+    interleaved chroma row laid out like NV12. cbuf may be NULL when only luma is needed. */
+static void muUnpackYUV422Row(const MU_8U *src, MU_32S width, MU_32S yfirst, MU_8U *ybuf, MU_8U *cbuf)
+{
+	MU_32S i;
+	MU_32S yo, co;
+
+	yo = yfirst ? 0 : 1;
+	co = 1 - yo;
+	i = 0;
+
+#if defined(__SSE2__)
+	{
+		const __m128i mask = _mm_set1_epi16(0x00ff);
+		__m128i t0, t1, ly, lc;
+
+		for(; i+16<=width; i+=16)
+		{
+			t0 = _mm_loadu_si128((const __m128i *)(src + i*2));
+			t1 = _mm_loadu_si128((const __m128i *)(src + i*2 + 16));
+			if(yfirst)
+			{
+				ly = _mm_packus_epi16(_mm_and_si128(t0, mask), _mm_and_si128(t1, mask));
+				lc = _mm_packus_epi16(_mm_srli_epi16(t0, 8), _mm_srli_epi16(t1, 8));
+			}
+			else
+			{
+				lc = _mm_packus_epi16(_mm_and_si128(t0, mask), _mm_and_si128(t1, mask));
+				ly = _mm_packus_epi16(_mm_srli_epi16(t0, 8), _mm_srli_epi16(t1, 8));
+			}
+			_mm_storeu_si128((__m128i *)(ybuf + i), ly);
+			if(cbuf)
+				_mm_storeu_si128((__m128i *)(cbuf + i), lc);
+		}
+	}
+#endif
+
+	for(; i<width; i++)
+	{
+		ybuf[i] = src[i*2 + yo];
+		if(cbuf)
+			cbuf[i] = src[i*2 + co];
+	}
+	/* odd width: the last macro pixel still carries a V sample */
+	if(cbuf && (width & 1))
+		cbuf[width] = src[width*2 + co];
+}
+
+/*===========================================================================================*/
+/*   muYUVtoRGB                                                                              */
 /*                                                                                           */
 /*   DESCRIPTION:                                                                            */
+/*   This routine converts a YUV frame given by explicit plane pointers and strides into     */
+/*   an interleaved RGB, BGR, RGBA or gray image. The output size is taken from dst.         */
 /*                                                                                           */
 /*   NOTE                                                                                    */
-/*   This routine would be modified the original data.                                       */
+/*   The planes are given in memory order:                                                   */
+/*     MU_YUV_I420/I422 -> Y, U, V       MU_YUV_YV12 -> Y, V, U                              */
+/*     MU_YUV_NV12/NV21 -> Y, UV/VU      MU_YUV_YUYV/UYVY -> packed plane only               */
+/*   Unused plane pointers may be NULL. Odd sizes are handled, the last chroma sample covers */
+/*   the last column/row.                                                                    */
 /*                                                                                           */
 /*   USAGE                                                                                   */
-/*   muImage_t *src --> input image                                                           */
+/*   const MU_8U *p0, *p1, *p2 --> plane pointers                                            */
+/*   MU_32S s0, s1, s2 --> plane strides in bytes                                            */
+/*   MU_32S yuvformat --> MU_YUV_XXX                                                         */
+/*   muImage_t *dst --> output image, 3 channels for RGB/BGR, 4 for RGBA, 1 for gray         */
+/*   MU_32S pixformat --> MU_PIX_RGB, MU_PIX_BGR, MU_PIX_RGBA or MU_PIX_GRAY                 */
 /*===========================================================================================*/
-muError_t muYUV420toRGB(const muImage_t *src, muImage_t *dst)
+muError_t muYUVtoRGB(const MU_8U *p0, MU_32S s0, const MU_8U *p1, MU_32S s1, const MU_8U *p2, MU_32S s2,
+					 MU_32S yuvformat, muImage_t *dst, MU_32S pixformat)
 {
-	MU_8U *data;
-	MU_32S u,v;
-	MU_32S i,j,k;
-	MU_32S rdif,gdif,bdif;
-	MU_32S r,g,b;
-	MU_32S width, height, channels;
-	muSepImage_t ssrc;
+	const MU_8U *u, *v;
+	MU_32S width, height, cwidth, cn, cstep, us, vs;
+	MU_32S j, packed, subv;
 	muError_t ret;
 
-	ret = muCheckDepth(4, src, MU_IMG_DEPTH_8U, dst, MU_IMG_DEPTH_8U);
+	if(dst == NULL || dst->imagedata == NULL || p0 == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	ret = muCheckDepth(2, dst, MU_IMG_DEPTH_8U);
 	if(ret)
 	{
 		return ret;
 	}
 
-	if(src->channels != 3 || dst->channels != 3)
+	switch(pixformat)
+	{
+		case MU_PIX_RGB:
+		case MU_PIX_BGR:
+		cn = 3;
+		break;
+
+		case MU_PIX_RGBA:
+		cn = 4;
+		break;
+
+		case MU_PIX_GRAY:
+		cn = 1;
+		break;
+
+		default:
+		return MU_ERR_NOT_SUPPORT;
+	}
+
+	if(dst->channels != cn)
 	{
 		return MU_ERR_NOT_SUPPORT;
 	}
 
-	channels = dst->channels;
+	width = dst->width;
+	height = dst->height;
+	cwidth = (width + 1) / 2;
+	packed = 0;
+	subv = 1;
+	cstep = 1;
+	u = v = NULL;
+	us = vs = 0;
+
+	switch(yuvformat)
+	{
+		case MU_YUV_I420:
+		case MU_YUV_I422:
+		u = p1;
+		v = p2;
+		us = s1;
+		vs = s2;
+		subv = yuvformat == MU_YUV_I420;
+		break;
 
-	ssrc.width = src->width;
-	ssrc.height = src->height; 
+		case MU_YUV_YV12:
+		u = p2;
+		v = p1;
+		us = s2;
+		vs = s1;
+		break;
 
-	width = src->width;
-	height = src->height;
+		case MU_YUV_NV12:
+		u = p1;
+		v = p1 ? p1 + 1 : NULL;
+		us = vs = s1;
+		cstep = 2;
+		break;
 
-	muSeparateChannel(src, &ssrc, 3);
-	
-	data = dst->imagedata;
+		case MU_YUV_NV21:
+		u = p1 ? p1 + 1 : NULL;
+		v = p1;
+		us = vs = s1;
+		cstep = 2;
+		break;
 
-	k=0;
-	for(j=0; j<height; j++)
-		for(i=0; i<width; i++)
+		case MU_YUV_YUYV:
+		case MU_YUV_UYVY:
+		packed = 1;
+		subv = 0;
+		break;
+
+		default:
+		return MU_ERR_NOT_SUPPORT;
+	}
+
+	if(packed)
+	{
+		if(s0 < cwidth*4)
 		{
+			return MU_ERR_INVALID_PARAMETER;
+		}
+	}
+	else
+	{
+		if(s0 < width)
+		{
+			return MU_ERR_INVALID_PARAMETER;
+		}
+		if(pixformat != MU_PIX_GRAY)
+		{
+			if(u == NULL || v == NULL)
+			{
+				return MU_ERR_NULL_POINTER;
+			}
+			if(us < cwidth*cstep || vs < cwidth*cstep)
+			{
+				return MU_ERR_INVALID_PARAMETER;
+			}
+		}
+	}
+
+	/* gray is the luma plane itself */
+	if(pixformat == MU_PIX_GRAY)
+	{
+		for(j=0; j<height; j++)
+		{
+			if(packed)
+				muUnpackYUV422Row(p0 + j*s0, width, yuvformat == MU_YUV_YUYV, dst->imagedata + j*width, NULL);
+			else
+				memcpy(dst->imagedata + j*width, p0 + j*s0, width);
+		}
+		return MU_ERR_SUCCESS;
+	}
+
+	if(packed)
+	{
+#pragma omp parallel private(j)
+		{
+			MU_8U *ybuf, *cbuf;
+
+			ybuf = (MU_8U *)malloc(width + 16);
+			cbuf = (MU_8U *)malloc(width + 16);
+
+#pragma omp for
+			for(j=0; j<height; j++)
+			{
+				if(ybuf && cbuf)
+				{
+					muUnpackYUV422Row(p0 + j*s0, width, yuvformat == MU_YUV_YUYV, ybuf, cbuf);
+					muYUVRowPairtoRGB(ybuf, NULL, cbuf, cbuf + 1, 2, dst->imagedata + j*width*cn, NULL, width, pixformat);
+				}
+			}
+
+			if(ybuf)
+				free(ybuf);
+			if(cbuf)
+				free(cbuf);
+		}
+		return MU_ERR_SUCCESS;
+	}
 
-			u = ssrc.chb[(j/2)*(width/2)+(i/2)]-128;
-			v = ssrc.chc[(j/2)*(width/2)+(i/2)]-128;
-
-			rdif = v + ((v*103) >> 8);
-			gdif = ((u*88)>>8)+((v*183)>>8);
-			bdif = u+((u*198)>>8);
-
-
-			r = ssrc.cha[i+width*j] + rdif;
-			//r = ssrc.cha[i] + 1.4075*(ssrc.chc[j]-128);
-			if(r > 255)
-				r=255;
-			if(r < 0)
-				r=0;
-
-			g = ssrc.cha[i+width*j] - gdif;
-			//g = ssrc.cha[i] - 0.3455*(ssrc.chb[j]-128) - (ssrc.chc[j]-128);
-			if(g > 255)
-				g = 255;
-			if(g < 0)
-				g = 0;
-
-			b = ssrc.cha[i+width*j] + bdif;
-			//b = ssrc.cha[i] + 1.7790*(ssrc.chb[j]-128);
-			if(b > 255)
-				b = 255;
-			if(b < 0)
-				b = 0;
-
-			//printf("r = %d g= %d b = %d\n", r, g, b);
-
-			data[k*3] = b;
-			data[k*3+1] = g;
-			data[k*3+2] = r;
-			k++;
+	if(!subv)
+	{
+#pragma omp parallel for
+		for(j=0; j<height; j++)
+		{
+			muYUVRowPairtoRGB(p0 + j*s0, NULL, u + j*us, v + j*vs, cstep,
+							  dst->imagedata + j*width*cn, NULL, width, pixformat);
 		}
+		return MU_ERR_SUCCESS;
+	}
+
+	/* 4:2:0, two luma rows per chroma row */
+#pragma omp parallel for
+	for(j=0; j<height; j+=2)
+	{
+		muYUVRowPairtoRGB(p0 + j*s0, j+1 < height ? p0 + (j+1)*s0 : NULL,
+						  u + (j>>1)*us, v + (j>>1)*vs, cstep,
+						  dst->imagedata + j*width*cn, j+1 < height ? dst->imagedata + (j+1)*width*cn : NULL,
+						  width, pixformat);
+	}
 
 	return MU_ERR_SUCCESS;
+}
+
+/*===========================================================================================*/
+/*   muPlanarImagetoRGB                                                                      */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine converts a multi-plane YUV frame to RGB, BGR, RGBA or gray. The planes are */
+/*   read in place, so decoder buffers do not have to be repacked first.                     */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   const muPlanarImage_t *src --> input frame, see muInitPlanarImage                       */
+/*   muImage_t *dst --> output image of the same size                                        */
+/*   MU_32S pixformat --> MU_PIX_RGB, MU_PIX_BGR, MU_PIX_RGBA or MU_PIX_GRAY                 */
+/*===========================================================================================*/
+muError_t muPlanarImagetoRGB(const muPlanarImage_t *src, muImage_t *dst, MU_32S pixformat)
+{
+	if(src == NULL || dst == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
 
+	if(src->width != dst->width || src->height != dst->height)
+	{
+		return MU_ERR_INVALID_PARAMETER;
+	}
+
+	return muYUVtoRGB(src->data[0], src->step[0], src->data[1], src->step[1], src->data[2], src->step[2],
+					  src->format, dst, pixformat);
 }
 
 /*===========================================================================================*/
-/*   muYUV422toRGB                                                                          */
+/*   muYUV420toRGB                                                                          */
 /*                                                                                           */
 /*   DESCRIPTION:                                                                            */
+/*   Converts a yuv420 planar image (Y, U, V planes packed in a 3 channel buffer) to BGR.    */
 /*                                                                                           */
 /*   NOTE                                                                                    */
-/*   This routine would be modified the original data.                                       */
+/*   This is a wrapper of muYUVtoRGB, use it directly for other layouts.                     */
 /*                                                                                           */
 /*   USAGE                                                                                   */
 /*   muImage_t *src --> input image                                                           */
 /*===========================================================================================*/
-muError_t muYUV422toRGB(const muImage_t *src, muImage_t *dst)
+muError_t muYUV420toRGB(const muImage_t *src, muImage_t *dst)
 {
-	MU_8U *data;
-	MU_32S u,v;
-	MU_32S i,j;
-	MU_32S rdif,gdif,bdif;
-	MU_32S r,g,b;
-	MU_32S width, height, channels;
+	MU_32S width, cwidth;
 	muSepImage_t ssrc;
 	muError_t ret;
 
@@ -313,60 +676,49 @@ muError_t muYUV422toRGB(const muImage_t *src, muImage_t *dst)
 		return MU_ERR_NOT_SUPPORT;
 	}
 
-	channels = dst->channels;
-
-	ssrc.width = src->width;
-	ssrc.height = src->height; 
-
 	width = src->width;
-	height = src->height;
-
-	muSeparateChannel(src, &ssrc, 1);
-	
-	data = dst->imagedata;
+	cwidth = (width + 1) / 2;
 
-	for(i=0; i<width*height; i++)
-	{
-		j = i/2;
+	muSeparateChannel(src, &ssrc, 3);
 
-		u = ssrc.chb[j]-128;
-		v = ssrc.chc[j]-128;
+	return muYUVtoRGB(ssrc.cha, width, ssrc.chb, cwidth, ssrc.chc, cwidth, MU_YUV_I420, dst, MU_PIX_BGR);
+}
 
-		rdif = v + ((v*103) >> 8);
-		gdif = ((u*88)>>8)+((v*183)>>8);
-		bdif = u+((u*198)>>8);
-	
+/*===========================================================================================*/
+/*   muYUV422toRGB                                                                          */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   Converts a yuv422 planar image (Y, U, V planes packed in a 3 channel buffer) to BGR.    */
+/*                                                                                           */
+/*   NOTE                                                                                    */
+/*   This is a wrapper of muYUVtoRGB, use it directly for other layouts.                     */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muImage_t *src --> input image                                                           */
+/*===========================================================================================*/
+muError_t muYUV422toRGB(const muImage_t *src, muImage_t *dst)
+{
+	MU_32S width, cwidth;
+	muSepImage_t ssrc;
+	muError_t ret;
 
-		r = ssrc.cha[i] + rdif;
-		//r = ssrc.cha[i] + 1.4075*(ssrc.chc[j]-128);
-		if(r > 255)
-		r=255;
-		if(r < 0)
-		r=0;
-
-		g = ssrc.cha[i] - gdif;
-		//g = ssrc.cha[i] - 0.3455*(ssrc.chb[j]-128) - (ssrc.chc[j]-128);
-		if(g > 255)
-		g = 255;
-		if(g < 0)
-		g = 0;
-
-		b = ssrc.cha[i] + bdif;
-		//b = ssrc.cha[i] + 1.7790*(ssrc.chb[j]-128);
-		if(b > 255)
-		b = 255;
-		if(b < 0)
-		b = 0;
-	
-		//printf("r = %d g= %d b = %d\n", r, g, b);
+	ret = muCheckDepth(4, src, MU_IMG_DEPTH_8U, dst, MU_IMG_DEPTH_8U);
+	if(ret)
+	{
+		return ret;
+	}
 
-		data[i*3] = b;
-		data[i*3+1] = g;
-		data[i*3+2] = r;
+	if(src->channels != 3 || dst->channels != 3)
+	{
+		return MU_ERR_NOT_SUPPORT;
 	}
 
-	return MU_ERR_SUCCESS;
+	width = src->width;
+	cwidth = (width + 1) / 2;
 
+	muSeparateChannel(src, &ssrc, 1);
+
+	return muYUVtoRGB(ssrc.cha, width, ssrc.chb, cwidth, ssrc.chc, cwidth, MU_YUV_I422, dst, MU_PIX_BGR);
 }
 
 
@@ -464,180 +816,266 @@ muError_t muGrayLevel2RGB(const muImage_t *src, muImage_t *dst)
 
 
 /*===========================================================================================*/
-/*   muRGB2Hue                                                                              */
+/*   HSV kernels                                                                             */
 /*                                                                                           */
 /*   DESCRIPTION:                                                                            */
-/*                                                                                           */
-/*   NOTE                                                                                    */
-/*   This routine would be modified the original data.                                       */
-/*                                                                                           */
-/*   USAGE                                                                                   */
-/*   muImage_t *src --> input image                                                           */
+/*   The hue is computed exactly in half degrees, H2 = floor(120*n/d), with Q16 reciprocal   */
+/*   tables instead of divisions; n is the channel difference of the max channel sector and  */
+/*   d = max - min. The saturation uses the same kind of table, the value a 256 entry table. */
+/*   With SSE2, 32 pixels are deinterleaved per step and their min/max taken in registers.   */
+/*   The tables are constant data, so conversions may run concurrently from any thread.      */
 /*===========================================================================================*/
 
-muError_t muRGB2Hue(const muImage_t * src, muImage_t * dst)
+/* Q16 reciprocals ceil(120*65536/d) and ceil(100*65536/d), d = max - min */
+static const MU_32U muHueRecip[256] = {
+	      0, 7864320, 3932160, 2621440, 1966080, 1572864, 1310720, 1123475,
+	 983040,  873814,  786432,  714939,  655360,  604948,  561738,  524288,
+	 491520,  462608,  436907,  413912,  393216,  374492,  357470,  341927,
+	 327680,  314573,  302474,  291272,  280869,  271184,  262144,  253688,
+	 245760,  238313,  231304,  224695,  218454,  212550,  206956,  201650,
+	 196608,  191813,  187246,  182892,  178735,  174763,  170964,  167326,
+	 163840,  160497,  157287,  154203,  151237,  148384,  145636,  142988,
+	 140435,  137971,  135592,  133294,  131072,  128924,  126844,  124831,
+	 122880,  120990,  119157,  117378,  115652,  113976,  112348,  110766,
+	 109227,  107731,  106275,  104858,  103478,  102135,  100825,   99549,
+	  98304,   97091,   95907,   94751,   93623,   92522,   91446,   90395,
+	  89368,   88364,   87382,   86422,   85482,   84563,   83663,   82783,
+	  81920,   81076,   80249,   79438,   78644,   77865,   77102,   76353,
+	  75619,   74899,   74192,   73499,   72818,   72150,   71494,   70850,
+	  70218,   69596,   68986,   68386,   67796,   67217,   66647,   66087,
+	  65536,   64995,   64462,   63938,   63422,   62915,   62416,   61924,
+	  61440,   60964,   60495,   60033,   59579,   59131,   58689,   58255,
+	  57826,   57404,   56988,   56578,   56174,   55776,   55383,   54996,
+	  54614,   54237,   53866,   53499,   53138,   52781,   52429,   52082,
+	  51739,   51401,   51068,   50738,   50413,   50092,   49775,   49462,
+	  49152,   48847,   48546,   48248,   47954,   47663,   47376,   47092,
+	  46812,   46535,   46261,   45991,   45723,   45459,   45198,   44939,
+	  44684,   44432,   44182,   43935,   43691,   43450,   43211,   42975,
+	  42741,   42510,   42282,   42056,   41832,   41611,   41392,   41175,
+	  40960,   40748,   40538,   40330,   40125,   39921,   39719,   39520,
+	  39322,   39126,   38933,   38741,   38551,   38363,   38177,   37992,
+	  37810,   37629,   37450,   37272,   37096,   36922,   36750,   36579,
+	  36409,   36242,   36075,   35911,   35747,   35586,   35425,   35267,
+	  35109,   34953,   34798,   34645,   34493,   34343,   34193,   34045,
+	  33898,   33753,   33609,   33466,   33324,   33183,   33044,   32906,
+	  32768,   32633,   32498,   32364,   32231,   32100,   31969,   31840,
+	  31711,   31584,   31458,   31332,   31208,   31085,   30962,   30841
+};
+
+static const MU_32U muSatRecip[256] = {
+	      0, 6553600, 3276800, 2184534, 1638400, 1310720, 1092267,  936229,
+	 819200,  728178,  655360,  595782,  546134,  504124,  468115,  436907,
+	 409600,  385506,  364089,  344927,  327680,  312077,  297891,  284940,
+	 273067,  262144,  252062,  242726,  234058,  225987,  218454,  211407,
+	 204800,  198594,  192753,  187246,  182045,  177125,  172464,  168042,
+	 163840,  159844,  156039,  152410,  148946,  145636,  142470,  139439,
+	 136534,  133747,  131072,  128502,  126031,  123653,  121363,  119157,
+	 117029,  114976,  112994,  111078,  109227,  107437,  105704,  104026,
+	 102400,  100825,   99297,   97815,   96377,   94980,   93623,   92305,
+	  91023,   89776,   88563,   87382,   86232,   85112,   84021,   82957,
+	  81920,   80909,   79922,   78960,   78020,   77102,   76205,   75329,
+	  74473,   73636,   72818,   72018,   71235,   70469,   69720,   68986,
+	  68267,   67563,   66874,   66198,   65536,   64888,   64251,   63628,
+	  63016,   62416,   61827,   61249,   60682,   60125,   59579,   59042,
+	  58515,   57997,   57488,   56988,   56497,   56014,   55539,   55073,
+	  54614,   54162,   53719,   53282,   52852,   52429,   52013,   51604,
+	  51200,   50804,   50413,   50028,   49649,   49276,   48908,   48546,
+	  48189,   47837,   47490,   47149,   46812,   46480,   46153,   45830,
+	  45512,   45198,   44888,   44583,   44282,   43984,   43691,   43402,
+	  43116,   42834,   42556,   42282,   42011,   41743,   41479,   41218,
+	  40960,   40706,   40455,   40207,   39961,   39719,   39480,   39244,
+	  39010,   38779,   38551,   38326,   38103,   37883,   37665,   37450,
+	  37237,   37026,   36818,   36613,   36409,   36208,   36009,   35813,
+	  35618,   35425,   35235,   35046,   34860,   34676,   34493,   34313,
+	  34134,   33957,   33782,   33609,   33437,   33268,   33099,   32933,
+	  32768,   32605,   32444,   32284,   32126,   31969,   31814,   31660,
+	  31508,   31357,   31208,   31060,   30914,   30769,   30625,   30482,
+	  30341,   30201,   30063,   29926,   29790,   29655,   29521,   29389,
+	  29258,   29128,   28999,   28871,   28744,   28619,   28494,   28371,
+	  28249,   28128,   28007,   27888,   27770,   27653,   27537,   27421,
+	  27307,   27194,   27081,   26970,   26860,   26750,   26641,   26533,
+	  26426,   26320,   26215,   26110,   26007,   25904,   25802,   25701
+};
+
+/* (MU_8U)((v/255.0F)*100.0) */
+static const MU_8U muValTab[256] = {
+	  0,   0,   0,   1,   1,   1,   2,   2,   3,   3,   3,   4,   4,   5,   5,   5,
+	  6,   6,   7,   7,   7,   8,   8,   9,   9,   9,  10,  10,  10,  11,  11,  12,
+	 12,  12,  13,  13,  14,  14,  14,  15,  15,  16,  16,  16,  17,  17,  18,  18,
+	 18,  19,  19,  20,  20,  20,  21,  21,  21,  22,  22,  23,  23,  23,  24,  24,
+	 25,  25,  25,  26,  26,  27,  27,  27,  28,  28,  29,  29,  29,  30,  30,  30,
+	 31,  31,  32,  32,  32,  33,  33,  34,  34,  34,  35,  35,  36,  36,  36,  37,
+	 37,  38,  38,  38,  39,  39,  40,  40,  40,  41,  41,  41,  42,  42,  43,  43,
+	 43,  44,  44,  45,  45,  45,  46,  46,  47,  47,  47,  48,  48,  49,  49,  49,
+	 50,  50,  50,  51,  51,  52,  52,  52,  53,  53,  54,  54,  54,  55,  55,  56,
+	 56,  56,  57,  57,  58,  58,  58,  59,  59,  60,  60,  60,  61,  61,  61,  62,
+	 62,  63,  63,  63,  64,  64,  65,  65,  65,  66,  66,  67,  67,  67,  68,  68,
+	 69,  69,  69,  70,  70,  70,  71,  71,  72,  72,  72,  73,  73,  74,  74,  74,
+	 75,  75,  76,  76,  76,  77,  77,  78,  78,  78,  79,  79,  80,  80,  80,  81,
+	 81,  81,  82,  82,  83,  83,  83,  84,  84,  85,  85,  85,  86,  86,  87,  87,
+	 87,  88,  88,  89,  89,  89,  90,  90,  90,  91,  91,  92,  92,  92,  93,  93,
+	 94,  94,  94,  95,  95,  96,  96,  96,  97,  97,  98,  98,  98,  99,  99, 100
+};
+
+#if defined(__SSE2__)
+/* deinterleaves 32 pixels of 3 channels held in 6 registers (in memory order) into
+   c0 (v0,v1), c1 (v2,v3) and c2 (v4,v5) */
+static void muDeinterleave3x32(__m128i *v)
 {
-	unsigned char *in;
-	unsigned short *outU16;
-	int width, height;
-	unsigned char b, g, r;
-	int i, x, j;
-	unsigned short int pass = 0, idx = 0;
-	unsigned char sort[3] = {0};
-	unsigned char hold = 0;
-	float bufferval = 0;
-	short int *Hnum = 0;
+	__m128i a0, a1, a2, a3, a4, a5;
+	MU_32S k;
 
-
-	if(src->depth != MU_IMG_DEPTH_8U ||
-			dst->depth != MU_IMG_DEPTH_16U ||
-			src->channels != 3) 
+	for(k=0; k<5; k++)
 	{
-		return MU_ERR_NOT_SUPPORT; 
+		a0 = _mm_unpacklo_epi8(v[0], v[3]);
+		a1 = _mm_unpackhi_epi8(v[0], v[3]);
+		a2 = _mm_unpacklo_epi8(v[1], v[4]);
+		a3 = _mm_unpackhi_epi8(v[1], v[4]);
+		a4 = _mm_unpacklo_epi8(v[2], v[5]);
+		a5 = _mm_unpackhi_epi8(v[2], v[5]);
+		v[0] = a0; v[1] = a1; v[2] = a2; v[3] = a3; v[4] = a4; v[5] = a5;
 	}
+}
+#endif
 
-	width = src->width;
-	height = src->height;
-
-	Hnum = (short int *) calloc(height * width, sizeof(short int));
-
-	in = src->imagedata;
-	outU16 = (unsigned short *) dst->imagedata;
+/*  Converts n BGR pixels. cn is 3 for H,S,V or 1 for hue only, exactly one of out16/out8
+    is used; 8-bit outputs hold H/2 so the hue fits a byte. rnd selects rounded hue
+    (muRGB2Hue) instead of truncated hue (muRGB2HSV). */
+static void muBGRtoHSVRow(const MU_8U *src, MU_32S n, MU_32S cn, MU_32S rnd, MU_16U *out16, MU_8U *out8)
+{
+	MU_8U tb[32], tg[32], tr[32], tmax[32], td[32];
+	MU_32S th[32];
+	MU_32S i, k, m;
+	MU_32S b, g, r, mx, d, mr, mg, mb, num, off, a, q, h2, h, sg;
 
-	for(i = 0, x = 0; i < (width * height) * 3; i+=3, x++)
+	for(i=0; i<n; i+=m)
 	{
-		b = in[i]; g = in[i+1]; r = in[i+2];
+		m = n - i < 32 ? n - i : 32;
 
-		sort[0] = b; sort[1] = g; sort[2] = r;
-	
-		for(pass = 1; pass < 3 ; pass++)// find the min , mean, max : sort[0], sort[1], sort[2]
+#if defined(__SSE2__)
+		if(m == 32)
+		{
+			__m128i v[6], mx0, mx1;
+
+			for(k=0; k<6; k++)
+				v[k] = _mm_loadu_si128((const __m128i *)(src + i*3 + k*16));
+			muDeinterleave3x32(v);
+
+			mx0 = _mm_max_epu8(_mm_max_epu8(v[0], v[2]), v[4]);
+			mx1 = _mm_max_epu8(_mm_max_epu8(v[1], v[3]), v[5]);
+			_mm_storeu_si128((__m128i *)tmax, mx0);
+			_mm_storeu_si128((__m128i *)(tmax + 16), mx1);
+			_mm_storeu_si128((__m128i *)td, _mm_sub_epi8(mx0, _mm_min_epu8(_mm_min_epu8(v[0], v[2]), v[4])));
+			_mm_storeu_si128((__m128i *)(td + 16), _mm_sub_epi8(mx1, _mm_min_epu8(_mm_min_epu8(v[1], v[3]), v[5])));
+			_mm_storeu_si128((__m128i *)tb, v[0]);
+			_mm_storeu_si128((__m128i *)(tb + 16), v[1]);
+			_mm_storeu_si128((__m128i *)tg, v[2]);
+			_mm_storeu_si128((__m128i *)(tg + 16), v[3]);
+			_mm_storeu_si128((__m128i *)tr, v[4]);
+			_mm_storeu_si128((__m128i *)(tr + 16), v[5]);
+		}
+		else
+#endif
 		{
-			for( idx = 0; idx < 2; idx++)
+			for(k=0; k<m; k++)
 			{
-				if( sort[ idx ] > sort[ idx + 1 ])
-				{
-					hold = sort[ idx ];
-
-					sort[ idx ] = sort[ idx + 1];
-
-					sort[ idx + 1 ] = hold;
-				}
+				b = src[(i+k)*3]; g = src[(i+k)*3+1]; r = src[(i+k)*3+2];
+				mx = MU_IMAX(b, MU_IMAX(g, r));
+				tb[k] = (MU_8U)b; tg[k] = (MU_8U)g; tr[k] = (MU_8U)r;
+				tmax[k] = (MU_8U)mx;
+				td[k] = (MU_8U)(mx - MU_IMIN(b, MU_IMIN(g, r)));
 			}
-
-			idx = 0;
 		}
 
-		pass = 1;
-
-		if( (sort[2] == r) & (g >= b ) )
-			bufferval = (float)( 60 * ( g - b ) ) / (float)( sort[2] - sort[0]);
-
-		else if( (sort[2] == r) & (g < b ) )
-			bufferval = (float)( 60 * ( g - b ) ) / (float)( sort[2] - sort[0]) + 360;
-
-		else if( sort[2] == g)
-			bufferval = (float)( 60 * ( b - r ) ) / (float)( sort[2] - sort[0]) + 120;
-
-		else if( sort[2] == b)
-			bufferval = (float)( 60 * ( r - g ) ) / (float)( sort[2] - sort[0]) + 240;
-
-		else if(sort[2] == sort[0])
-			bufferval = 0.;
-
-		Hnum[x] = (short int)( bufferval + 0.5 );
-
-	}
-
-	for( i = 0; i < height; i++)
-		for( j = 0; j < width; j++)
+		for(k=0; k<m; k++)
 		{
-			outU16[i*width+j] = (unsigned short)Hnum[i*width+j];
+			b = tb[k]; g = tg[k]; r = tr[k];
+			mx = tmax[k]; d = td[k];
+
+			/* sector selection without branches, red wins ties, then green */
+			mr = -(mx == r);
+			mg = -(mx == g) & ~mr;
+			mb = ~(mr | mg);
+			num = (mr & (g - b)) | (mg & (b - r)) | (mb & (r - g));
+			off = (mr & -(g < b) & 360) | (mg & 120) | (mb & 240);
+
+			/* floor(120*num/d), exact for d < 256 */
+			sg = num >> 31;
+			a = (num ^ sg) - sg;
+			q = (MU_32S)(((MU_32U)a*muHueRecip[d]) >> 16);
+			h2 = ((q ^ sg) - sg) - (sg & (q*d != 120*a));
+			th[k] = (off + ((h2 + rnd) >> 1)) & -(d != 0);
 		}
 
-	free(Hnum);
-
-	return MU_ERR_SUCCESS;
-
+		if(cn == 1)
+		{
+			if(out16)
+				for(k=0; k<m; k++)
+					out16[i+k] = (MU_16U)th[k];
+			else
+				for(k=0; k<m; k++)
+					out8[i+k] = (MU_8U)(th[k] >> 1);
+			continue;
+		}
 
+		for(k=0; k<m; k++)
+		{
+			mx = tmax[k];
+			h = th[k];
+			d = (MU_32S)((td[k]*muSatRecip[mx]) >> 16);
+			if(out16)
+			{
+				out16[(i+k)*3]   = (MU_16U)h;
+				out16[(i+k)*3+1] = (MU_16U)d;
+				out16[(i+k)*3+2] = muValTab[mx];
+			}
+			else
+			{
+				out8[(i+k)*3]   = (MU_8U)(h >> 1);
+				out8[(i+k)*3+1] = (MU_8U)d;
+				out8[(i+k)*3+2] = muValTab[mx];
+			}
+		}
+	}
 }
 
-static MU_32S getH(MU_32S r, MU_32S g, MU_32S b, MU_32S min, MU_32S max)
+/*===========================================================================================*/
+/*   muRGB2Hue                                                                              */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine computes the rounded hue of a BGR image.                                   */
+/*                                                                                           */
+/*   NOTE                                                                                    */
+/*   dst MU_IMG_DEPTH_16U -> hue 0~360, MU_IMG_DEPTH_8U -> hue/2 0~180.                     */
+/*   Gray pixels (max == min) have hue 0.                                                    */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muImage_t *src --> input image                                                           */
+/*===========================================================================================*/
+
+muError_t muRGB2Hue(const muImage_t * src, muImage_t * dst)
 {
-	MU_32S h = 0;
+	MU_32S j, width, height;
 
-	if(min == max)
-	{
-		return 0;
-	}
-	else if((max == r) && (g >= b))
-	{
-		h = 60.0 * ((g-b)/(MU_32F)(max-min));
-	}
-	else if((max == r) && (g < b))
-	{
-		h = 60.0 * ((g-b)/(MU_32F)(max-min)) + 360;
-	}
-	else if((max == g))
+	if(src->depth != MU_IMG_DEPTH_8U ||
+			(dst->depth != MU_IMG_DEPTH_16U && dst->depth != MU_IMG_DEPTH_8U) ||
+			src->channels != 3 || dst->channels != 1) 
 	{
-		h = 60.0 * ((b-r)/(MU_32F)(max-min)) + 120;
+		return MU_ERR_NOT_SUPPORT; 
 	}
-	else if((max == b))
-	{
-		h = 60.0 * ((r-g)/(MU_32F)(max-min)) + 240;
-	}	
 
-	return h;
-}
-
-static MU_32S getS(MU_32S min, MU_32S max)
-{
-	MU_32S s = 0;
+	width = src->width;
+	height = src->height;
 
-	if(max != 0)
+#pragma omp parallel for
+	for(j=0; j<height; j++)
 	{
-		s = ((max-min)/(MU_32F)max) * 100;
+		if(dst->depth == MU_IMG_DEPTH_16U)
+			muBGRtoHSVRow(src->imagedata + j*width*3, width, 1, 1, (MU_16U *)dst->imagedata + j*width, NULL);
+		else
+			muBGRtoHSVRow(src->imagedata + j*width*3, width, 1, 1, NULL, dst->imagedata + j*width);
 	}
 
-	return s;
-}
-
-typedef struct _colorDataInfo
-{
-	MU_32S data1, data2, data3;
-
-}colorDataInfo_t; 
-
-static colorDataInfo_t rgb2hsv(MU_32S r, MU_32S g, MU_32S b, MU_32S min, MU_32S max)
-{
-	colorDataInfo_t hsv;
-
-	//h 0~360
-	hsv.data1 = getH(r, g, b, min, max);
-	//s 0~100
-	hsv.data2 = getS(min, max);
-	//v 0~100
-	hsv.data3 = (MU_32F)(max/(MU_32F)255.0)*100.0;
-	
-	return hsv;
-}
-
-static muError_t muBubbleSort(MU_32S data[], MU_32S length)
-{
-	MU_32S i, j, temp;
-
-	// sort
-	for(j=0; j<length-1; j++)
-		for(i=0; i<length-1-j; i++)
-		{
-			if(data[i] > data[i+1])
-			{
-				temp = data[i];
-				data[i] = data[i+1];
-				data[i+1] = temp; 
-			}
-		}
-
-	
 	return MU_ERR_SUCCESS;
 }
 
@@ -647,7 +1085,8 @@ static muError_t muBubbleSort(MU_32S data[], MU_32S length)
 /*   DESCRIPTION:                                                                            */
 /*                                                                                           */
 /*   NOTE                                                                                    */
-/*   This routine would be modified the original data.                                       */
+/*   h 0~360, s 0~100, v 0~100 for a MU_IMG_DEPTH_16U hsv image. A MU_IMG_DEPTH_8U hsv       */
+/*   image stores h/2 (0~180) so the hue fits a byte, s and v are unchanged.                 */
 /*                                                                                           */
 /*   USAGE                                                                                   */
 /*   muImage_t *src --> input image                                                          */
@@ -659,42 +1098,24 @@ static muError_t muBubbleSort(MU_32S data[], MU_32S length)
 /*===========================================================================================*/
 muError_t muRGB2HSV(const muImage_t *rgb, muImage_t *hsv)
 {
-	MU_32S i, width, height;
-	MU_32S b, g, r;
-	MU_32S max, min;
-	MU_32S data[3];
-	MU_8U *rgbData;
-	MU_16U *hsvData;
-	colorDataInfo_t ret;
+	MU_32S j, width, height;
 
-	if((rgb->depth != MU_IMG_DEPTH_8U) || (hsv->depth != MU_IMG_DEPTH_16U) || (rgb->channels != 3)) 
+	if((rgb->depth != MU_IMG_DEPTH_8U) || (hsv->depth != MU_IMG_DEPTH_16U && hsv->depth != MU_IMG_DEPTH_8U) ||
+	   (rgb->channels != 3)) 
 	{
 		return MU_ERR_NOT_SUPPORT; 
 	}
 	
 	width = rgb->width;
 	height = rgb->height;
-	rgbData = (MU_8U *)rgb->imagedata;
-	hsvData = (MU_16U *)hsv->imagedata;
-	for(i=0; i<width*height*3; i+=3)
-	{
-		b = rgbData[i];
-		g = rgbData[i+1];
-		r = rgbData[i+2];
-
-		data[0] = r; data[1] = g; data[2] = b;
-		
-		muBubbleSort(data, 3);
-		//sort to find min and max;
-		min = data[0]; max = data[2];
 
-		ret = rgb2hsv(r, g, b, min, max);
-		//h
-		hsvData[i] = ret.data1;
-		//s
-		hsvData[i+1] = ret.data2;
-		//v
-		hsvData[i+2] = ret.data3;
+#pragma omp parallel for
+	for(j=0; j<height; j++)
+	{
+		if(hsv->depth == MU_IMG_DEPTH_16U)
+			muBGRtoHSVRow(rgb->imagedata + j*width*3, width, 3, 0, (MU_16U *)hsv->imagedata + j*width*3, NULL);
+		else
+			muBGRtoHSVRow(rgb->imagedata + j*width*3, width, 3, 0, NULL, hsv->imagedata + j*width*3);
 	}
 
 	return MU_ERR_SUCCESS;
@@ -934,3 +1355,937 @@ muError_t muXYZ2LAB(const muImage_t *src, muImage_t *dst)
 
 	return MU_ERR_SUCCESS;
 }
+
+/*===========================================================================================*/
+/*   RGB to LAB tables                                                                       */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   muLabTab[c][k] holds the contribution of channel value k of input channel c (b, g, r)   */
+/*   to X/Xn, Y/Yn and Z/Zn in Q24: sRGB linearization, the matrix and the white point are   */
+/*   folded together, so a pixel needs 9 table reads and additions. f(t) (cube root with     */
+/*   the linear toe) is tabulated in Q20 on a 1/4096 grid of t and linearly interpolated.    */
+/*   Both tables are constants generated from these formulas:                                */
+/*   muLabTab[c][i][k] = (MU_32S)(lin(k/255.0)*m[i][2-c]*2^24 + 0.5), lin the sRGB decoding  */
+/*   and m the D65 sRGB to XYZ matrix divided by the white point (0.95047, 1, 1.08883);      */
+/*   muLabCbrt[k] = (MU_32S)(f(k/4096.0)*2^20 + 0.5).                                        */
+/*===========================================================================================*/
+
+#define MU_LAB_TBITS   24
+#define MU_LAB_FBITS   20
+#define MU_LAB_GRID    12
+#define MU_LAB_FSIZE   ((1 << MU_LAB_GRID) + 8)
+
+static const MU_32S muLabTab[3][3][256] = {
+	{
+		{
+			       0,      967,     1934,     2901,     3868,     4835,     5802,     6769,
+			    7737,     8704,     9671,    10662,    11714,    12823,    13992,    15220,
+			   16509,    17859,    19272,    20748,    22288,    23893,    25563,    27299,
+			   29102,    30973,    32912,    34920,    36998,    39146,    41365,    43656,
+			   46019,    48456,    50966,    53550,    56209,    58943,    61754,    64641,
+			   67606,    70648,    73769,    76969,    80248,    83607,    87047,    90568,
+			   94171,    97856,   101624,   105475,   109410,   113429,   117533,   121723,
+			  125998,   130360,   134808,   139344,   143968,   148679,   153480,   158370,
+			  163349,   168419,   173579,   178831,   184174,   189608,   195136,   200756,
+			  206469,   212277,   218178,   224174,   230265,   236451,   242734,   249113,
+			  255588,   262161,   268831,   275599,   282465,   289430,   296495,   303659,
+			  310923,   318287,   325752,   333318,   340986,   348755,   356627,   364602,
+			  372680,   380861,   389146,   397535,   406029,   414627,   423331,   432141,
+			  441056,   450078,   459207,   468443,   477786,   487237,   496796,   506464,
+			  516241,   526127,   536122,   546228,   556443,   566769,   577206,   587755,
+			  598415,   609187,   620071,   631068,   642177,   653400,   664737,   676187,
+			  687752,   699431,   711225,   723135,   735160,   747300,   759557,   771931,
+			  784421,   797028,   809753,   822595,   835555,   848634,   861832,   875148,
+			  888584,   902139,   915814,   929609,   943525,   957561,   971718,   985997,
+			 1000398,  1014920,  1029565,  1044332,  1059222,  1074235,  1089372,  1104632,
+			 1120016,  1135525,  1151158,  1166915,  1182798,  1198807,  1214941,  1231201,
+			 1247587,  1264100,  1280739,  1297506,  1314400,  1331421,  1348571,  1365849,
+			 1383255,  1400789,  1418453,  1436246,  1454169,  1472221,  1490404,  1508716,
+			 1527160,  1545734,  1564439,  1583276,  1602244,  1621344,  1640576,  1659941,
+			 1679439,  1699069,  1718833,  1738730,  1758761,  1778925,  1799224,  1819658,
+			 1840226,  1860929,  1881768,  1902741,  1923851,  1945097,  1966479,  1987997,
+			 2009652,  2031444,  2053373,  2075440,  2097645,  2119987,  2142468,  2165087,
+			 2187844,  2210741,  2233777,  2256952,  2280267,  2303722,  2327317,  2351052,
+			 2374928,  2398945,  2423103,  2447402,  2471843,  2496426,  2521150,  2546017,
+			 2571026,  2596178,  2621473,  2646912,  2672493,  2698218,  2724087,  2750101,
+			 2776258,  2802560,  2829007,  2855599,  2882336,  2909219,  2936247,  2963421,
+			 2990742,  3018208,  3045822,  3073582,  3101489,  3129543,  3157745,  3186095
+		},
+		{
+			       0,      368,      735,     1103,     1471,     1838,     2206,     2574,
+			    2941,     3309,     3677,     4054,     4453,     4875,     5319,     5786,
+			    6276,     6790,     7327,     7888,     8474,     9084,     9719,    10379,
+			   11064,    11775,    12513,    13276,    14066,    14883,    15727,    16598,
+			   17496,    18422,    19377,    20359,    21370,    22410,    23478,    24576,
+			   25703,    26860,    28046,    29263,    30509,    31786,    33094,    34433,
+			   35803,    37204,    38636,    40100,    41596,    43124,    44685,    46278,
+			   47903,    49561,    51252,    52977,    54735,    56526,    58351,    60210,
+			   62103,    64031,    65993,    67989,    70021,    72087,    74188,    76325,
+			   78497,    80705,    82949,    85228,    87544,    89896,    92284,    94710,
+			   97171,    99670,   102206,   104779,   107390,   110038,   112724,   115447,
+			  118209,   121009,   123847,   126724,   129639,   132593,   135585,   138617,
+			  141688,   144799,   147949,   151138,   154367,   157636,   160945,   164295,
+			  167684,   171114,   174585,   178096,   181649,   185242,   188876,   192552,
+			  196269,   200027,   203827,   207669,   211553,   215479,   219447,   223457,
+			  227510,   231605,   235743,   239924,   244148,   248415,   252725,   257078,
+			  261475,   265915,   270399,   274927,   279499,   284115,   288775,   293479,
+			  298227,   303020,   307858,   312741,   317668,   322641,   327658,   332721,
+			  337829,   342982,   348181,   353426,   358717,   364053,   369436,   374864,
+			  380339,   385860,   391428,   397043,   402704,   408411,   414166,   419968,
+			  425817,   431713,   437656,   443647,   449686,   455772,   461906,   468088,
+			  474318,   480596,   486922,   493296,   499719,   506190,   512710,   519279,
+			  525897,   532563,   539279,   546044,   552858,   559721,   566634,   573596,
+			  580608,   587669,   594781,   601942,   609154,   616416,   623727,   631090,
+			  638502,   645966,   653480,   661044,   668660,   676326,   684044,   691812,
+			  699632,   707503,   715425,   723399,   731425,   739502,   747632,   755813,
+			  764046,   772331,   780668,   789057,   797499,   805994,   814540,   823140,
+			  831792,   840497,   849255,   858066,   866930,   875848,   884818,   893842,
+			  902919,   912050,   921235,   930473,   939765,   949111,   958511,   967965,
+			  977473,   987036,   996653,  1006324,  1016050,  1025830,  1035665,  1045555,
+			 1055500,  1065500,  1075555,  1085665,  1095830,  1106050,  1116326,  1126657,
+			 1137044,  1147487,  1157985,  1168539,  1179149,  1189815,  1200537,  1211315
+		},
+		{
+			       0,     4445,     8891,    13336,    17782,    22227,    26672,    31118,
+			   35563,    40008,    44454,    49013,    53845,    58945,    64316,    69962,
+			   75887,    82095,    88590,    95375,   102453,   109829,   117506,   125487,
+			  133775,   142375,   151288,   160519,   170070,   179945,   190146,   200677,
+			  211541,   222740,   234278,   246157,   258380,   270950,   283869,   297141,
+			  310769,   324753,   339099,   353807,   368881,   384323,   400135,   416321,
+			  432882,   449822,   467142,   484844,   502933,   521408,   540274,   559532,
+			  579185,   599234,   619683,   640533,   661786,   683446,   705513,   727990,
+			  750880,   774184,   797905,   822044,   846605,   871587,   896995,   922830,
+			  949093,   975788,  1002915,  1030477,  1058476,  1086914,  1115793,  1145114,
+			 1174880,  1205093,  1235754,  1266865,  1298429,  1330446,  1362919,  1395850,
+			 1429241,  1463093,  1497408,  1532188,  1567435,  1603150,  1639336,  1675993,
+			 1713124,  1750731,  1788815,  1827378,  1866422,  1905948,  1945958,  1986453,
+			 2027436,  2068908,  2110871,  2153326,  2196275,  2239720,  2283662,  2328102,
+			 2373043,  2418487,  2464433,  2510885,  2557844,  2605311,  2653288,  2701777,
+			 2750778,  2800294,  2850326,  2900876,  2951945,  3003534,  3055646,  3108281,
+			 3161441,  3215128,  3269343,  3324088,  3379364,  3435172,  3491514,  3548391,
+			 3605806,  3663758,  3722251,  3781284,  3840860,  3900980,  3961646,  4022858,
+			 4084619,  4146929,  4209790,  4273203,  4337170,  4401693,  4466771,  4532408,
+			 4598604,  4665360,  4732678,  4800560,  4869006,  4938018,  5007597,  5077745,
+			 5148462,  5219751,  5291613,  5364048,  5437058,  5510645,  5584810,  5659553,
+			 5734877,  5810782,  5887270,  5964343,  6042000,  6120245,  6199077,  6278499,
+			 6358510,  6439114,  6520310,  6602101,  6684487,  6767469,  6851050,  6935229,
+			 7020009,  7105390,  7191374,  7277962,  7365155,  7452954,  7541361,  7630377,
+			 7720002,  7810239,  7901088,  7992550,  8084627,  8177320,  8270630,  8364558,
+			 8459105,  8554273,  8650062,  8746475,  8843511,  8941172,  9039460,  9138375,
+			 9237918,  9338091,  9438895,  9540331,  9642400,  9745103,  9848442,  9952417,
+			10057029, 10162280, 10268171, 10374702, 10481876, 10589693, 10698153, 10807259,
+			10917012, 11027412, 11138460, 11250158, 11362507, 11475507, 11589160, 11703468,
+			11818430, 11934048, 12050323, 12167257, 12284850, 12403103, 12522017, 12641594,
+			12761834, 12882739, 13004310, 13126547, 13249451, 13373025, 13497267, 13622181,
+			13747767, 13874025, 14000957, 14128564, 14256847, 14385807, 14515444, 14645761
+		}
+	},
+	{
+		{
+			       0,     1916,     3832,     5748,     7664,     9580,    11495,    13411,
+			   15327,    17243,    19159,    21124,    23207,    25405,    27720,    30153,
+			   32707,    35382,    38181,    41105,    44156,    47335,    50644,    54084,
+			   57656,    61362,    65204,    69182,    73299,    77554,    81951,    86490,
+			   91172,    95999,   100971,   106091,   111359,   116777,   122345,   128065,
+			  133938,   139965,   146148,   152487,   158984,   165639,   172454,   179430,
+			  186568,   193869,   201333,   208963,   216759,   224722,   232853,   241153,
+			  249623,   258264,   267077,   276063,   285223,   294558,   304069,   313757,
+			  323622,   333666,   343889,   354293,   364878,   375645,   386596,   397730,
+			  409050,   420555,   432246,   444125,   456193,   468449,   480895,   493533,
+			  506361,   519383,   532597,   546006,   559610,   573409,   587404,   601597,
+			  615988,   630578,   645368,   660357,   675548,   690941,   706537,   722336,
+			  738339,   754547,   770961,   787581,   804409,   821444,   838688,   856141,
+			  873805,   891679,   909764,   928062,   946572,   965297,   984235,  1003389,
+			 1022758,  1042343,  1062146,  1082166,  1102405,  1122863,  1143540,  1164438,
+			 1185557,  1206898,  1228462,  1250248,  1272258,  1294493,  1316952,  1339638,
+			 1362549,  1385688,  1409054,  1432648,  1456471,  1480524,  1504807,  1529321,
+			 1554066,  1579043,  1604252,  1629695,  1655372,  1681283,  1707429,  1733811,
+			 1760429,  1787284,  1814377,  1841707,  1869276,  1897085,  1925133,  1953422,
+			 1981952,  2010723,  2039736,  2068993,  2098492,  2128236,  2158223,  2188456,
+			 2218935,  2249660,  2280631,  2311850,  2343317,  2375032,  2406996,  2439210,
+			 2471674,  2504388,  2537354,  2570571,  2604041,  2637763,  2671739,  2705969,
+			 2740453,  2775193,  2810188,  2845438,  2880946,  2916711,  2952733,  2989013,
+			 3025553,  3062351,  3099409,  3136728,  3174307,  3212148,  3250250,  3288615,
+			 3327243,  3366134,  3405289,  3444708,  3484392,  3524342,  3564558,  3605040,
+			 3645788,  3686805,  3728089,  3769642,  3811463,  3853555,  3895915,  3938547,
+			 3981449,  4024623,  4068068,  4111786,  4155777,  4200041,  4244579,  4289391,
+			 4334477,  4379840,  4425477,  4471391,  4517582,  4564050,  4610796,  4657819,
+			 4705121,  4752703,  4800563,  4848704,  4897125,  4945827,  4994811,  5044076,
+			 5093623,  5143454,  5193567,  5243964,  5294646,  5345612,  5396862,  5448399,
+			 5500221,  5552330,  5604726,  5657409,  5710379,  5763638,  5817185,  5871022,
+			 5925148,  5979564,  6034271,  6089268,  6144556,  6200137,  6256009,  6312174
+		},
+		{
+			       0,     3642,     7284,    10926,    14568,    18210,    21852,    25494,
+			   29136,    32778,    36420,    40155,    44115,    48293,    52693,    57319,
+			   62173,    67259,    72580,    78139,    83938,    89981,    96271,   102809,
+			  109600,   116646,   123948,   131511,   139336,   147426,   155784,   164412,
+			  173313,   182488,   191941,   201673,   211687,   221985,   232570,   243444,
+			  254608,   266066,   277819,   289869,   302219,   314870,   327825,   341086,
+			  354654,   368533,   382723,   397226,   412046,   427182,   442639,   458417,
+			  474518,   490944,   507697,   524779,   542192,   559937,   578017,   596432,
+			  615186,   634278,   653712,   673489,   693611,   714079,   734895,   756061,
+			  777579,   799449,   821674,   844255,   867195,   890493,   914153,   938176,
+			  962563,   987316,  1012436,  1037925,  1063784,  1090016,  1116621,  1143600,
+			 1170957,  1198691,  1226805,  1255300,  1284177,  1313438,  1343084,  1373117,
+			 1403539,  1434349,  1465551,  1497145,  1529133,  1561516,  1594296,  1627473,
+			 1661050,  1695027,  1729407,  1764190,  1799377,  1834971,  1870972,  1907381,
+			 1944201,  1981432,  2019075,  2057133,  2095606,  2134495,  2173802,  2213527,
+			 2253674,  2294241,  2335232,  2376647,  2418487,  2460753,  2503447,  2546571,
+			 2590124,  2634109,  2678527,  2723378,  2768665,  2814388,  2860548,  2907147,
+			 2954186,  3001665,  3049587,  3097953,  3146763,  3196018,  3245721,  3295871,
+			 3346470,  3397520,  3449021,  3500975,  3553382,  3606244,  3659563,  3713338,
+			 3767571,  3822263,  3877416,  3933031,  3989108,  4045648,  4102653,  4160124,
+			 4218062,  4276468,  4335343,  4394689,  4454505,  4514794,  4575556,  4636792,
+			 4698504,  4760692,  4823357,  4886502,  4950126,  5014230,  5078816,  5143885,
+			 5209438,  5275475,  5341998,  5409008,  5476505,  5544492,  5612968,  5681935,
+			 5751394,  5821346,  5891791,  5962731,  6034167,  6106100,  6178530,  6251460,
+			 6324889,  6398818,  6473249,  6548183,  6623621,  6699563,  6776010,  6852964,
+			 6930425,  7008395,  7086874,  7165863,  7245363,  7325376,  7405902,  7486941,
+			 7568496,  7650566,  7733154,  7816259,  7899882,  7984025,  8068689,  8153874,
+			 8239582,  8325812,  8412567,  8499847,  8587653,  8675985,  8764846,  8854235,
+			 8944153,  9034603,  9125583,  9217095,  9309141,  9401721,  9494835,  9588486,
+			 9682672,  9777397,  9872660,  9968462, 10064804, 10161687, 10259112, 10357079,
+			10455591, 10554646, 10654247, 10754394, 10855088, 10956330, 11058120, 11160461,
+			11263351, 11366793, 11470786, 11575333, 11680433, 11786088, 11892298, 11999065
+		},
+		{
+			       0,      557,     1115,     1672,     2230,     2787,     3345,     3902,
+			    4460,     5017,     5575,     6147,     6753,     7392,     8066,     8774,
+			    9517,    10295,    11110,    11961,    12848,    13773,    14736,    15737,
+			   16776,    17855,    18973,    20130,    21328,    22566,    23846,    25166,
+			   26529,    27933,    29380,    30870,    32403,    33979,    35599,    37264,
+			   38973,    40727,    42526,    44370,    46260,    48197,    50180,    52210,
+			   54287,    56411,    58583,    60803,    63072,    65389,    67755,    70170,
+			   72634,    75149,    77713,    80328,    82993,    85709,    88477,    91296,
+			   94166,    97089,   100063,   103091,   106171,   109304,   112490,   115730,
+			  119024,   122371,   125773,   129230,   132741,   136307,   139929,   143606,
+			  147339,   151128,   154973,   158875,   162833,   166848,   170921,   175050,
+			  179238,   183483,   187786,   192148,   196568,   201047,   205585,   210182,
+			  214839,   219555,   224331,   229167,   234064,   239020,   244038,   249117,
+			  254256,   259457,   264719,   270044,   275430,   280878,   286389,   291962,
+			  297598,   303297,   309059,   314884,   320773,   326726,   332743,   338824,
+			  344969,   351178,   357453,   363792,   370197,   376666,   383201,   389802,
+			  396469,   403202,   410001,   416866,   423798,   430797,   437863,   444996,
+			  452196,   459463,   466799,   474202,   481673,   489213,   496821,   504497,
+			  512243,   520057,   527940,   535892,   543914,   552006,   560167,   568399,
+			  576700,   585072,   593514,   602027,   610611,   619265,   627991,   636788,
+			  645657,   654597,   663609,   672693,   681849,   691077,   700378,   709751,
+			  719198,   728717,   738309,   747974,   757713,   767526,   777412,   787372,
+			  797406,   807514,   817697,   827954,   838286,   848693,   859174,   869731,
+			  880363,   891070,   901854,   912712,   923647,   934658,   945745,   956908,
+			  968148,   979464,   990857,  1002327,  1013874,  1025499,  1037200,  1048980,
+			 1060837,  1072772,  1084784,  1096875,  1109044,  1121292,  1133618,  1146022,
+			 1158506,  1171068,  1183710,  1196431,  1209231,  1222111,  1235070,  1248109,
+			 1261229,  1274428,  1287707,  1301067,  1314508,  1328029,  1341631,  1355313,
+			 1369077,  1382922,  1396848,  1410856,  1424946,  1439117,  1453370,  1467705,
+			 1482122,  1496621,  1511203,  1525867,  1540615,  1555444,  1570357,  1585353,
+			 1600432,  1615594,  1630840,  1646170,  1661583,  1677080,  1692661,  1708326,
+			 1724076,  1739909,  1755828,  1771830,  1787918,  1804091,  1820348,  1836691
+		}
+	},
+	{
+		{
+			       0,     2210,     4419,     6629,     8838,    11048,    13257,    15467,
+			   17676,    19886,    22095,    24361,    26763,    29298,    31967,    34774,
+			   37719,    40804,    44032,    47405,    50923,    54589,    58405,    62371,
+			   66491,    70765,    75196,    79784,    84531,    89439,    94510,    99744,
+			  105144,   110710,   116445,   122349,   128424,   134672,   141093,   147690,
+			  154463,   161414,   168544,   175855,   183347,   191022,   198882,   206927,
+			  215158,   223578,   232186,   240985,   249976,   259159,   268536,   278108,
+			  287876,   297841,   308005,   318368,   328932,   339697,   350666,   361838,
+			  373215,   384798,   396588,   408586,   420793,   433211,   445839,   458680,
+			  471734,   485002,   498485,   512185,   526101,   540236,   554590,   569163,
+			  583958,   598975,   614215,   629678,   645366,   661280,   677421,   693788,
+			  710385,   727210,   744266,   761553,   779072,   796824,   814809,   833030,
+			  851485,   870177,   889106,   908273,   927680,   947325,   967212,   987340,
+			 1007710,  1028323,  1049180,  1070282,  1091629,  1113222,  1135063,  1157152,
+			 1179489,  1202076,  1224913,  1248001,  1271342,  1294935,  1318781,  1342881,
+			 1367237,  1391848,  1416716,  1441841,  1467224,  1492866,  1518767,  1544929,
+			 1571351,  1598036,  1624983,  1652193,  1679667,  1707405,  1735409,  1763680,
+			 1792217,  1821021,  1850094,  1879436,  1909047,  1938929,  1969082,  1999507,
+			 2030204,  2061175,  2092419,  2123938,  2155732,  2187801,  2220148,  2252772,
+			 2285673,  2318854,  2352313,  2386053,  2420073,  2454375,  2488958,  2523824,
+			 2558973,  2594406,  2630124,  2666127,  2702416,  2738991,  2775854,  2813004,
+			 2850443,  2888170,  2926188,  2964495,  3003094,  3041984,  3081167,  3120642,
+			 3160411,  3200474,  3240832,  3281484,  3322433,  3363679,  3405221,  3447061,
+			 3489200,  3531638,  3574375,  3617412,  3660750,  3704390,  3748331,  3792575,
+			 3837122,  3881973,  3927128,  3972588,  4018354,  4064426,  4110804,  4157490,
+			 4204483,  4251785,  4299396,  4347316,  4395547,  4444088,  4492941,  4542105,
+			 4591582,  4641371,  4691475,  4741892,  4792624,  4843671,  4895034,  4946713,
+			 4998709,  5051023,  5103655,  5156605,  5209874,  5263463,  5317372,  5371601,
+			 5426152,  5481025,  5536220,  5591738,  5647579,  5703745,  5760235,  5817049,
+			 5874190,  5931656,  5989449,  6047570,  6106018,  6164794,  6223898,  6283333,
+			 6343096,  6403190,  6463615,  6524372,  6585460,  6646880,  6708633,  6770720,
+			 6833141,  6895896,  6958985,  7022411,  7086172,  7150270,  7214704,  7279476
+		},
+		{
+			       0,     1083,     2165,     3248,     4331,     5413,     6496,     7578,
+			    8661,     9744,    10826,    11937,    13113,    14356,    15664,    17039,
+			   18482,    19994,    21575,    23228,    24951,    26748,    28617,    30561,
+			   32580,    34674,    36845,    39093,    41419,    43824,    46308,    48873,
+			   51519,    54246,    57056,    59949,    62926,    65987,    69134,    72366,
+			   75685,    79091,    82584,    86166,    89837,    93598,    97449,   101391,
+			  105424,   109550,   113768,   118079,   122484,   126984,   131579,   136269,
+			  141055,   145938,   150918,   155996,   161172,   166447,   171821,   177295,
+			  182870,   188545,   194322,   200201,   206182,   212267,   218455,   224746,
+			  231143,   237644,   244250,   250963,   257782,   264708,   271741,   278882,
+			  286131,   293489,   300956,   308533,   316220,   324017,   331926,   339946,
+			  348078,   356322,   364680,   373150,   381734,   390432,   399245,   408172,
+			  417215,   426374,   435649,   445041,   454549,   464175,   473920,   483782,
+			  493763,   503863,   514083,   524422,   534882,   545463,   556164,   566987,
+			  577932,   588999,   600189,   611502,   622939,   634499,   646183,   657992,
+			  669926,   681985,   694170,   706481,   718918,   731482,   744174,   756992,
+			  769939,   783014,   796218,   809550,   823012,   836603,   850325,   864177,
+			  878160,   892274,   906519,   920896,   935405,   950047,   964821,   979729,
+			  994770,  1009945,  1025254,  1040698,  1056277,  1071990,  1087840,  1103825,
+			 1119946,  1136204,  1152599,  1169131,  1185800,  1202607,  1219553,  1236637,
+			 1253859,  1271221,  1288722,  1306363,  1324144,  1342065,  1360127,  1378330,
+			 1396675,  1415161,  1433789,  1452559,  1471472,  1490528,  1509726,  1529069,
+			 1548555,  1568185,  1587960,  1607879,  1627943,  1648153,  1668508,  1689009,
+			 1709657,  1730450,  1751391,  1772479,  1793714,  1815096,  1836627,  1858306,
+			 1880133,  1902110,  1924235,  1946510,  1968934,  1991509,  2014233,  2037109,
+			 2060135,  2083312,  2106641,  2130121,  2153753,  2177538,  2201475,  2225564,
+			 2249807,  2274204,  2298753,  2323457,  2348315,  2373327,  2398495,  2423817,
+			 2449294,  2474927,  2500716,  2526660,  2552761,  2579019,  2605434,  2632006,
+			 2658735,  2685621,  2712666,  2739869,  2767231,  2794751,  2822430,  2850269,
+			 2878266,  2906424,  2934742,  2963220,  2991859,  3020658,  3049619,  3078740,
+			 3108024,  3137469,  3167076,  3196846,  3226778,  3256873,  3287131,  3317553,
+			 3348138,  3378887,  3409800,  3440878,  3472120,  3503527,  3535099,  3566836
+		},
+		{
+			       0,       90,      181,      271,      361,      451,      542,      632,
+			     722,      812,      903,      995,     1093,     1197,     1306,     1421,
+			    1541,     1667,     1799,     1937,     2080,     2230,     2386,     2548,
+			    2716,     2891,     3072,     3259,     3453,     3654,     3861,     4075,
+			    4295,     4523,     4757,     4998,     5246,     5502,     5764,     6033,
+			    6310,     6594,     6885,     7184,     7490,     7804,     8125,     8453,
+			    8790,     9134,     9485,     9845,    10212,    10587,    10970,    11361,
+			   11760,    12168,    12583,    13006,    13438,    13877,    14326,    14782,
+			   15247,    15720,    16202,    16692,    17190,    17698,    18214,    18738,
+			   19271,    19813,    20364,    20924,    21492,    22070,    22656,    23252,
+			   23856,    24470,    25092,    25724,    26365,    27015,    27674,    28343,
+			   29021,    29708,    30405,    31111,    31827,    32552,    33287,    34031,
+			   34785,    35549,    36322,    37105,    37898,    38700,    39513,    40335,
+			   41167,    42009,    42861,    43724,    44596,    45478,    46370,    47272,
+			   48185,    49108,    50041,    50984,    51937,    52901,    53875,    54860,
+			   55855,    56860,    57876,    58903,    59940,    60987,    62045,    63114,
+			   64193,    65284,    66384,    67496,    68618,    69752,    70896,    72050,
+			   73216,    74393,    75581,    76779,    77989,    79210,    80442,    81685,
+			   82939,    84204,    85480,    86768,    88067,    89377,    90698,    92031,
+			   93375,    94731,    96098,    97476,    98866,   100267,   101680,   103104,
+			  104540,   105988,   107447,   108918,   110400,   111894,   113400,   114918,
+			  116447,   117989,   119542,   121107,   122683,   124272,   125873,   127486,
+			  129110,   130747,   132396,   134056,   135729,   137414,   139111,   140821,
+			  142542,   144276,   146022,   147780,   149550,   151333,   153128,   154936,
+			  156755,   158588,   160432,   162290,   164159,   166041,   167936,   169843,
+			  171763,   173695,   175640,   177598,   179568,   181551,   183547,   185556,
+			  187577,   189611,   191658,   193717,   195790,   197875,   199974,   202085,
+			  204209,   206346,   208496,   210659,   212836,   215025,   217227,   219443,
+			  221671,   223913,   226168,   228436,   230717,   233011,   235319,   237640,
+			  239974,   242322,   244683,   247057,   249445,   251846,   254261,   256689,
+			  259130,   261585,   264054,   266536,   269031,   271541,   274063,   276600,
+			  279150,   281714,   284291,   286882,   289487,   292105,   294738,   297384
+		}
+	}
+};
+
+static const MU_32S muLabCbrt[MU_LAB_FSIZE] = {
+	 144631,  146625,  148618,  150612,  152605,  154599,  156592,  158585,
+	 160579,  162572,  164566,  166559,  168553,  170546,  172540,  174533,
+	 176527,  178520,  180514,  182507,  184501,  186494,  188488,  190481,
+	 192475,  194468,  196461,  198455,  200448,  202442,  204435,  206429,
+	 208422,  210416,  212409,  214403,  216396,  218380,  220330,  222246,
+	 224130,  225982,  227805,  229599,  231365,  233105,  234819,  236508,
+	 238174,  239816,  241437,  243036,  244614,  246172,  247711,  249230,
+	 250732,  252215,  253682,  255131,  256565,  257982,  259384,  260771,
+	 262144,  263502,  264847,  266178,  267495,  268800,  270093,  271373,
+	 272641,  273897,  275142,  276376,  277599,  278811,  280013,  281205,
+	 282386,  283558,  284720,  285873,  287016,  288151,  289276,  290393,
+	 291502,  292602,  293693,  294777,  295853,  296921,  297981,  299034,
+	 300080,  301118,  302150,  303174,  304191,  305202,  306206,  307203,
+	 308194,  309179,  310157,  311129,  312096,  313056,  314010,  314959,
+	 315902,  316840,  317771,  318698,  319619,  320535,  321445,  322351,
+	 323251,  324147,  325037,  325923,  326804,  327680,  328551,  329418,
+	 330281,  331139,  331992,  332841,  333686,  334526,  335363,  336195,
+	 337023,  337847,  338667,  339483,  340295,  341104,  341908,  342709,
+	 343506,  344299,  345089,  345875,  346657,  347436,  348212,  348984,
+	 349753,  350518,  351280,  352039,  352794,  353546,  354295,  355041,
+	 355784,  356524,  357260,  357994,  358725,  359452,  360177,  360899,
+	 361618,  362334,  363047,  363758,  364465,  365170,  365872,  366572,
+	 367269,  367963,  368655,  369344,  370030,  370714,  371396,  372075,
+	 372751,  373425,  374097,  374766,  375433,  376098,  376760,  377420,
+	 378077,  378732,  379385,  380036,  380685,  381331,  381975,  382617,
+	 383257,  383895,  384530,  385164,  385795,  386424,  387052,  387677,
+	 388300,  388922,  389541,  390158,  390774,  391387,  391999,  392608,
+	 393216,  393822,  394426,  395028,  395628,  396227,  396824,  397419,
+	 398012,  398603,  399193,  399781,  400367,  400951,  401534,  402115,
+	 402695,  403272,  403849,  404423,  404996,  405567,  406137,  406705,
+	 407271,  407836,  408399,  408961,  409521,  410080,  410637,  411193,
+	 411747,  412300,  412851,  413401,  413949,  414496,  415041,  415585,
+	 416128,  416669,  417209,  417747,  418284,  418819,  419354,  419886,
+	 420418,  420948,  421477,  422004,  422531,  423056,  423579,  424101,
+	 424622,  425142,  425661,  426178,  426694,  427208,  427722,  428234,
+	 428745,  429255,  429764,  430271,  430777,  431282,  431786,  432289,
+	 432790,  433291,  433790,  434288,  434785,  435280,  435775,  436269,
+	 436761,  437252,  437742,  438232,  438720,  439207,  439692,  440177,
+	 440661,  441143,  441625,  442106,  442585,  443064,  443541,  444017,
+	 444493,  444967,  445441,  445913,  446384,  446855,  447324,  447793,
+	 448260,  448726,  449192,  449656,  450120,  450583,  451044,  451505,
+	 451965,  452424,  452881,  453338,  453795,  454250,  454704,  455157,
+	 455610,  456061,  456512,  456962,  457411,  457859,  458306,  458752,
+	 459197,  459642,  460086,  460528,  460970,  461411,  461852,  462291,
+	 462730,  463168,  463605,  464041,  464476,  464910,  465344,  465777,
+	 466209,  466640,  467071,  467501,  467929,  468358,  468785,  469211,
+	 469637,  470062,  470487,  470910,  471333,  471755,  472176,  472596,
+	 473016,  473435,  473853,  474271,  474688,  475104,  475519,  475933,
+	 476347,  476760,  477173,  477585,  477996,  478406,  478815,  479224,
+	 479633,  480040,  480447,  480853,  481258,  481663,  482067,  482471,
+	 482873,  483275,  483677,  484078,  484478,  484877,  485276,  485674,
+	 486071,  486468,  486864,  487260,  487655,  488049,  488442,  488835,
+	 489228,  489619,  490010,  490401,  490791,  491180,  491569,  491957,
+	 492344,  492731,  493117,  493502,  493887,  494272,  494655,  495039,
+	 495421,  495803,  496184,  496565,  496945,  497325,  497704,  498083,
+	 498461,  498838,  499215,  499591,  499967,  500342,  500716,  501090,
+	 501463,  501836,  502209,  502580,  502951,  503322,  503692,  504062,
+	 504431,  504799,  505167,  505535,  505901,  506268,  506634,  506999,
+	 507364,  507728,  508091,  508455,  508817,  509179,  509541,  509902,
+	 510263,  510623,  510983,  511342,  511700,  512058,  512416,  512773,
+	 513130,  513486,  513841,  514196,  514551,  514905,  515259,  515612,
+	 515965,  516317,  516668,  517020,  517370,  517721,  518071,  518420,
+	 518769,  519117,  519465,  519813,  520160,  520506,  520852,  521198,
+	 521543,  521888,  522232,  522576,  522919,  523262,  523604,  523946,
+	 524288,  524629,  524970,  525310,  525650,  525989,  526328,  526667,
+	 527005,  527342,  527679,  528016,  528352,  528688,  529024,  529359,
+	 529693,  530028,  530361,  530695,  531028,  531360,  531692,  532024,
+	 532355,  532686,  533017,  533347,  533676,  534005,  534334,  534663,
+	 534991,  535318,  535646,  535972,  536299,  536625,  536950,  537276,
+	 537600,  537925,  538249,  538573,  538896,  539219,  539541,  539863,
+	 540185,  540506,  540827,  541148,  541468,  541788,  542107,  542427,
+	 542745,  543064,  543382,  543699,  544016,  544333,  544650,  544966,
+	 545281,  545597,  545912,  546227,  546541,  546855,  547168,  547482,
+	 547794,  548107,  548419,  548731,  549042,  549353,  549664,  549974,
+	 550284,  550594,  550903,  551212,  551521,  551829,  552137,  552445,
+	 552752,  553059,  553366,  553672,  553978,  554283,  554588,  554893,
+	 555198,  555502,  555806,  556110,  556413,  556716,  557018,  557320,
+	 557622,  557924,  558225,  558526,  558827,  559127,  559427,  559727,
+	 560026,  560325,  560624,  560922,  561220,  561518,  561815,  562112,
+	 562409,  562706,  563002,  563298,  563593,  563888,  564183,  564478,
+	 564772,  565066,  565360,  565653,  565946,  566239,  566532,  566824,
+	 567116,  567407,  567698,  567989,  568280,  568571,  568861,  569150,
+	 569440,  569729,  570018,  570307,  570595,  570883,  571171,  571458,
+	 571745,  572032,  572319,  572605,  572891,  573177,  573462,  573747,
+	 574032,  574317,  574601,  574885,  575169,  575453,  575736,  576019,
+	 576301,  576584,  576866,  577148,  577429,  577710,  577991,  578272,
+	 578552,  578833,  579113,  579392,  579672,  579951,  580229,  580508,
+	 580786,  581064,  581342,  581620,  581897,  582174,  582450,  582727,
+	 583003,  583279,  583555,  583830,  584105,  584380,  584655,  584929,
+	 585203,  585477,  585750,  586024,  586297,  586570,  586842,  587115,
+	 587387,  587658,  587930,  588201,  588472,  588743,  589014,  589284,
+	 589554,  589824,  590094,  590363,  590632,  590901,  591169,  591438,
+	 591706,  591974,  592241,  592509,  592776,  593043,  593309,  593576,
+	 593842,  594108,  594374,  594639,  594904,  595169,  595434,  595699,
+	 595963,  596227,  596491,  596754,  597018,  597281,  597544,  597806,
+	 598069,  598331,  598593,  598855,  599116,  599377,  599639,  599899,
+	 600160,  600420,  600680,  600940,  601200,  601460,  601719,  601978,
+	 602237,  602495,  602754,  603012,  603270,  603527,  603785,  604042,
+	 604299,  604556,  604813,  605069,  605325,  605581,  605837,  606092,
+	 606348,  606603,  606858,  607112,  607367,  607621,  607875,  608129,
+	 608382,  608636,  608889,  609142,  609395,  609647,  609900,  610152,
+	 610404,  610655,  610907,  611158,  611409,  611660,  611911,  612161,
+	 612411,  612662,  612911,  613161,  613411,  613660,  613909,  614158,
+	 614406,  614655,  614903,  615151,  615399,  615647,  615894,  616141,
+	 616388,  616635,  616882,  617128,  617375,  617621,  617866,  618112,
+	 618358,  618603,  618848,  619093,  619338,  619582,  619826,  620070,
+	 620314,  620558,  620802,  621045,  621288,  621531,  621774,  622017,
+	 622259,  622501,  622743,  622985,  623227,  623468,  623709,  623951,
+	 624191,  624432,  624673,  624913,  625153,  625393,  625633,  625873,
+	 626112,  626351,  626590,  626829,  627068,  627307,  627545,  627783,
+	 628021,  628259,  628496,  628734,  628971,  629208,  629445,  629682,
+	 629918,  630155,  630391,  630627,  630863,  631098,  631334,  631569,
+	 631804,  632039,  632274,  632509,  632743,  632977,  633211,  633445,
+	 633679,  633913,  634146,  634379,  634612,  634845,  635078,  635311,
+	 635543,  635775,  636007,  636239,  636471,  636702,  636934,  637165,
+	 637396,  637627,  637857,  638088,  638318,  638548,  638778,  639008,
+	 639238,  639468,  639697,  639926,  640155,  640384,  640613,  640841,
+	 641070,  641298,  641526,  641754,  641982,  642209,  642437,  642664,
+	 642891,  643118,  643345,  643571,  643798,  644024,  644250,  644476,
+	 644702,  644928,  645153,  645378,  645604,  645829,  646053,  646278,
+	 646503,  646727,  646951,  647175,  647399,  647623,  647847,  648070,
+	 648294,  648517,  648740,  648963,  649185,  649408,  649630,  649853,
+	 650075,  650297,  650518,  650740,  650961,  651183,  651404,  651625,
+	 651846,  652067,  652287,  652508,  652728,  652948,  653168,  653388,
+	 653608,  653827,  654047,  654266,  654485,  654704,  654923,  655141,
+	 655360,  655578,  655797,  656015,  656233,  656450,  656668,  656886,
+	 657103,  657320,  657537,  657754,  657971,  658188,  658404,  658621,
+	 658837,  659053,  659269,  659485,  659700,  659916,  660131,  660346,
+	 660561,  660776,  660991,  661206,  661420,  661635,  661849,  662063,
+	 662277,  662491,  662705,  662918,  663132,  663345,  663558,  663771,
+	 663984,  664197,  664410,  664622,  664834,  665047,  665259,  665471,
+	 665682,  665894,  666106,  666317,  666528,  666739,  666950,  667161,
+	 667372,  667582,  667793,  668003,  668213,  668424,  668633,  668843,
+	 669053,  669262,  669472,  669681,  669890,  670099,  670308,  670517,
+	 670726,  670934,  671142,  671351,  671559,  671767,  671975,  672182,
+	 672390,  672597,  672805,  673012,  673219,  673426,  673633,  673839,
+	 674046,  674252,  674459,  674665,  674871,  675077,  675283,  675489,
+	 675694,  675900,  676105,  676310,  676515,  676720,  676925,  677130,
+	 677334,  677539,  677743,  677947,  678151,  678355,  678559,  678763,
+	 678966,  679170,  679373,  679576,  679779,  679982,  680185,  680388,
+	 680591,  680793,  680995,  681198,  681400,  681602,  681804,  682006,
+	 682207,  682409,  682610,  682811,  683013,  683214,  683415,  683615,
+	 683816,  684017,  684217,  684418,  684618,  684818,  685018,  685218,
+	 685418,  685617,  685817,  686016,  686216,  686415,  686614,  686813,
+	 687012,  687210,  687409,  687607,  687806,  688004,  688202,  688400,
+	 688598,  688796,  688994,  689191,  689389,  689586,  689783,  689981,
+	 690178,  690375,  690571,  690768,  690965,  691161,  691357,  691554,
+	 691750,  691946,  692142,  692338,  692533,  692729,  692924,  693120,
+	 693315,  693510,  693705,  693900,  694095,  694289,  694484,  694678,
+	 694873,  695067,  695261,  695455,  695649,  695843,  696037,  696230,
+	 696424,  696617,  696811,  697004,  697197,  697390,  697583,  697775,
+	 697968,  698161,  698353,  698545,  698738,  698930,  699122,  699314,
+	 699505,  699697,  699889,  700080,  700272,  700463,  700654,  700845,
+	 701036,  701227,  701418,  701608,  701799,  701989,  702180,  702370,
+	 702560,  702750,  702940,  703130,  703320,  703509,  703699,  703888,
+	 704078,  704267,  704456,  704645,  704834,  705023,  705211,  705400,
+	 705588,  705777,  705965,  706153,  706341,  706529,  706717,  706905,
+	 707093,  707281,  707468,  707655,  707843,  708030,  708217,  708404,
+	 708591,  708778,  708965,  709151,  709338,  709524,  709710,  709897,
+	 710083,  710269,  710455,  710641,  710826,  711012,  711197,  711383,
+	 711568,  711754,  711939,  712124,  712309,  712494,  712678,  712863,
+	 713048,  713232,  713417,  713601,  713785,  713969,  714153,  714337,
+	 714521,  714705,  714888,  715072,  715255,  715439,  715622,  715805,
+	 715988,  716171,  716354,  716537,  716719,  716902,  717085,  717267,
+	 717449,  717632,  717814,  717996,  718178,  718360,  718541,  718723,
+	 718905,  719086,  719267,  719449,  719630,  719811,  719992,  720173,
+	 720354,  720535,  720715,  720896,  721076,  721257,  721437,  721617,
+	 721798,  721978,  722158,  722337,  722517,  722697,  722876,  723056,
+	 723235,  723415,  723594,  723773,  723952,  724131,  724310,  724489,
+	 724668,  724846,  725025,  725203,  725382,  725560,  725738,  725916,
+	 726094,  726272,  726450,  726628,  726805,  726983,  727160,  727338,
+	 727515,  727692,  727869,  728046,  728223,  728400,  728577,  728754,
+	 728930,  729107,  729283,  729460,  729636,  729812,  729988,  730164,
+	 730340,  730516,  730692,  730868,  731043,  731219,  731394,  731570,
+	 731745,  731920,  732095,  732270,  732445,  732620,  732795,  732969,
+	 733144,  733319,  733493,  733667,  733842,  734016,  734190,  734364,
+	 734538,  734712,  734885,  735059,  735233,  735406,  735580,  735753,
+	 735926,  736100,  736273,  736446,  736619,  736792,  736964,  737137,
+	 737310,  737482,  737655,  737827,  737999,  738172,  738344,  738516,
+	 738688,  738860,  739032,  739203,  739375,  739547,  739718,  739889,
+	 740061,  740232,  740403,  740574,  740745,  740916,  741087,  741258,
+	 741429,  741599,  741770,  741940,  742111,  742281,  742451,  742622,
+	 742792,  742962,  743132,  743302,  743471,  743641,  743811,  743980,
+	 744150,  744319,  744488,  744658,  744827,  744996,  745165,  745334,
+	 745503,  745671,  745840,  746009,  746177,  746346,  746514,  746683,
+	 746851,  747019,  747187,  747355,  747523,  747691,  747859,  748026,
+	 748194,  748362,  748529,  748697,  748864,  749031,  749198,  749365,
+	 749532,  749699,  749866,  750033,  750200,  750367,  750533,  750700,
+	 750866,  751033,  751199,  751365,  751531,  751697,  751863,  752029,
+	 752195,  752361,  752527,  752692,  752858,  753023,  753189,  753354,
+	 753519,  753685,  753850,  754015,  754180,  754345,  754510,  754674,
+	 754839,  755004,  755168,  755333,  755497,  755662,  755826,  755990,
+	 756154,  756318,  756482,  756646,  756810,  756974,  757137,  757301,
+	 757465,  757628,  757792,  757955,  758118,  758281,  758445,  758608,
+	 758771,  758934,  759096,  759259,  759422,  759585,  759747,  759910,
+	 760072,  760234,  760397,  760559,  760721,  760883,  761045,  761207,
+	 761369,  761531,  761693,  761854,  762016,  762178,  762339,  762500,
+	 762662,  762823,  762984,  763145,  763306,  763467,  763628,  763789,
+	 763950,  764111,  764271,  764432,  764593,  764753,  764913,  765074,
+	 765234,  765394,  765554,  765714,  765874,  766034,  766194,  766354,
+	 766514,  766673,  766833,  766992,  767152,  767311,  767471,  767630,
+	 767789,  767948,  768107,  768266,  768425,  768584,  768743,  768902,
+	 769060,  769219,  769377,  769536,  769694,  769853,  770011,  770169,
+	 770327,  770485,  770643,  770801,  770959,  771117,  771275,  771432,
+	 771590,  771748,  771905,  772063,  772220,  772377,  772535,  772692,
+	 772849,  773006,  773163,  773320,  773477,  773633,  773790,  773947,
+	 774103,  774260,  774416,  774573,  774729,  774886,  775042,  775198,
+	 775354,  775510,  775666,  775822,  775978,  776134,  776289,  776445,
+	 776601,  776756,  776912,  777067,  777222,  777378,  777533,  777688,
+	 777843,  777998,  778153,  778308,  778463,  778618,  778772,  778927,
+	 779082,  779236,  779391,  779545,  779700,  779854,  780008,  780162,
+	 780316,  780470,  780624,  780778,  780932,  781086,  781240,  781394,
+	 781547,  781701,  781854,  782008,  782161,  782314,  782468,  782621,
+	 782774,  782927,  783080,  783233,  783386,  783539,  783692,  783845,
+	 783997,  784150,  784302,  784455,  784607,  784760,  784912,  785064,
+	 785216,  785369,  785521,  785673,  785825,  785977,  786128,  786280,
+	 786432,  786584,  786735,  786887,  787038,  787190,  787341,  787492,
+	 787644,  787795,  787946,  788097,  788248,  788399,  788550,  788701,
+	 788852,  789003,  789153,  789304,  789454,  789605,  789755,  789906,
+	 790056,  790206,  790357,  790507,  790657,  790807,  790957,  791107,
+	 791257,  791407,  791556,  791706,  791856,  792005,  792155,  792304,
+	 792454,  792603,  792753,  792902,  793051,  793200,  793349,  793498,
+	 793647,  793796,  793945,  794094,  794243,  794391,  794540,  794689,
+	 794837,  794986,  795134,  795283,  795431,  795579,  795727,  795875,
+	 796024,  796172,  796320,  796468,  796615,  796763,  796911,  797059,
+	 797206,  797354,  797502,  797649,  797796,  797944,  798091,  798238,
+	 798386,  798533,  798680,  798827,  798974,  799121,  799268,  799415,
+	 799562,  799708,  799855,  800002,  800148,  800295,  800441,  800588,
+	 800734,  800880,  801026,  801173,  801319,  801465,  801611,  801757,
+	 801903,  802049,  802195,  802340,  802486,  802632,  802777,  802923,
+	 803068,  803214,  803359,  803505,  803650,  803795,  803940,  804085,
+	 804231,  804376,  804521,  804666,  804810,  804955,  805100,  805245,
+	 805389,  805534,  805679,  805823,  805968,  806112,  806256,  806401,
+	 806545,  806689,  806833,  806977,  807121,  807265,  807409,  807553,
+	 807697,  807841,  807985,  808128,  808272,  808416,  808559,  808703,
+	 808846,  808989,  809133,  809276,  809419,  809562,  809706,  809849,
+	 809992,  810135,  810278,  810421,  810563,  810706,  810849,  810992,
+	 811134,  811277,  811419,  811562,  811704,  811847,  811989,  812131,
+	 812273,  812416,  812558,  812700,  812842,  812984,  813126,  813268,
+	 813409,  813551,  813693,  813835,  813976,  814118,  814259,  814401,
+	 814542,  814684,  814825,  814966,  815108,  815249,  815390,  815531,
+	 815672,  815813,  815954,  816095,  816236,  816377,  816517,  816658,
+	 816799,  816939,  817080,  817220,  817361,  817501,  817642,  817782,
+	 817922,  818062,  818203,  818343,  818483,  818623,  818763,  818903,
+	 819043,  819183,  819322,  819462,  819602,  819741,  819881,  820021,
+	 820160,  820300,  820439,  820578,  820718,  820857,  820996,  821135,
+	 821274,  821413,  821553,  821692,  821830,  821969,  822108,  822247,
+	 822386,  822524,  822663,  822802,  822940,  823079,  823217,  823356,
+	 823494,  823632,  823771,  823909,  824047,  824185,  824323,  824461,
+	 824599,  824737,  824875,  825013,  825151,  825289,  825427,  825564,
+	 825702,  825839,  825977,  826115,  826252,  826389,  826527,  826664,
+	 826801,  826939,  827076,  827213,  827350,  827487,  827624,  827761,
+	 827898,  828035,  828172,  828308,  828445,  828582,  828718,  828855,
+	 828992,  829128,  829265,  829401,  829537,  829674,  829810,  829946,
+	 830082,  830218,  830355,  830491,  830627,  830763,  830899,  831034,
+	 831170,  831306,  831442,  831577,  831713,  831849,  831984,  832120,
+	 832255,  832391,  832526,  832661,  832797,  832932,  833067,  833202,
+	 833338,  833473,  833608,  833743,  833878,  834013,  834147,  834282,
+	 834417,  834552,  834686,  834821,  834956,  835090,  835225,  835359,
+	 835494,  835628,  835762,  835897,  836031,  836165,  836299,  836434,
+	 836568,  836702,  836836,  836970,  837104,  837237,  837371,  837505,
+	 837639,  837772,  837906,  838040,  838173,  838307,  838440,  838574,
+	 838707,  838841,  838974,  839107,  839240,  839374,  839507,  839640,
+	 839773,  839906,  840039,  840172,  840305,  840438,  840570,  840703,
+	 840836,  840969,  841101,  841234,  841366,  841499,  841631,  841764,
+	 841896,  842029,  842161,  842293,  842425,  842558,  842690,  842822,
+	 842954,  843086,  843218,  843350,  843482,  843614,  843745,  843877,
+	 844009,  844141,  844272,  844404,  844535,  844667,  844798,  844930,
+	 845061,  845193,  845324,  845455,  845586,  845718,  845849,  845980,
+	 846111,  846242,  846373,  846504,  846635,  846766,  846897,  847027,
+	 847158,  847289,  847420,  847550,  847681,  847811,  847942,  848072,
+	 848203,  848333,  848464,  848594,  848724,  848854,  848985,  849115,
+	 849245,  849375,  849505,  849635,  849765,  849895,  850025,  850154,
+	 850284,  850414,  850544,  850673,  850803,  850933,  851062,  851192,
+	 851321,  851451,  851580,  851709,  851839,  851968,  852097,  852226,
+	 852356,  852485,  852614,  852743,  852872,  853001,  853130,  853259,
+	 853388,  853516,  853645,  853774,  853903,  854031,  854160,  854288,
+	 854417,  854545,  854674,  854802,  854931,  855059,  855187,  855316,
+	 855444,  855572,  855700,  855828,  855956,  856084,  856212,  856340,
+	 856468,  856596,  856724,  856852,  856980,  857107,  857235,  857363,
+	 857490,  857618,  857746,  857873,  858001,  858128,  858255,  858383,
+	 858510,  858637,  858765,  858892,  859019,  859146,  859273,  859400,
+	 859527,  859654,  859781,  859908,  860035,  860162,  860289,  860415,
+	 860542,  860669,  860795,  860922,  861048,  861175,  861302,  861428,
+	 861554,  861681,  861807,  861933,  862060,  862186,  862312,  862438,
+	 862564,  862691,  862817,  862943,  863069,  863195,  863320,  863446,
+	 863572,  863698,  863824,  863949,  864075,  864201,  864326,  864452,
+	 864577,  864703,  864828,  864954,  865079,  865205,  865330,  865455,
+	 865580,  865706,  865831,  865956,  866081,  866206,  866331,  866456,
+	 866581,  866706,  866831,  866956,  867081,  867205,  867330,  867455,
+	 867579,  867704,  867829,  867953,  868078,  868202,  868327,  868451,
+	 868576,  868700,  868824,  868948,  869073,  869197,  869321,  869445,
+	 869569,  869693,  869817,  869941,  870065,  870189,  870313,  870437,
+	 870561,  870685,  870808,  870932,  871056,  871179,  871303,  871427,
+	 871550,  871674,  871797,  871921,  872044,  872167,  872291,  872414,
+	 872537,  872660,  872784,  872907,  873030,  873153,  873276,  873399,
+	 873522,  873645,  873768,  873891,  874014,  874136,  874259,  874382,
+	 874505,  874627,  874750,  874872,  874995,  875118,  875240,  875363,
+	 875485,  875607,  875730,  875852,  875974,  876097,  876219,  876341,
+	 876463,  876585,  876707,  876829,  876951,  877073,  877195,  877317,
+	 877439,  877561,  877683,  877805,  877926,  878048,  878170,  878291,
+	 878413,  878535,  878656,  878778,  878899,  879021,  879142,  879263,
+	 879385,  879506,  879627,  879749,  879870,  879991,  880112,  880233,
+	 880354,  880475,  880596,  880717,  880838,  880959,  881080,  881201,
+	 881322,  881442,  881563,  881684,  881805,  881925,  882046,  882166,
+	 882287,  882407,  882528,  882648,  882769,  882889,  883010,  883130,
+	 883250,  883370,  883491,  883611,  883731,  883851,  883971,  884091,
+	 884211,  884331,  884451,  884571,  884691,  884811,  884931,  885051,
+	 885170,  885290,  885410,  885529,  885649,  885769,  885888,  886008,
+	 886127,  886247,  886366,  886486,  886605,  886724,  886844,  886963,
+	 887082,  887201,  887321,  887440,  887559,  887678,  887797,  887916,
+	 888035,  888154,  888273,  888392,  888511,  888629,  888748,  888867,
+	 888986,  889104,  889223,  889342,  889460,  889579,  889697,  889816,
+	 889934,  890053,  890171,  890290,  890408,  890526,  890645,  890763,
+	 890881,  890999,  891118,  891236,  891354,  891472,  891590,  891708,
+	 891826,  891944,  892062,  892180,  892298,  892415,  892533,  892651,
+	 892769,  892886,  893004,  893122,  893239,  893357,  893474,  893592,
+	 893709,  893827,  893944,  894062,  894179,  894296,  894414,  894531,
+	 894648,  894765,  894883,  895000,  895117,  895234,  895351,  895468,
+	 895585,  895702,  895819,  895936,  896053,  896170,  896286,  896403,
+	 896520,  896637,  896753,  896870,  896987,  897103,  897220,  897336,
+	 897453,  897569,  897686,  897802,  897918,  898035,  898151,  898267,
+	 898384,  898500,  898616,  898732,  898849,  898965,  899081,  899197,
+	 899313,  899429,  899545,  899661,  899777,  899892,  900008,  900124,
+	 900240,  900356,  900471,  900587,  900703,  900818,  900934,  901050,
+	 901165,  901281,  901396,  901512,  901627,  901742,  901858,  901973,
+	 902088,  902204,  902319,  902434,  902549,  902665,  902780,  902895,
+	 903010,  903125,  903240,  903355,  903470,  903585,  903700,  903815,
+	 903929,  904044,  904159,  904274,  904389,  904503,  904618,  904733,
+	 904847,  904962,  905076,  905191,  905305,  905420,  905534,  905649,
+	 905763,  905877,  905992,  906106,  906220,  906334,  906449,  906563,
+	 906677,  906791,  906905,  907019,  907133,  907247,  907361,  907475,
+	 907589,  907703,  907817,  907931,  908045,  908158,  908272,  908386,
+	 908499,  908613,  908727,  908840,  908954,  909067,  909181,  909294,
+	 909408,  909521,  909635,  909748,  909862,  909975,  910088,  910201,
+	 910315,  910428,  910541,  910654,  910767,  910880,  910993,  911107,
+	 911220,  911333,  911445,  911558,  911671,  911784,  911897,  912010,
+	 912123,  912235,  912348,  912461,  912573,  912686,  912799,  912911,
+	 913024,  913136,  913249,  913361,  913474,  913586,  913699,  913811,
+	 913923,  914036,  914148,  914260,  914373,  914485,  914597,  914709,
+	 914821,  914933,  915045,  915157,  915269,  915381,  915493,  915605,
+	 915717,  915829,  915941,  916053,  916165,  916276,  916388,  916500,
+	 916611,  916723,  916835,  916946,  917058,  917170,  917281,  917393,
+	 917504,  917615,  917727,  917838,  917950,  918061,  918172,  918284,
+	 918395,  918506,  918617,  918728,  918840,  918951,  919062,  919173,
+	 919284,  919395,  919506,  919617,  919728,  919839,  919950,  920060,
+	 920171,  920282,  920393,  920503,  920614,  920725,  920836,  920946,
+	 921057,  921167,  921278,  921388,  921499,  921609,  921720,  921830,
+	 921941,  922051,  922161,  922272,  922382,  922492,  922603,  922713,
+	 922823,  922933,  923043,  923153,  923263,  923374,  923484,  923594,
+	 923704,  923813,  923923,  924033,  924143,  924253,  924363,  924473,
+	 924582,  924692,  924802,  924912,  925021,  925131,  925240,  925350,
+	 925460,  925569,  925679,  925788,  925898,  926007,  926116,  926226,
+	 926335,  926445,  926554,  926663,  926772,  926882,  926991,  927100,
+	 927209,  927318,  927427,  927536,  927645,  927754,  927863,  927972,
+	 928081,  928190,  928299,  928408,  928517,  928626,  928734,  928843,
+	 928952,  929061,  929169,  929278,  929387,  929495,  929604,  929712,
+	 929821,  929929,  930038,  930146,  930255,  930363,  930472,  930580,
+	 930688,  930797,  930905,  931013,  931121,  931230,  931338,  931446,
+	 931554,  931662,  931770,  931878,  931986,  932094,  932202,  932310,
+	 932418,  932526,  932634,  932742,  932850,  932958,  933065,  933173,
+	 933281,  933388,  933496,  933604,  933711,  933819,  933927,  934034,
+	 934142,  934249,  934357,  934464,  934572,  934679,  934786,  934894,
+	 935001,  935108,  935216,  935323,  935430,  935537,  935645,  935752,
+	 935859,  935966,  936073,  936180,  936287,  936394,  936501,  936608,
+	 936715,  936822,  936929,  937036,  937143,  937250,  937356,  937463,
+	 937570,  937677,  937783,  937890,  937997,  938103,  938210,  938316,
+	 938423,  938529,  938636,  938742,  938849,  938955,  939062,  939168,
+	 939275,  939381,  939487,  939593,  939700,  939806,  939912,  940018,
+	 940125,  940231,  940337,  940443,  940549,  940655,  940761,  940867,
+	 940973,  941079,  941185,  941291,  941397,  941503,  941608,  941714,
+	 941820,  941926,  942031,  942137,  942243,  942349,  942454,  942560,
+	 942665,  942771,  942877,  942982,  943088,  943193,  943298,  943404,
+	 943509,  943615,  943720,  943825,  943931,  944036,  944141,  944247,
+	 944352,  944457,  944562,  944667,  944772,  944878,  944983,  945088,
+	 945193,  945298,  945403,  945508,  945613,  945717,  945822,  945927,
+	 946032,  946137,  946242,  946347,  946451,  946556,  946661,  946765,
+	 946870,  946975,  947079,  947184,  947288,  947393,  947498,  947602,
+	 947707,  947811,  947915,  948020,  948124,  948229,  948333,  948437,
+	 948541,  948646,  948750,  948854,  948958,  949063,  949167,  949271,
+	 949375,  949479,  949583,  949687,  949791,  949895,  949999,  950103,
+	 950207,  950311,  950415,  950519,  950623,  950726,  950830,  950934,
+	 951038,  951141,  951245,  951349,  951452,  951556,  951660,  951763,
+	 951867,  951970,  952074,  952177,  952281,  952384,  952488,  952591,
+	 952695,  952798,  952901,  953005,  953108,  953211,  953314,  953418,
+	 953521,  953624,  953727,  953830,  953933,  954036,  954140,  954243,
+	 954346,  954449,  954552,  954655,  954758,  954860,  954963,  955066,
+	 955169,  955272,  955375,  955477,  955580,  955683,  955786,  955888,
+	 955991,  956094,  956196,  956299,  956402,  956504,  956607,  956709,
+	 956812,  956914,  957017,  957119,  957221,  957324,  957426,  957529,
+	 957631,  957733,  957835,  957938,  958040,  958142,  958244,  958346,
+	 958449,  958551,  958653,  958755,  958857,  958959,  959061,  959163,
+	 959265,  959367,  959469,  959571,  959673,  959775,  959876,  959978,
+	 960080,  960182,  960284,  960385,  960487,  960589,  960690,  960792,
+	 960894,  960995,  961097,  961198,  961300,  961401,  961503,  961604,
+	 961706,  961807,  961909,  962010,  962112,  962213,  962314,  962416,
+	 962517,  962618,  962719,  962821,  962922,  963023,  963124,  963225,
+	 963326,  963427,  963528,  963630,  963731,  963832,  963933,  964034,
+	 964134,  964235,  964336,  964437,  964538,  964639,  964740,  964841,
+	 964941,  965042,  965143,  965243,  965344,  965445,  965546,  965646,
+	 965747,  965847,  965948,  966048,  966149,  966249,  966350,  966450,
+	 966551,  966651,  966752,  966852,  966952,  967053,  967153,  967253,
+	 967354,  967454,  967554,  967654,  967755,  967855,  967955,  968055,
+	 968155,  968255,  968355,  968455,  968555,  968655,  968755,  968855,
+	 968955,  969055,  969155,  969255,  969355,  969455,  969554,  969654,
+	 969754,  969854,  969954,  970053,  970153,  970253,  970352,  970452,
+	 970552,  970651,  970751,  970850,  970950,  971049,  971149,  971248,
+	 971348,  971447,  971547,  971646,  971745,  971845,  971944,  972043,
+	 972143,  972242,  972341,  972440,  972540,  972639,  972738,  972837,
+	 972936,  973035,  973134,  973233,  973333,  973432,  973531,  973630,
+	 973728,  973827,  973926,  974025,  974124,  974223,  974322,  974421,
+	 974519,  974618,  974717,  974816,  974915,  975013,  975112,  975211,
+	 975309,  975408,  975506,  975605,  975704,  975802,  975901,  975999,
+	 976098,  976196,  976295,  976393,  976491,  976590,  976688,  976787,
+	 976885,  976983,  977081,  977180,  977278,  977376,  977474,  977573,
+	 977671,  977769,  977867,  977965,  978063,  978161,  978259,  978357,
+	 978455,  978553,  978651,  978749,  978847,  978945,  979043,  979141,
+	 979239,  979337,  979434,  979532,  979630,  979728,  979826,  979923,
+	 980021,  980119,  980216,  980314,  980412,  980509,  980607,  980704,
+	 980802,  980899,  980997,  981094,  981192,  981289,  981387,  981484,
+	 981581,  981679,  981776,  981874,  981971,  982068,  982165,  982263,
+	 982360,  982457,  982554,  982651,  982749,  982846,  982943,  983040,
+	 983137,  983234,  983331,  983428,  983525,  983622,  983719,  983816,
+	 983913,  984010,  984107,  984204,  984301,  984397,  984494,  984591,
+	 984688,  984785,  984881,  984978,  985075,  985171,  985268,  985365,
+	 985461,  985558,  985654,  985751,  985848,  985944,  986041,  986137,
+	 986234,  986330,  986426,  986523,  986619,  986716,  986812,  986908,
+	 987005,  987101,  987197,  987294,  987390,  987486,  987582,  987678,
+	 987775,  987871,  987967,  988063,  988159,  988255,  988351,  988447,
+	 988543,  988639,  988735,  988831,  988927,  989023,  989119,  989215,
+	 989311,  989407,  989502,  989598,  989694,  989790,  989886,  989981,
+	 990077,  990173,  990268,  990364,  990460,  990555,  990651,  990747,
+	 990842,  990938,  991033,  991129,  991224,  991320,  991415,  991511,
+	 991606,  991702,  991797,  991892,  991988,  992083,  992178,  992274,
+	 992369,  992464,  992559,  992655,  992750,  992845,  992940,  993035,
+	 993131,  993226,  993321,  993416,  993511,  993606,  993701,  993796,
+	 993891,  993986,  994081,  994176,  994271,  994366,  994461,  994555,
+	 994650,  994745,  994840,  994935,  995029,  995124,  995219,  995314,
+	 995408,  995503,  995598,  995692,  995787,  995882,  995976,  996071,
+	 996165,  996260,  996354,  996449,  996543,  996638,  996732,  996827,
+	 996921,  997016,  997110,  997204,  997299,  997393,  997487,  997582,
+	 997676,  997770,  997864,  997959,  998053,  998147,  998241,  998335,
+	 998429,  998523,  998618,  998712,  998806,  998900,  998994,  999088,
+	 999182,  999276,  999370,  999464,  999558,  999651,  999745,  999839,
+	 999933, 1000027, 1000121, 1000214, 1000308, 1000402, 1000496, 1000589,
+	1000683, 1000777, 1000871, 1000964, 1001058, 1001151, 1001245, 1001339,
+	1001432, 1001526, 1001619, 1001713, 1001806, 1001900, 1001993, 1002087,
+	1002180, 1002273, 1002367, 1002460, 1002554, 1002647, 1002740, 1002834,
+	1002927, 1003020, 1003113, 1003207, 1003300, 1003393, 1003486, 1003579,
+	1003673, 1003766, 1003859, 1003952, 1004045, 1004138, 1004231, 1004324,
+	1004417, 1004510, 1004603, 1004696, 1004789, 1004882, 1004975, 1005068,
+	1005161, 1005253, 1005346, 1005439, 1005532, 1005625, 1005717, 1005810,
+	1005903, 1005996, 1006088, 1006181, 1006274, 1006366, 1006459, 1006552,
+	1006644, 1006737, 1006829, 1006922, 1007014, 1007107, 1007199, 1007292,
+	1007384, 1007477, 1007569, 1007662, 1007754, 1007846, 1007939, 1008031,
+	1008123, 1008216, 1008308, 1008400, 1008493, 1008585, 1008677, 1008769,
+	1008861, 1008954, 1009046, 1009138, 1009230, 1009322, 1009414, 1009506,
+	1009598, 1009690, 1009782, 1009874, 1009966, 1010058, 1010150, 1010242,
+	1010334, 1010426, 1010518, 1010610, 1010702, 1010794, 1010885, 1010977,
+	1011069, 1011161, 1011253, 1011344, 1011436, 1011528, 1011619, 1011711,
+	1011803, 1011894, 1011986, 1012078, 1012169, 1012261, 1012352, 1012444,
+	1012535, 1012627, 1012718, 1012810, 1012901, 1012993, 1013084, 1013176,
+	1013267, 1013358, 1013450, 1013541, 1013632, 1013724, 1013815, 1013906,
+	1013998, 1014089, 1014180, 1014271, 1014362, 1014454, 1014545, 1014636,
+	1014727, 1014818, 1014909, 1015000, 1015091, 1015182, 1015274, 1015365,
+	1015456, 1015547, 1015637, 1015728, 1015819, 1015910, 1016001, 1016092,
+	1016183, 1016274, 1016365, 1016455, 1016546, 1016637, 1016728, 1016819,
+	1016909, 1017000, 1017091, 1017181, 1017272, 1017363, 1017453, 1017544,
+	1017635, 1017725, 1017816, 1017906, 1017997, 1018087, 1018178, 1018268,
+	1018359, 1018449, 1018540, 1018630, 1018721, 1018811, 1018901, 1018992,
+	1019082, 1019173, 1019263, 1019353, 1019443, 1019534, 1019624, 1019714,
+	1019804, 1019895, 1019985, 1020075, 1020165, 1020255, 1020345, 1020436,
+	1020526, 1020616, 1020706, 1020796, 1020886, 1020976, 1021066, 1021156,
+	1021246, 1021336, 1021426, 1021516, 1021606, 1021695, 1021785, 1021875,
+	1021965, 1022055, 1022145, 1022234, 1022324, 1022414, 1022504, 1022594,
+	1022683, 1022773, 1022863, 1022952, 1023042, 1023132, 1023221, 1023311,
+	1023400, 1023490, 1023580, 1023669, 1023759, 1023848, 1023938, 1024027,
+	1024117, 1024206, 1024295, 1024385, 1024474, 1024564, 1024653, 1024742,
+	1024832, 1024921, 1025010, 1025100, 1025189, 1025278, 1025367, 1025457,
+	1025546, 1025635, 1025724, 1025813, 1025903, 1025992, 1026081, 1026170,
+	1026259, 1026348, 1026437, 1026526, 1026615, 1026704, 1026793, 1026882,
+	1026971, 1027060, 1027149, 1027238, 1027327, 1027416, 1027505, 1027594,
+	1027682, 1027771, 1027860, 1027949, 1028038, 1028126, 1028215, 1028304,
+	1028393, 1028481, 1028570, 1028659, 1028747, 1028836, 1028925, 1029013,
+	1029102, 1029190, 1029279, 1029368, 1029456, 1029545, 1029633, 1029722,
+	1029810, 1029899, 1029987, 1030076, 1030164, 1030252, 1030341, 1030429,
+	1030517, 1030606, 1030694, 1030782, 1030871, 1030959, 1031047, 1031136,
+	1031224, 1031312, 1031400, 1031488, 1031577, 1031665, 1031753, 1031841,
+	1031929, 1032017, 1032105, 1032193, 1032281, 1032369, 1032457, 1032546,
+	1032634, 1032721, 1032809, 1032897, 1032985, 1033073, 1033161, 1033249,
+	1033337, 1033425, 1033513, 1033600, 1033688, 1033776, 1033864, 1033952,
+	1034039, 1034127, 1034215, 1034303, 1034390, 1034478, 1034566, 1034653,
+	1034741, 1034829, 1034916, 1035004, 1035091, 1035179, 1035266, 1035354,
+	1035441, 1035529, 1035616, 1035704, 1035791, 1035879, 1035966, 1036054,
+	1036141, 1036229, 1036316, 1036403, 1036491, 1036578, 1036665, 1036753,
+	1036840, 1036927, 1037014, 1037102, 1037189, 1037276, 1037363, 1037450,
+	1037538, 1037625, 1037712, 1037799, 1037886, 1037973, 1038060, 1038147,
+	1038234, 1038321, 1038408, 1038495, 1038582, 1038669, 1038756, 1038843,
+	1038930, 1039017, 1039104, 1039191, 1039278, 1039365, 1039451, 1039538,
+	1039625, 1039712, 1039799, 1039886, 1039972, 1040059, 1040146, 1040232,
+	1040319, 1040406, 1040493, 1040579, 1040666, 1040752, 1040839, 1040926,
+	1041012, 1041099, 1041185, 1041272, 1041358, 1041445, 1041531, 1041618,
+	1041704, 1041791, 1041877, 1041964, 1042050, 1042137, 1042223, 1042309,
+	1042396, 1042482, 1042568, 1042655, 1042741, 1042827, 1042913, 1043000,
+	1043086, 1043172, 1043258, 1043345, 1043431, 1043517, 1043603, 1043689,
+	1043775, 1043862, 1043948, 1044034, 1044120, 1044206, 1044292, 1044378,
+	1044464, 1044550, 1044636, 1044722, 1044808, 1044894, 1044980, 1045066,
+	1045151, 1045237, 1045323, 1045409, 1045495, 1045581, 1045667, 1045752,
+	1045838, 1045924, 1046010, 1046095, 1046181, 1046267, 1046353, 1046438,
+	1046524, 1046610, 1046695, 1046781, 1046867, 1046952, 1047038, 1047123,
+	1047209, 1047294, 1047380, 1047465, 1047551, 1047636, 1047722, 1047807,
+	1047893, 1047978, 1048064, 1048149, 1048235, 1048320, 1048405, 1048491,
+	1048576, 1048661, 1048747, 1048832, 1048917, 1049002, 1049088, 1049173
+};
+
+/* f(t) in Q20 for t in Q24 */
+MU_INLINE MU_32S muLabF(MU_32S t)
+{
+	MU_32S idx = t >> (MU_LAB_TBITS - MU_LAB_GRID);
+	MU_32S fr = t & ((1 << (MU_LAB_TBITS - MU_LAB_GRID)) - 1);
+
+	return muLabCbrt[idx] + (((muLabCbrt[idx+1] - muLabCbrt[idx])*fr) >> (MU_LAB_TBITS - MU_LAB_GRID));
+}
+
+/*===========================================================================================*/
+/*   muRGB2LAB                                                                               */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine transforms a BGR image to CIE L*a*b* (D65) in one pass, without the        */
+/*   intermediate XYZ image of muRGB2XYZ + muXYZ2LAB.                                        */
+/*                                                                                           */
+/*   NOTE                                                                                    */
+/*   dst MU_IMG_DEPTH_32F -> L* 0~100, a*, b* as floats                                      */
+/*   dst MU_IMG_DEPTH_8U  -> L*255/100, a*+128, b*+128 rounded and saturated                 */
+/*   Error bounds over all 2^24 colors against the double precision formulas:               */
+/*     32F: |dL*| < 0.001, |da*| < 0.003, |db*| < 0.002; 8U: within 1 of the rounded value. */
+/*   muRGB2XYZ + muXYZ2LAB (float, exponent 0.3333) are up to 0.018 off the same reference, */
+/*   the two results differ by less than 0.02.                                               */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muImage_t *src --> BGR image                                                            */
+/*   muImage_t *dst --> LAB image                                                            */
+/*===========================================================================================*/
+muError_t muRGB2LAB(const muImage_t *src, muImage_t *dst)
+{
+	MU_32S j, width, height;
+
+	if(src == NULL || dst == NULL || src->imagedata == NULL || dst->imagedata == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	if(src->depth != MU_IMG_DEPTH_8U || (dst->depth != MU_IMG_DEPTH_32F && dst->depth != MU_IMG_DEPTH_8U) ||
+	   src->channels != 3 || dst->channels != 3)
+	{
+		return MU_ERR_NOT_SUPPORT;
+	}
+
+	width = src->width;
+	height = src->height;
+
+#pragma omp parallel for
+	for(j=0; j<height; j++)
+	{
+		const MU_8U *in = src->imagedata + j*width*3;
+		MU_32F *out32 = (MU_32F *)dst->imagedata + j*width*3;
+		MU_8U *out8 = dst->imagedata + j*width*3;
+		MU_32S i, b, g, r, fx, fy, fz, v;
+
+		for(i=0; i<width; i++)
+		{
+			b = in[i*3]; g = in[i*3+1]; r = in[i*3+2];
+
+			fx = muLabF(muLabTab[0][0][b] + muLabTab[1][0][g] + muLabTab[2][0][r]);
+			fy = muLabF(muLabTab[0][1][b] + muLabTab[1][1][g] + muLabTab[2][1][r]);
+			fz = muLabF(muLabTab[0][2][b] + muLabTab[1][2][g] + muLabTab[2][2][r]);
+
+			if(dst->depth == MU_IMG_DEPTH_32F)
+			{
+				out32[i*3]   = fy*(116.0F/(1 << MU_LAB_FBITS)) - 16.0F;
+				out32[i*3+1] = (fx - fy)*(500.0F/(1 << MU_LAB_FBITS));
+				out32[i*3+2] = (fy - fz)*(200.0F/(1 << MU_LAB_FBITS));
+			}
+			else
+			{
+				/* L*255/100 = (116*fy - 16)*2.55, a* + 128 and b* + 128, all from Q20 */
+				v = (MU_32S)(((MU_64S)fy*2958 - (MU_64S)408*(1 << MU_LAB_FBITS) + ((MU_64S)5 << MU_LAB_FBITS)) / (10 << MU_LAB_FBITS));
+				out8[i*3]   = (MU_8U)(v < 0 ? 0 : v > 255 ? 255 : v);
+				v = ((fx - fy)*500 + (128 << MU_LAB_FBITS) + (1 << (MU_LAB_FBITS - 1))) >> MU_LAB_FBITS;
+				out8[i*3+1] = (MU_8U)(v < 0 ? 0 : v > 255 ? 255 : v);
+				v = ((fy - fz)*200 + (128 << MU_LAB_FBITS) + (1 << (MU_LAB_FBITS - 1))) >> MU_LAB_FBITS;
+				out8[i*3+2] = (MU_8U)(v < 0 ? 0 : v > 255 ? 255 : v);
+			}
+		}
+	}
+
+	return MU_ERR_SUCCESS;
+}
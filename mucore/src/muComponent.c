@@ -232,6 +232,180 @@ muError_t mu4ConnectedComponent8u(muImage_t * src, muImage_t * dst, MU_8U *numla
 }
 
 
+/*===========================================================================================*/
+/*   muConnectedComponents                                                                   */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine labels the non-zero connected components of src with 32-bit labels. The    */
+/*   first pass encodes src to runs (muRLEThreshold) and unites touching runs of adjacent    */
+/*   rows in a union-find forest (muRLELabel). The second pass walks the runs once,          */
+/*   writing each label and adding its run to the statistics: area, bounding box, the        */
+/*   first-order moments m10 = sum of x and m01 = sum of y, and the centroid. The cost       */
+/*   is O(pixels) whatever the number of components.                                         */
+/*                                                                                           */
+/*   NOTE                                                                                    */
+/*   Labels run from 1 to num in raster order of the first pixel, 0 is the background.       */
+/*   stats[i] describes label i+1 and is released with muReleaseComponentStats, it is NULL   */
+/*   when there is no component. labels or stats may be NULL when not wanted.                */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muImage_t *src --> input 8U mask                                                        */
+/*   muImage_t *labels --> output 32S label image of the src size, or NULL                   */
+/*   connectivity --> 4 or 8                                                                 */
+/*   muComponentStat_t **stats --> per component statistics, or NULL                         */
+/*   MU_32S *num --> number of components                                                    */
+/*===========================================================================================*/
+muError_t muConnectedComponents(const muImage_t *src, muImage_t *labels, MU_32S connectivity, muComponentStat_t **stats, MU_32S *num)
+{
+	muRLEMask_t *mask;
+	muDoubleThreshold_t th = {0, 255};
+	muComponentStat_t *st, *c;
+	const muRun_t *r;
+	MU_32S *runLabel;
+	MU_32S width, height, i, y, n = 0;
+	muError_t ret;
+
+	if(num == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	ret = labels ? muCheckDepth(4, src, MU_IMG_DEPTH_8U, labels, MU_IMG_DEPTH_32S) : muCheckDepth(2, src, MU_IMG_DEPTH_8U);
+	if(ret)
+	{
+		return ret;
+	}
+
+	if(src->channels != 1 || (labels && labels->channels != 1))
+	{
+		return MU_ERR_NOT_SUPPORT;
+	}
+
+	width = src->width;
+	height = src->height;
+
+	if((labels && (labels->width != width || labels->height != height)) || (connectivity != 4 && connectivity != 8))
+	{
+		return MU_ERR_INVALID_PARAMETER;
+	}
+
+	*num = 0;
+	if(stats)
+	{
+		*stats = NULL;
+	}
+
+	/* first pass, runs and their equivalences */
+	mask = muCreateRLEMask(muGetSize(src));
+	if(mask == NULL)
+	{
+		return MU_ERR_OUT_OF_MEMORY;
+	}
+
+	runLabel = NULL;
+	ret = muRLEThreshold(src, NULL, th, mask);
+	if(ret == MU_ERR_SUCCESS)
+	{
+		runLabel = (MU_32S *)malloc((mask->count > 0 ? mask->count : 1)*sizeof(MU_32S));
+		ret = runLabel ? muRLELabel(mask, connectivity, runLabel, &n) : MU_ERR_OUT_OF_MEMORY;
+	}
+
+	st = NULL;
+	if(ret == MU_ERR_SUCCESS && stats && n > 0)
+	{
+		st = (muComponentStat_t *)malloc(n*sizeof(muComponentStat_t));
+		if(st == NULL)
+		{
+			ret = MU_ERR_OUT_OF_MEMORY;
+		}
+	}
+
+	if(ret)
+	{
+		free(runLabel);
+		muReleaseRLEMask(&mask);
+		return ret;
+	}
+
+	/* second pass over the runs */
+	if(labels)
+	{
+		memset(labels->imagedata, 0, width*height*sizeof(MU_32S));
+
+#pragma omp parallel for
+		for(y=0; y<height; y++)
+		{
+			MU_32S *out = (MU_32S *)labels->imagedata + y*width;
+			MU_32S k, x;
+			for(k=mask->rowStart[y]; k<mask->rowStart[y+1]; k++)
+			{
+				for(x=mask->runs[k].start; x<mask->runs[k].end; x++)
+					out[x] = runLabel[k];
+			}
+		}
+	}
+
+	if(st)
+	{
+		for(i=0; i<n; i++)
+		{
+			st[i].label = i + 1;
+			st[i].area = 0;
+			st[i].minx = width;
+			st[i].miny = height;
+			st[i].maxx = 0;
+			st[i].maxy = 0;
+			st[i].m10 = 0;
+			st[i].m01 = 0;
+		}
+
+		for(i=0; i<mask->count; i++)
+		{
+			r = mask->runs + i;
+			c = st + runLabel[i] - 1;
+			c->area += r->end - r->start;
+			if(r->start < c->minx)
+				c->minx = r->start;
+			if(r->end - 1 > c->maxx)
+				c->maxx = r->end - 1;
+			if(r->y < c->miny)
+				c->miny = r->y;
+			c->maxy = r->y;
+			/* x from start to end-1 sums to (end-start)*(start+end-1)/2 */
+			c->m10 += 0.5*(r->end - r->start)*(r->start + r->end - 1);
+			c->m01 += (MU_64F)(r->end - r->start)*r->y;
+		}
+
+		for(i=0; i<n; i++)
+		{
+			st[i].centroid = muPoint2D64f(st[i].m10/st[i].area, st[i].m01/st[i].area);
+		}
+
+		*stats = st;
+	}
+
+	*num = n;
+
+	free(runLabel);
+	muReleaseRLEMask(&mask);
+
+	return MU_ERR_SUCCESS;
+}
+
+muError_t muReleaseComponentStats(muComponentStat_t **stats)
+{
+	if(stats == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	free(*stats);
+	*stats = NULL;
+
+	return MU_ERR_SUCCESS;
+}
+
+
 /*===========================================================================================*/
 /*   muFindBoundingBox                                                                      */
 /*                                                                                           */
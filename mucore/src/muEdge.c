@@ -34,6 +34,10 @@
 
 #include "muCore.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 /*===========================================================================================*/
 /*   muLaplace                                                                               */
 /*                                                                                           */
@@ -114,138 +118,417 @@ muError_t muLaplace( const muImage_t* src, muImage_t* dst, MU_8U selection)
 
 
 /*===========================================================================================*/
-/*   muSobel                                                                                 */
+/*   Gradient engine                                                                         */
 /*                                                                                           */
 /*   DESCRIPTION:                                                                            */
-/*   This routine performs a edge detection by Sobel operator.                               */
-/*                                                                                           */
-/*   Gx = 1, 2, 1,    Gy = 1, 0, -1,    out = abs(Gx)+abs(Gy)                                */
-/*        0, 0, 0,         2, 0, -2,                                                         */
-/*       -1,-2,-1          1, 0, -1                                                          */ 
-/*                                                                                           */
-/*   NOTE                                                                                    */
-/*                                                                                           */
-/*   USAGE                                                                                   */
-/*   muImage_t *src --> input image                                                          */
-/*   muImage_t *dst --> output image                                                         */
+/*   One pass over the image computes gx = d/dx (right - left) and gy = d/dy (bottom - top)  */
+/*   of a Sobel or Prewitt operator for 8 pixels per SSE2 step and derives only the outputs  */
+/*   selected in flags from them: the components, the L1 or L2 magnitude and the quantized   */
+/*   or continuous direction. Rows are spread over the threads.                              */
 /*                                                                                           */
+/*   The quantized direction needs no atan2 (see muQuantizeDir, shared with Canny) and the   */
+/*   continuous angle folds (gx, gy) into the first octant and evaluates a 7th order         */
+/*   polynomial of atan there, within 0.01 degree.                                           */
 /*===========================================================================================*/
-muError_t muSobel( const muImage_t* src, muImage_t* dst)
+
+/* atan(t)*180/pi ~ t*(p1 + t^2*(p3 + t^2*(p5 + t^2*p7))) on [0, 1] */
+#define MU_ATAN_P1  57.283627F
+#define MU_ATAN_P3 -18.667446F
+#define MU_ATAN_P5  8.914000F
+#define MU_ATAN_P7 -2.539761F
+
+#define MU_GRAD_BAND 64
+
+/*  Quantizes the direction of the vector (b, a), i.e. the angle atan2(a, b), to
+    0 (within 22.5 degrees of the b axis, or a zero vector), 90 (within 22.5 degrees of the a axis),
+    45 (a and b of equal sign) or 135. Exact, since tan(22.5) = sqrt(2)-1:
+    |a| < (sqrt(2)-1)|b| <=> (|a|+|b|)^2 < 2b^2 and |a| > (sqrt(2)+1)|b| <=> |a|-|b| > 0, (|a|-|b|)^2 > 2b^2 */
+static MU_8U muQuantizeDir(MU_32S a, MU_32S b)
 {
-	MU_16S temp; 
-	MU_32S i,j, index;
-	MU_32S gx,gy;
-	MU_32S width, height;
-	MU_8U *in, *out;
-	muError_t ret;
+	MU_32S u, v;
 
-	ret = muCheckDepth(4, src, MU_IMG_DEPTH_8U, dst, MU_IMG_DEPTH_8U);
-	if(ret)
+	u = abs(a) + abs(b);
+	v = abs(a) - abs(b);
+
+	if(u*u <= 2*b*b)
+		return 0;
+	else if(v > 0 && v*v > 2*b*b)
+		return 90;
+	else
+		return (a < 0) == (b < 0) ? 45 : 135;
+}
+
+#if defined(__SSE2__)
+/* muQuantizeDir of 8 16-bit lanes whose |a|+|b| fits 16 bits */
+static __m128i muQuantizeDir8(__m128i a, __m128i b)
+{
+	const __m128i z = _mm_setzero_si128();
+	__m128i aa, ab, u, v, d, t0, t1, off, gt, same;
+
+	aa = _mm_max_epi16(a, _mm_sub_epi16(z, a));
+	ab = _mm_max_epi16(b, _mm_sub_epi16(z, b));
+	u = _mm_add_epi16(aa, ab);
+	v = _mm_sub_epi16(aa, ab);
+
+	/* u^2 - 2b^2 and v^2 - 2b^2 in 32 bits through madd of (u, |b|) with (u, -2|b|) */
+	d = _mm_sub_epi16(z, _mm_add_epi16(ab, ab));
+	t0 = _mm_madd_epi16(_mm_unpacklo_epi16(u, ab), _mm_unpacklo_epi16(u, d));
+	t1 = _mm_madd_epi16(_mm_unpackhi_epi16(u, ab), _mm_unpackhi_epi16(u, d));
+	off = _mm_packs_epi32(_mm_cmpgt_epi32(t0, z), _mm_cmpgt_epi32(t1, z));
+	t0 = _mm_madd_epi16(_mm_unpacklo_epi16(v, ab), _mm_unpacklo_epi16(v, d));
+	t1 = _mm_madd_epi16(_mm_unpackhi_epi16(v, ab), _mm_unpackhi_epi16(v, d));
+	gt = _mm_and_si128(_mm_packs_epi32(_mm_cmpgt_epi32(t0, z), _mm_cmpgt_epi32(t1, z)), _mm_cmpgt_epi16(v, z));
+
+	same = _mm_cmpgt_epi16(_mm_xor_si128(a, b), _mm_set1_epi16(-1));
+	d = _mm_or_si128(_mm_and_si128(same, _mm_set1_epi16(45)), _mm_andnot_si128(same, _mm_set1_epi16(135)));
+	d = _mm_and_si128(off, d);
+
+	return _mm_or_si128(_mm_andnot_si128(gt, d), _mm_and_si128(gt, _mm_set1_epi16(90)));
+}
+#endif
+
+/* angle of (x, y) in degrees [0, 360) */
+static MU_32F muFastAtan2(MU_32F y, MU_32F x)
+{
+	MU_32F ax, ay, t, t2, a;
+
+	ax = (MU_32F)fabs(x);
+	ay = (MU_32F)fabs(y);
+	t = ax >= ay ? ay/(ax + 1e-10F) : ax/(ay + 1e-10F);
+	t2 = t*t;
+	a = (((MU_ATAN_P7*t2 + MU_ATAN_P5)*t2 + MU_ATAN_P3)*t2 + MU_ATAN_P1)*t;
+	if(ay > ax)
+		a = 90 - a;
+	if(x < 0)
+		a = 180 - a;
+	if(y < 0)
+		a = 360 - a;
+
+	return a >= 360 ? 0 : a;
+}
+
+/* gx and gy of row r1 for x in [1, width-1), w is the weight of the centre line */
+static void muGradientRow(const MU_8U *r0, const MU_8U *r1, const MU_8U *r2, MU_32S width, MU_32S w, MU_16S *gx, MU_16S *gy)
+{
+	MU_32S x = 1;
+
+#if defined(__SSE2__)
+	const __m128i z = _mm_setzero_si128();
+	const __m128i wv = _mm_set1_epi16((MU_16S)w);
+	__m128i a0, a2, b0, b1, b2, c0, c2;
+
+	for(; x+8<=width-1; x+=8)
 	{
-		return ret;
+		a0 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(r0 + x - 1)), z);
+		b0 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(r0 + x)), z);
+		c0 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(r0 + x + 1)), z);
+		a2 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(r2 + x - 1)), z);
+		b2 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(r2 + x)), z);
+		c2 = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(r2 + x + 1)), z);
+		b1 = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(r1 + x + 1)), z),
+						   _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(r1 + x - 1)), z));
+
+		_mm_storeu_si128((__m128i *)(gx + x), _mm_add_epi16(_mm_sub_epi16(_mm_add_epi16(c0, c2), _mm_add_epi16(a0, a2)), _mm_mullo_epi16(wv, b1)));
+		_mm_storeu_si128((__m128i *)(gy + x), _mm_add_epi16(_mm_sub_epi16(_mm_add_epi16(a2, c2), _mm_add_epi16(a0, c0)), _mm_mullo_epi16(wv, _mm_sub_epi16(b2, b0))));
 	}
+#endif
 
-	if(src->channels != 1 || dst->channels != 1)
+	for(; x<width-1; x++)
 	{
-		return MU_ERR_NOT_SUPPORT;
+		gx[x] = (MU_16S)((r0[x+1] + w*r1[x+1] + r2[x+1]) - (r0[x-1] + w*r1[x-1] + r2[x-1]));
+		gy[x] = (MU_16S)((r2[x-1] + w*r2[x] + r2[x+1]) - (r0[x-1] + w*r0[x] + r0[x+1]));
 	}
+}
 
-	width = src->width;
-	height = src->height;
+/* magnitude and direction of row y for x in [1, width-1) */
+static void muGradientStore(const MU_16S *gx, const MU_16S *gy, MU_32S y, MU_32S flags, muImage_t *mag, muImage_t *dir)
+{
+	MU_32S x, width, t;
+	MU_32F f;
 
-	in = src->imagedata;
-	out = dst->imagedata;
+	width = mag ? mag->width : dir->width;
 
-	for(j=0; j<(height-2); j++)
-		for(i=0; i<(width-2); i++)
+	if(mag)
+	{
+		x = 1;
+#if defined(__SSE2__)
 		{
-			index = i+width*j;
+			const __m128i z = _mm_setzero_si128();
+			__m128i a, b, m, m1;
+			__m128 lo, hi;
 
-			gx = (in[index]+(in[index+1]<<1)+(in[index+2]))-
-				(in[index+(width<<1)]+(in[index+(width<<1)+1]<<1)+in[index+(width<<1)+2]);
+			for(; x+8<=width-1; x+=8)
+			{
+				a = _mm_loadu_si128((const __m128i *)(gx + x));
+				b = _mm_loadu_si128((const __m128i *)(gy + x));
+				if(flags & MU_GRAD_L2)
+				{
+					/* gx^2 + gy^2 in 32 bits through madd of (gx, gy) with itself */
+					lo = _mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(_mm_unpacklo_epi16(a, b), _mm_unpacklo_epi16(a, b))));
+					hi = _mm_sqrt_ps(_mm_cvtepi32_ps(_mm_madd_epi16(_mm_unpackhi_epi16(a, b), _mm_unpackhi_epi16(a, b))));
+					if(mag->depth == MU_IMG_DEPTH_32F)
+					{
+						_mm_storeu_ps((MU_32F *)mag->imagedata + y*width + x, lo);
+						_mm_storeu_ps((MU_32F *)mag->imagedata + y*width + x + 4, hi);
+						continue;
+					}
+					m = _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi));
+				}
+				else
+				{
+					m = _mm_add_epi16(_mm_max_epi16(a, _mm_sub_epi16(z, a)), _mm_max_epi16(b, _mm_sub_epi16(z, b)));
+					if(mag->depth == MU_IMG_DEPTH_32F)
+					{
+						_mm_storeu_ps((MU_32F *)mag->imagedata + y*width + x, _mm_cvtepi32_ps(_mm_unpacklo_epi16(m, z)));
+						_mm_storeu_ps((MU_32F *)mag->imagedata + y*width + x + 4, _mm_cvtepi32_ps(_mm_unpackhi_epi16(m, z)));
+						continue;
+					}
+				}
 
-			gy = (in[index]+(in[index+width]<<1)+in[index+(width<<1)])-
-				(in[index+2]+(in[index+width+2]<<1)+in[index+(width<<1)+2]);
+				if(mag->depth == MU_IMG_DEPTH_8U)
+				{
+					m1 = _mm_packus_epi16(m, m);
+					_mm_storel_epi64((__m128i *)(mag->imagedata + y*width + x), m1);
+				}
+				else
+				{
+					_mm_storeu_si128((__m128i *)((MU_16S *)mag->imagedata + y*width + x), m);
+				}
+			}
+		}
+#endif
+		for(; x<width-1; x++)
+		{
+			if(flags & MU_GRAD_L2)
+				f = (MU_32F)sqrt((MU_32F)(gx[x]*gx[x] + gy[x]*gy[x]));
+			else
+				f = (MU_32F)(abs(gx[x]) + abs(gy[x]));
 
-			temp = abs(gx)+abs(gy);
+			if(mag->depth == MU_IMG_DEPTH_32F)
+			{
+				((MU_32F *)mag->imagedata)[y*width + x] = f;
+				continue;
+			}
 
-			temp = temp > 255 ? 255 : temp;
-			temp = temp < 0 ? 0 : temp;
+			t = (MU_32S)floor(f + 0.5F);
+			if(mag->depth == MU_IMG_DEPTH_8U)
+				mag->imagedata[y*width + x] = (MU_8U)(t > 255 ? 255 : t);
+			else
+				((MU_16S *)mag->imagedata)[y*width + x] = (MU_16S)t;
+		}
+	}
 
-			out[index+width+1] = (MU_8U)temp;
+	if(dir)
+	{
+		x = 1;
+		if(flags & MU_GRAD_ANGLE)
+		{
+			MU_32F *out = (MU_32F *)dir->imagedata + y*width;
+#if defined(__SSE2__)
+			const __m128 sign = _mm_set1_ps(-0.0F);
+			__m128 fx, fy, ax, ay, mn, mx, t, t2, a, m;
+			__m128i i;
 
+			for(; x+4<=width-1; x+=4)
+			{
+				i = _mm_loadl_epi64((const __m128i *)(gx + x));
+				fx = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(i, i), 16));
+				i = _mm_loadl_epi64((const __m128i *)(gy + x));
+				fy = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(i, i), 16));
+
+				ax = _mm_andnot_ps(sign, fx);
+				ay = _mm_andnot_ps(sign, fy);
+				mn = _mm_min_ps(ax, ay);
+				mx = _mm_max_ps(ax, ay);
+				t = _mm_div_ps(mn, _mm_add_ps(mx, _mm_set1_ps(1e-10F)));
+				t2 = _mm_mul_ps(t, t);
+				a = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(MU_ATAN_P7), t2), _mm_set1_ps(MU_ATAN_P5));
+				a = _mm_add_ps(_mm_mul_ps(a, t2), _mm_set1_ps(MU_ATAN_P3));
+				a = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(a, t2), _mm_set1_ps(MU_ATAN_P1)), t);
+
+				/* unfold the octant: 90-a above the diagonal, 180-a for x < 0, 360-a for y < 0 */
+				m = _mm_cmpgt_ps(ay, ax);
+				a = _mm_or_ps(_mm_and_ps(m, _mm_sub_ps(_mm_set1_ps(90), a)), _mm_andnot_ps(m, a));
+				m = _mm_cmplt_ps(fx, _mm_setzero_ps());
+				a = _mm_or_ps(_mm_and_ps(m, _mm_sub_ps(_mm_set1_ps(180), a)), _mm_andnot_ps(m, a));
+				m = _mm_cmplt_ps(fy, _mm_setzero_ps());
+				a = _mm_or_ps(_mm_and_ps(m, _mm_sub_ps(_mm_set1_ps(360), a)), _mm_andnot_ps(m, a));
+				a = _mm_andnot_ps(_mm_cmpge_ps(a, _mm_set1_ps(360)), a);
+				_mm_storeu_ps(out + x, a);
+			}
+#endif
+			for(; x<width-1; x++)
+				out[x] = muFastAtan2(gy[x], gx[x]);
 		}
+		else
+		{
+			MU_8U *out = dir->imagedata + y*width;
+#if defined(__SSE2__)
+			__m128i d;
 
-	return MU_ERR_SUCCESS;
+			for(; x+8<=width-1; x+=8)
+			{
+				d = muQuantizeDir8(_mm_loadu_si128((const __m128i *)(gy + x)), _mm_loadu_si128((const __m128i *)(gx + x)));
+				_mm_storel_epi64((__m128i *)(out + x), _mm_packus_epi16(d, d));
+			}
+#endif
+			for(; x<width-1; x++)
+				out[x] = muQuantizeDir(gy[x], gx[x]);
+		}
+	}
 }
 
-
-
 /*===========================================================================================*/
-/*   muPrewitt                                                                               */
+/*   muGradient                                                                              */
 /*                                                                                           */
 /*   DESCRIPTION:                                                                            */
-/*   This routine performs a edge detection by Prewitt operator.                             */
-/*                                                                                           */
-/*   Gx = 1, 1, 1,    Gy = 1, 0, -1,    out = abs(Gx)+abs(Gy)                                */
-/*        0, 0, 0,         1, 0, -1,                                                         */
-/*       -1,-1,-1          1, 0, -1                                                          */   
+/*   This routine computes the image gradient by the Sobel (MU_GRAD_SOBEL) or Prewitt        */
+/*   (MU_GRAD_PREWITT) operator and writes the outputs selected in flags:                    */
+/*   MU_GRAD_DX, MU_GRAD_DY --> gx, gy in 16S images dx, dy                                  */
+/*   MU_GRAD_MAG --> |gx|+|gy|, or sqrt(gx^2+gy^2) with MU_GRAD_L2, in mag (8U saturated,    */
+/*                   16S or 32F; integer L2 is rounded)                                      */
+/*   MU_GRAD_DIR --> direction quantized to 0/45/90/135 in an 8U dir image, or the angle     */
+/*                   of (gx, gy) in degrees [0, 360) in a 32F dir image with MU_GRAD_ANGLE.  */
+/*                   0 is a gradient along x, 45 along the diagonal where gx and gy have     */
+/*                   equal signs.                                                            */
 /*                                                                                           */
 /*   NOTE                                                                                    */
-/*                                                                                           */
-/*   USAGE                                                                                   */
-/*   muImage_t *src --> input image                                                          */
-/*   muImage_t *dst --> output image                                                         */
-/*                                                                                           */
+/*   src is a 1 channel 8U image, outputs not selected may be NULL. The one pixel border of  */
+/*   the outputs is not touched.                                                             */
 /*===========================================================================================*/
-muError_t muPrewitt( const muImage_t* src, muImage_t* dst)
+muError_t muGradient(const muImage_t *src, MU_32S op, MU_32S flags, muImage_t *dx, muImage_t *dy, muImage_t *mag, muImage_t *dir)
 {
-	MU_16S temp; 
-	MU_32S i,j, index;
-	MU_32S gx,gy;
-	MU_32S width, height;
-	MU_8U *in, *out;
-	muError_t ret;
+	MU_32S width, height, w, nband, b;
+	muError_t ret = MU_ERR_SUCCESS;
 
-	ret = muCheckDepth(4, src, MU_IMG_DEPTH_8U, dst, MU_IMG_DEPTH_8U);
+	ret = muCheckDepth(2, src, MU_IMG_DEPTH_8U);
 	if(ret)
 	{
 		return ret;
 	}
 
-	if(src->channels != 1 || dst->channels != 1)
+	if(src->channels != 1 || (op != MU_GRAD_SOBEL && op != MU_GRAD_PREWITT))
 	{
 		return MU_ERR_NOT_SUPPORT;
 	}
 
+	dx = (flags & MU_GRAD_DX) ? dx : NULL;
+	dy = (flags & MU_GRAD_DY) ? dy : NULL;
+	mag = (flags & MU_GRAD_MAG) ? mag : NULL;
+	dir = (flags & MU_GRAD_DIR) ? dir : NULL;
+
+	if(((flags & MU_GRAD_DX) && dx == NULL) || ((flags & MU_GRAD_DY) && dy == NULL) ||
+	   ((flags & MU_GRAD_MAG) && mag == NULL) || ((flags & MU_GRAD_DIR) && dir == NULL))
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	if((dx && (dx->depth != MU_IMG_DEPTH_16S || dx->channels != 1 || dx->width != src->width || dx->height != src->height)) ||
+	   (dy && (dy->depth != MU_IMG_DEPTH_16S || dy->channels != 1 || dy->width != src->width || dy->height != src->height)) ||
+	   (mag && ((mag->depth != MU_IMG_DEPTH_8U && mag->depth != MU_IMG_DEPTH_16S && mag->depth != MU_IMG_DEPTH_32F) ||
+				mag->channels != 1 || mag->width != src->width || mag->height != src->height)) ||
+	   (dir && (dir->depth != ((flags & MU_GRAD_ANGLE) ? MU_IMG_DEPTH_32F : MU_IMG_DEPTH_8U) ||
+				dir->channels != 1 || dir->width != src->width || dir->height != src->height)))
+	{
+		return MU_ERR_INVALID_PARAMETER;
+	}
 
 	width = src->width;
 	height = src->height;
+	w = op == MU_GRAD_SOBEL ? 2 : 1;
 
-	in = src->imagedata;
-	out = dst->imagedata;
+	if(width < 3 || height < 3 || !(dx || dy || mag || dir))
+	{
+		return MU_ERR_SUCCESS;
+	}
+
+	nband = (height - 2 + MU_GRAD_BAND - 1) / MU_GRAD_BAND;
 
-	for(j=0; j<(height-2); j++)
-		for(i=0; i<(width-2); i++)
+#pragma omp parallel for
+	for(b=0; b<nband; b++)
+	{
+		MU_16S *buf = NULL, *gx, *gy;
+		const MU_8U *in;
+		MU_32S y0, y1, y;
+
+		y0 = 1 + b*MU_GRAD_BAND;
+		y1 = y0 + MU_GRAD_BAND < height - 1 ? y0 + MU_GRAD_BAND : height - 1;
+
+		/* row buffers for the components that are not requested */
+		if(!dx || !dy)
 		{
-			index = i+width*j;
+			buf = (MU_16S *)malloc(2*width*sizeof(MU_16S));
+			if(buf == NULL)
+			{
+#pragma omp critical
+				ret = MU_ERR_OUT_OF_MEMORY;
+				continue;
+			}
+		}
 
-			gx = (in[index]+(in[index+1])+(in[index+2]))-
-				(in[index+(width<<1)]+(in[index+(width<<1)+1])+in[index+(width<<1)+2]);
+		for(y=y0; y<y1; y++)
+		{
+			in = src->imagedata + y*width;
+			gx = dx ? (MU_16S *)dx->imagedata + y*width : buf;
+			gy = dy ? (MU_16S *)dy->imagedata + y*width : buf + width;
 
-			gy = (in[index]+(in[index+width])+in[index+(width<<1)])-
-				(in[index+2]+(in[index+width+2])+in[index+(width<<1)+2]);
+			muGradientRow(in - width, in, in + width, width, w, gx, gy);
+			if(mag || dir)
+				muGradientStore(gx, gy, y, flags, mag, dir);
+		}
 
-			temp = abs(gx)+abs(gy);
+		if(buf)
+			free(buf);
+	}
 
-			temp = temp > 255 ? 255 : temp;
-			temp = temp < 0 ? 0 : temp;
+	return ret;
+}
 
-			out[index+width+1] = (MU_8U)temp;
 
-		}
+/*===========================================================================================*/
+/*   muSobel                                                                                 */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine performs a edge detection by Sobel operator through muGradient.            */
+/*                                                                                           */
+/*   Gx = 1, 2, 1,    Gy = 1, 0, -1,    out = abs(Gx)+abs(Gy)                                */
+/*        0, 0, 0,         2, 0, -2,                                                         */
+/*       -1,-2,-1          1, 0, -1                                                          */ 
+/*                                                                                           */
+/*   NOTE                                                                                    */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muImage_t *src --> input image                                                          */
+/*   muImage_t *dst --> output image                                                         */
+/*                                                                                           */
+/*===========================================================================================*/
+muError_t muSobel( const muImage_t* src, muImage_t* dst)
+{
+	return muGradient(src, MU_GRAD_SOBEL, MU_GRAD_MAG, NULL, NULL, dst, NULL);
+}
 
-	return MU_ERR_SUCCESS;
+
+
+/*===========================================================================================*/
+/*   muPrewitt                                                                               */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine performs a edge detection by Prewitt operator through muGradient.          */
+/*                                                                                           */
+/*   Gx = 1, 1, 1,    Gy = 1, 0, -1,    out = abs(Gx)+abs(Gy)                                */
+/*        0, 0, 0,         1, 0, -1,                                                         */
+/*       -1,-1,-1          1, 0, -1                                                          */   
+/*                                                                                           */
+/*   NOTE                                                                                    */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muImage_t *src --> input image                                                          */
+/*   muImage_t *dst --> output image                                                         */
+/*                                                                                           */
+/*===========================================================================================*/
+muError_t muPrewitt( const muImage_t* src, muImage_t* dst)
+{
+	return muGradient(src, MU_GRAD_PREWITT, MU_GRAD_MAG, NULL, NULL, dst, NULL);
 }
 
 typedef struct _blurInfo
@@ -360,12 +643,12 @@ static blurInfo_t *calEdgeWidth(MU_8U *content, MU_32S length)
 /*===========================================================================================*/
 muError_t muNoRefBlurMetric(muImage_t *src, MU_64F *bm)
 {
-	MU_16S temp; 
+	MU_16S temp, *gx;
 	MU_32S i,j, index;
-	MU_32S gy;
 	MU_32S width, height;
-	MU_8U *in, *out;
-	muImage_t *dst, *gray, *edgeImg;
+	MU_8U *out;
+	const muImage_t *in;
+	muImage_t *dst, *gray, *edgeImg, *dx;
 	muSize_t size;
 	blurInfo_t *blurInfo;
 	MU_32U totalEdge = 0;
@@ -384,31 +667,27 @@ muError_t muNoRefBlurMetric(muImage_t *src, MU_64F *bm)
 	if(src->channels == 3)
 	{
 		muRGB2GrayLevel(src, gray);
-		in = gray->imagedata;
+		in = gray;
 	}
 	else
 	{
-		in = src->imagedata;
+		in = src;
 	}
 		
+	/* |d/dx| of the Sobel operator, saturated to 8 bits */
+	dx = muCreateImage(size, MU_IMG_DEPTH_16S, 1);
+	muGradient(in, MU_GRAD_SOBEL, MU_GRAD_DX, dx, NULL, NULL, NULL);
+
+	gx = (MU_16S *)dx->imagedata;
 	out = dst->imagedata;
-	
-	for(j=0; j<(height-2); j++)
-		for(i=0; i<(width-2); i++)
+	for(j=1; j<height-1; j++)
+		for(i=1; i<width-1; i++)
 		{
-			index = i+width*j;
-
-			gy = (in[index]+(in[index+width]<<1)+in[index+(width<<1)])-
-				(in[index+2]+(in[index+width+2]<<1)+in[index+(width<<1)+2]);
-
-			temp = abs(gy);
-
-			temp = temp > 255 ? 255 : temp;
-			temp = temp < 0 ? 0 : temp;
-
-			out[index+width+1] = (MU_8U)temp;
-		
+			index = j*width + i;
+			temp = (MU_16S)abs(gx[index]);
+			out[index] = (MU_8U)(temp > 255 ? 255 : temp);
 		}
+	muReleaseImage(&dx);
 
 	muOtsuThresholding(dst, edgeImg);
 
@@ -437,274 +716,251 @@ muError_t muNoRefBlurMetric(muImage_t *src, MU_64F *bm)
 }
 
 
+/*===========================================================================================*/
+/*   Canny pipeline                                                                          */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   Rows stream through three small rings: the 5x5 Gaussian (sum/159, 16S), the Prewitt   */
+/*   gradient (L1 magnitude and direction quantized to 0/45/90/135) and the non-maximum     */
+/*   suppression, which writes EDGE / EDGECANDIDATE / NOEDGE straight into dst. The image  */
+/*   is cut into row bands that run in parallel, each warming up its own rings.            */
+/*   Hysteresis then floods from every EDGE pixel through 8-connected candidates with an   */
+/*   explicit stack, so chains of any shape are kept.                                        */
+/*                                                                                           */
+/*   Directions are quantized by muQuantizeDir(a, b) with a = d/dx and b = d/dy, so 0 here  */
+/*   is a gradient along y, the orientation the suppression below expects.                 */
+/*===========================================================================================*/
+
 #define NOEDGE        0
 #define EDGECANDIDATE 128
+#define EDGELINKED    254
 #define EDGE          255
-static muError_t nonMaxSuppress(const muImage_t *magImg, muImage_t *dirImg, muImage_t *cannyImg, muDoubleThreshold_t th, MU_32S offset)
+
+#define MU_CANNY_BAND 64
+
+/* Gaussian 2 4 5 4 2 / 4 9 12 9 4 / 5 12 15 12 5 / ..., divided by 159, for x in [2, width-2) */
+static void muCannyBlurRow(const MU_8U *rows[5], MU_16S *g, MU_32S width)
 {
+	static const MU_8U k[3][3] = {{2, 4, 5}, {4, 9, 12}, {5, 12, 15}};
+	MU_32S x = 2, i, j, t;
 
-	MU_32S i, j;
-	MU_32S width, height;
-	muSize_t size;
-	muError_t ret;
-	muImage_t *tempImg;
-	MU_16S *mag, magData[9], magTemp;
-	MU_8U *out, *dir, dirTemp, *tmp, mgTemp[9]; 
-	MU_16S leftPix, rightPix;
+#if defined(__SSE2__)
+	const __m128i z = _mm_setzero_si128();
+	__m128i s, v;
 
-	ret = muCheckDepth(6, magImg, MU_IMG_DEPTH_16S, dirImg, MU_IMG_DEPTH_8U, cannyImg, MU_IMG_DEPTH_8U);
-	if(ret)
+	/* the sum stays below 255*159 and fits unsigned 16 bits, floor(s/159) = (s*52759 >> 16) >> 7 */
+	for(; x+8<=width-2; x+=8)
 	{
-		return ret;
+		s = z;
+		for(i=0; i<5; i++)
+			for(j=0; j<5; j++)
+			{
+				v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(rows[i] + x + j - 2)), z);
+				s = _mm_add_epi16(s, _mm_mullo_epi16(v, _mm_set1_epi16(k[i < 3 ? i : 4 - i][j < 3 ? j : 4 - j])));
+			}
+		_mm_storeu_si128((__m128i *)(g + x), _mm_srli_epi16(_mm_mulhi_epu16(s, _mm_set1_epi16((MU_16S)52759)), 7));
 	}
+#endif
 
-	if(magImg->channels != 1 || dirImg->channels != 1 || cannyImg->channels != 1)
+	for(; x<width-2; x++)
 	{
-		return MU_ERR_NOT_SUPPORT;
+		t = 0;
+		for(i=0; i<5; i++)
+			for(j=0; j<5; j++)
+				t += rows[i][x + j - 2]*k[i < 3 ? i : 4 - i][j < 3 ? j : 4 - j];
+		g[x] = (MU_16S)(t/159);
 	}
-	
-	size.width = magImg->width;
-	size.height = magImg->height;
+}
 
-	tempImg = muCreateImage(size, MU_IMG_DEPTH_8U, 1);
-	memset(magData, 0, 9*sizeof(MU_16S));
-	memset(mgTemp, 0, 9*sizeof(MU_8U));
-	mag = (MU_16S *)magImg->imagedata;
-	out = (MU_8U *)tempImg->imagedata;
-	dir = (MU_8U *)dirImg->imagedata;
+/* Prewitt magnitude |a|+|b| and quantized direction for x in [3, width-3) */
+static void muCannyGradRow(const MU_16S *g[3], MU_16S *mag, MU_8U *dir, MU_32S width)
+{
+	MU_32S x = 3, a, b;
 
-	width = magImg->width;
-	height = magImg->height;
+#if defined(__SSE2__)
+	const __m128i z = _mm_setzero_si128();
+	__m128i l, r, av, bv, d;
 
-	for(j=offset; j<(height-offset-2); j++)
-		for(i=offset; i<(width-offset-2); i++)
-		{
-			magData[0] = mag[i+width*j];     magData[1] = mag[i+1+width*j];     magData[2] = mag[i+2+width*j];
-			magData[3] = mag[i+width*(j+1)]; magData[4] = mag[i+1+width*(j+1)]; magData[5] = mag[i+2+width*(j+1)];
-			magData[6] = mag[i+width*(j+2)]; magData[7] = mag[i+1+width*(j+2)]; magData[8] = mag[i+2+width*(j+2)];
+	for(; x+8<=width-3; x+=8)
+	{
+		l = _mm_add_epi16(_mm_add_epi16(_mm_loadu_si128((const __m128i *)(g[0] + x - 1)), _mm_loadu_si128((const __m128i *)(g[1] + x - 1))), _mm_loadu_si128((const __m128i *)(g[2] + x - 1)));
+		r = _mm_add_epi16(_mm_add_epi16(_mm_loadu_si128((const __m128i *)(g[0] + x + 1)), _mm_loadu_si128((const __m128i *)(g[1] + x + 1))), _mm_loadu_si128((const __m128i *)(g[2] + x + 1)));
+		av = _mm_sub_epi16(r, l);
+		l = _mm_add_epi16(_mm_add_epi16(_mm_loadu_si128((const __m128i *)(g[0] + x - 1)), _mm_loadu_si128((const __m128i *)(g[0] + x))), _mm_loadu_si128((const __m128i *)(g[0] + x + 1)));
+		r = _mm_add_epi16(_mm_add_epi16(_mm_loadu_si128((const __m128i *)(g[2] + x - 1)), _mm_loadu_si128((const __m128i *)(g[2] + x))), _mm_loadu_si128((const __m128i *)(g[2] + x + 1)));
+		bv = _mm_sub_epi16(r, l);
+
+		_mm_storeu_si128((__m128i *)(mag + x), _mm_add_epi16(_mm_max_epi16(av, _mm_sub_epi16(z, av)), _mm_max_epi16(bv, _mm_sub_epi16(z, bv))));
+		d = muQuantizeDir8(av, bv);
+		_mm_storel_epi64((__m128i *)(dir + x), _mm_packus_epi16(d, d));
+	}
+#endif
 
-			dirTemp = dir[i+1+width*(j+1)];
-			magTemp = magData[4];
+	for(; x<width-3; x++)
+	{
+		a = (g[0][x+1] + g[1][x+1] + g[2][x+1]) - (g[0][x-1] + g[1][x-1] + g[2][x-1]);
+		b = (g[2][x-1] + g[2][x] + g[2][x+1]) - (g[0][x-1] + g[0][x] + g[0][x+1]);
+		mag[x] = (MU_16S)(abs(a) + abs(b));
+		dir[x] = muQuantizeDir(a, b);
+	}
+}
 
-			if(dirTemp == 0)
-			{
-				leftPix = magData[1]; rightPix = magData[7];
-			}
-			else if(dirTemp == 45)
-			{
-				leftPix = magData[0]; rightPix = magData[8];
-			}
-			else if(dirTemp == 90)
-			{
-				leftPix = magData[3]; rightPix = magData[5];
-			}
-			else
-			{
-				leftPix = magData[2]; rightPix = magData[6];
-			}
+/* non-maximum suppression and double threshold for x in [4, width-4), the rest of the row is NOEDGE */
+static void muCannyNMSRow(const MU_16S *m[3], const MU_8U *dir, MU_8U *out, MU_32S width, MU_16S lo, MU_16S hi)
+{
+	MU_32S x = 4;
+	MU_16S c, n;
 
-			//to place the edge and trace the edge by hysteresis function ;
-			if(magTemp == NOEDGE)
-				out[i+1+width*(j+1)] = NOEDGE;
-			else if(magTemp < leftPix || magTemp < rightPix)
-				out[i+1+width*(j+1)] = NOEDGE;
-			else //maybe edge occur
-			{
-				if(magTemp > th.max )  
-					out[i+1+width*(j+1)] = EDGE;
-				else if(magTemp <= th.max && magTemp >= th.min)
-					out[i+1+width*(j+1)] = EDGECANDIDATE;
-				else
-					out[i+1+width*(j+1)] = NOEDGE;
-			}
+	memset(out, NOEDGE, width < 4 ? width : 4);
 
-		}
+#if defined(__SSE2__)
+	{
+		const __m128i z = _mm_setzero_si128();
+		__m128i cv, dv, nb, t, keep, e, s;
 
-	tmp = tempImg->imagedata;
-	out = cannyImg->imagedata;
-	// HysteresisTh
-	offset = offset+1;
-	for(j=offset; j<(height-offset-2); j++)
-		for(i=offset; i<(width-offset-2); i++)
+		for(; x+8<=width-4; x+=8)
 		{
-			mgTemp[0] = tmp[i+width*j];     mgTemp[1] = tmp[i+1+width*j];     mgTemp[2] = tmp[i+2+width*j];
-			mgTemp[3] = tmp[i+width*(j+1)]; mgTemp[4] = tmp[i+1+width*(j+1)]; mgTemp[5] = tmp[i+2+width*(j+1)];
-			mgTemp[6] = tmp[i+width*(j+2)]; mgTemp[7] = tmp[i+1+width*(j+2)]; mgTemp[8] = tmp[i+2+width*(j+2)];
-
-			if(mgTemp[4] == EDGE)
-			{
-				//Row1
-				if(mgTemp[0]==EDGECANDIDATE){tmp[i+width*j] = EDGE;out[i+width*j] = EDGE;}
-				if(mgTemp[1]==EDGECANDIDATE){tmp[i+1+width*j] = EDGE;out[i+1+width*j] = EDGE;}
-				if(mgTemp[2]==EDGECANDIDATE){tmp[i+2+width*j] = EDGE;out[i+2+width*j] = EDGE;}
-				//Row2
-				if(mgTemp[3]==EDGECANDIDATE){tmp[i+width*(j+1)] = EDGE;out[i+width*(j+1)] = EDGE;}
-				if(mgTemp[5]==EDGECANDIDATE){tmp[i+2+width*(j+1)] = EDGE;out[i+2+width*(j+1)] = EDGE;}
-				//Row3
-				if(mgTemp[6]==EDGECANDIDATE){tmp[i+width*(j+2)] = EDGE;out[i+width*(j+2)] = EDGE;}
-				if(mgTemp[7]==EDGECANDIDATE){tmp[i+1+width*(j+2)] = EDGE;out[i+1+width*(j+2)] = EDGE;}
-				if(mgTemp[8]==EDGECANDIDATE){tmp[i+2+width*(j+2)] = EDGE;out[i+2+width*(j+2)] = EDGE;}
-
-				out[i+1+width*(j+1)] = EDGE;
-			}
+			cv = _mm_loadu_si128((const __m128i *)(m[1] + x));
+			dv = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(dir + x)), z);
+
+			/* larger neighbour across the quantized direction */
+			t = _mm_cmpeq_epi16(dv, z);
+			nb = _mm_and_si128(t, _mm_max_epi16(_mm_loadu_si128((const __m128i *)(m[0] + x)), _mm_loadu_si128((const __m128i *)(m[2] + x))));
+			t = _mm_cmpeq_epi16(dv, _mm_set1_epi16(45));
+			nb = _mm_or_si128(nb, _mm_and_si128(t, _mm_max_epi16(_mm_loadu_si128((const __m128i *)(m[0] + x - 1)), _mm_loadu_si128((const __m128i *)(m[2] + x + 1)))));
+			t = _mm_cmpeq_epi16(dv, _mm_set1_epi16(90));
+			nb = _mm_or_si128(nb, _mm_and_si128(t, _mm_max_epi16(_mm_loadu_si128((const __m128i *)(m[1] + x - 1)), _mm_loadu_si128((const __m128i *)(m[1] + x + 1)))));
+			t = _mm_cmpeq_epi16(dv, _mm_set1_epi16(135));
+			nb = _mm_or_si128(nb, _mm_and_si128(t, _mm_max_epi16(_mm_loadu_si128((const __m128i *)(m[0] + x + 1)), _mm_loadu_si128((const __m128i *)(m[2] + x - 1)))));
+
+			keep = _mm_andnot_si128(_mm_or_si128(_mm_cmpeq_epi16(cv, z), _mm_cmplt_epi16(cv, nb)), _mm_set1_epi16(-1));
+			e = _mm_and_si128(keep, _mm_cmpgt_epi16(cv, _mm_set1_epi16(hi)));
+			s = _mm_andnot_si128(_mm_or_si128(e, _mm_cmplt_epi16(cv, _mm_set1_epi16(lo))), keep);
+			t = _mm_or_si128(_mm_and_si128(e, _mm_set1_epi16(EDGE)), _mm_and_si128(s, _mm_set1_epi16(EDGECANDIDATE)));
+			_mm_storel_epi64((__m128i *)(out + x), _mm_packus_epi16(t, t));
+		}
+	}
+#endif
 
+	for(; x<width-4; x++)
+	{
+		c = m[1][x];
+		switch(dir[x])
+		{
+			case 0:  n = m[0][x] > m[2][x] ? m[0][x] : m[2][x]; break;
+			case 45: n = m[0][x-1] > m[2][x+1] ? m[0][x-1] : m[2][x+1]; break;
+			case 90: n = m[1][x-1] > m[1][x+1] ? m[1][x-1] : m[1][x+1]; break;
+			default: n = m[0][x+1] > m[2][x-1] ? m[0][x+1] : m[2][x-1]; break;
 		}
 
-	muReleaseImage(&tempImg);
+		if(c == 0 || c < n)
+			out[x] = NOEDGE;
+		else if(c > hi)
+			out[x] = EDGE;
+		else if(c >= lo)
+			out[x] = EDGECANDIDATE;
+		else
+			out[x] = NOEDGE;
+	}
 
-	return MU_ERR_SUCCESS;
+	for(; x<width; x++)
+		out[x] = NOEDGE;
 }
 
-
-static muError_t muFilter16S55( const muImage_t* src, muImage_t* dst, const MU_8S kernel[], const MU_8U norm)
+/* pushes i onto the growing stack, returns 0 when out of memory */
+static MU_32S muCannyPush(MU_32S **stack, MU_32S *top, MU_32S *size, MU_32S i)
 {
-	MU_32S i, j, temp;
-	MU_32S width, height;
-	muError_t ret;
-	MU_8U *in;
-	MU_16S *out;
+	MU_32S *p;
 
-	ret = muCheckDepth(4, src, MU_IMG_DEPTH_8U, dst, MU_IMG_DEPTH_16S);
-	if(ret)
+	if(*top == *size)
 	{
-		return ret;
-	}
-
-	if(src->channels != 1 || dst->channels != 1)
-	{
-		return MU_ERR_NOT_SUPPORT;
-	}
-
-	in = src->imagedata;
-	out = (MU_16S *)dst->imagedata;
-
-	width = src->width;
-	height = src->height;
-	
-	for(i=0; i<height-4; i++)
-	{
-		for(j=0; j<width-4; j++)
+		p = (MU_32S *)realloc(*stack, 2*(*size)*sizeof(MU_32S));
+		if(p == NULL)
 		{
-			temp = 0;
-			//Row1
-			temp += in[j+width*i]*kernel[0]; 
-			temp += in[j+1+width*i]*kernel[1]; 
-			temp += in[j+2+width*i]*kernel[2]; 
-			temp += in[j+3+width*i]*kernel[3]; 
-			temp += in[j+4+width*i]*kernel[4];
-			//Row2
-			temp += in[j+width*(i+1)]*kernel[5]; 
-			temp += in[j+1+width*(i+1)]*kernel[6]; 
-			temp += in[j+2+width*(i+1)]*kernel[7]; 
-			temp += in[j+3+width*(i+1)]*kernel[8]; 
-			temp += in[j+4+width*(i+1)]*kernel[9];
-			//Row3
-			temp += in[j+width*(i+2)]*kernel[10]; 
-			temp += in[j+1+width*(i+2)]*kernel[11]; 
-			temp += in[j+2+width*(i+2)]*kernel[12]; 
-			temp += in[j+3+width*(i+2)]*kernel[13]; 
-			temp += in[j+4+width*(i+2)]*kernel[14];
-			//Row4
-			temp += in[j+width*(i+3)]*kernel[15]; 
-			temp += in[j+1+width*(i+3)]*kernel[16]; 
-			temp += in[j+2+width*(i+3)]*kernel[17]; 
-			temp += in[j+3+width*(i+3)]*kernel[18]; 
-			temp += in[j+4+width*(i+3)]*kernel[19];
-			//Row5
-			temp += in[j+width*(i+4)]*kernel[20]; 
-			temp += in[j+1+width*(i+4)]*kernel[21]; 
-			temp += in[j+2+width*(i+4)]*kernel[22]; 
-			temp += in[j+3+width*(i+4)]*kernel[23]; 
-			temp += in[j+4+width*(i+4)]*kernel[24];
-
-			out[j+2+width*(i+2)] = (temp/(MU_32F)norm);
+			return 0;
 		}
+		*stack = p;
+		*size *= 2;
 	}
+	(*stack)[(*top)++] = i;
 
-	return MU_ERR_SUCCESS;
+	return 1;
 }
 
-muError_t edgeFilter(muImage_t *src, muImage_t *mag, muImage_t *dirImg, const MU_8S kx[], const MU_8S ky[], MU_32S offset)
+/* links the candidates 8-connected to EDGE pixels and clears the rest */
+static muError_t muCannyHysteresis(muImage_t *dst)
 {
-	muError_t ret;
-	MU_32S i,j;
-	MU_32S width, height;
-	MU_32S gx, gy, gm;
-	MU_16S *in, *out;
-	MU_8U *dir, degree;
-	MU_64F degreeTemp;
-	
-	ret = muCheckDepth(6, src, MU_IMG_DEPTH_16S, mag, MU_IMG_DEPTH_16S, dirImg, MU_IMG_DEPTH_8U);
-	if(ret)
-	{
-		return ret;
-	}
+	MU_32S width, n, i, j, k, top, size;
+	MU_32S *stack;
+	MU_32S ofs[8];
+	MU_8U *p;
+
+	width = dst->width;
+	n = width*dst->height;
+	p = dst->imagedata;
 
-	if(src->channels != 1 || mag->channels != 1 || dirImg->channels != 1)
+	ofs[0] = -width-1; ofs[1] = -width; ofs[2] = -width+1; ofs[3] = -1;
+	ofs[4] = 1; ofs[5] = width-1; ofs[6] = width; ofs[7] = width+1;
+
+	size = 1024;
+	stack = (MU_32S *)malloc(size*sizeof(MU_32S));
+	if(stack == NULL)
 	{
-		return MU_ERR_NOT_SUPPORT;
+		return MU_ERR_OUT_OF_MEMORY;
 	}
 
-	in = (MU_16S*)src->imagedata;
-	out = (MU_16S*)mag->imagedata;
-	dir = (MU_8U *)dirImg->imagedata;
-
-	width = src->width;
-	height = src->height;
+	/* the NMS leaves a NOEDGE frame of 4 pixels, so neighbours of marked pixels are inside */
+	for(i=0; i<n; i++)
+	{
+#if defined(__SSE2__)
+		/* skip blocks without EDGE pixels */
+		if(!(i & 15) && i+16 <= n &&
+		   !_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + i)), _mm_set1_epi8((MU_8S)EDGE))))
+		{
+			i += 15;
+			continue;
+		}
+#endif
+		if(p[i] != EDGE)
+			continue;
 
-	for(j=offset; j<(height-offset-2); j++)
-		for(i=offset; i<(width-offset-2); i++)
+		top = 0;
+		stack[top++] = i;
+		while(top)
 		{
-			
-			gx =  in[i+width*j]    *kx[0] + in[i+1+width*j]    *kx[1]  + in[i+2+width*j]    *kx[2]
-				 +in[i+width*(j+1)]*kx[3] + in[i+1+width*(j+1)]*kx[4]  + in[i+2+width*(j+1)]*kx[5]
-				 +in[i+width*(j+2)]*kx[6] + in[i+1+width*(j+2)]*kx[7]  + in[i+2+width*(j+2)]*kx[8];
-
-			gy =  in[i+width*j]    *ky[0] + in[i+1+width*j]    *ky[1]  + in[i+2+width*j]    *ky[2]
-				 +in[i+width*(j+1)]*ky[3] + in[i+1+width*(j+1)]*ky[4]  + in[i+2+width*(j+1)]*ky[5]
-				 +in[i+width*(j+2)]*ky[6] + in[i+1+width*(j+2)]*ky[7]  + in[i+2+width*(j+2)]*ky[8];
-			
-			gm = abs(gx)+abs(gy);
-
-			if(gx == 0)
-   	       	{
-              if(gy == 0)
-              {
-              	degree = 0;
-              	degreeTemp = 0;
-              }          
-              else
-              {
-              	degree = 90;
-              	degreeTemp = 90;
-              }              
-           	}
-           	else
-           	{
-            	
-				degreeTemp = atan2(gy, gx)*180/MU_PI;
-				if (((degreeTemp < 22.5) && (degreeTemp > -22.5)) || (degreeTemp > 157.5) || (degreeTemp < -157.5))
-					degreeTemp = 0;
-				if (((degreeTemp > 22.5) && (degreeTemp < 67.5)) || ( (degreeTemp < -112.5) && (degreeTemp > -157.5)))
-					degreeTemp = 45;
-				if (((degreeTemp > 67.5) && (degreeTemp < 112.5)) || ( (degreeTemp < -67.5) && (degreeTemp > -112.5)))
-					degreeTemp = 90;
-				if (((degreeTemp > 112.5) && (degreeTemp < 157.5)) || ( (degreeTemp < -22.5) && (degreeTemp > -67.5)))
-					degreeTemp = 135;
-				//LUT include atan.h
-				//tempx = abs(gx); tempy = abs(gy);
-            	//degree = atantbl[tempy][tempx];
-				//printf("tbl:%d atan2:%f \n", degree, degreeTemp);
-              	//if(((gx<0 && gy> 0)||(gx > 0 && gy < 0))&&(degree==45))
-              	//	degree = 135;
-           	}
-
-           	dir[i+1+width*(j+1)] = degreeTemp;
-           	out[i+1+width*(j+1)] = gm;	
+			j = stack[--top];
+			for(k=0; k<8; k++)
+			{
+				if(p[j + ofs[k]] == EDGECANDIDATE)
+				{
+					p[j + ofs[k]] = EDGELINKED;
+					if(!muCannyPush(&stack, &top, &size, j + ofs[k]))
+					{
+						free(stack);
+						return MU_ERR_OUT_OF_MEMORY;
+					}
+				}
+			}
 		}
-}
+	}
 
+	free(stack);
 
+	/* EDGE and EDGELINKED become EDGE, candidates left alone are dropped */
+	i = 0;
+#if defined(__SSE2__)
+	for(; i+16<=n; i+=16)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+		v = _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8((MU_8S)EDGELINKED)), v);
+		_mm_storeu_si128((__m128i *)(p + i), v);
+	}
+#endif
+	for(; i<n; i++)
+		p[i] = p[i] >= EDGELINKED ? EDGE : NOEDGE;
+
+	return MU_ERR_SUCCESS;
+}
 
 /*===========================================================================================*/
 /*   muCannyEdge																             */
@@ -715,6 +971,8 @@ muError_t edgeFilter(muImage_t *src, muImage_t *mag, muImage_t *dirImg, const MU
 /*                                                                                           */
 /*   NOTE                                                                                    */
 /*   double threshold could be using other methodology to find                               */
+/*   Only a few rows per band are kept besides dst, edges are not reported within 4 pixels  */
+/*   of the image border.                                                                    */
 /*                                                                                           */
 /*   USAGE                                                                                   */
 /*   muImage_t *src --> input image                                                          */
@@ -724,12 +982,8 @@ muError_t edgeFilter(muImage_t *src, muImage_t *mag, muImage_t *dirImg, const MU
 muError_t muCannyEdge(const muImage_t *src, muImage_t *dst, muDoubleThreshold_t th)
 {
 	muError_t ret;
-	muImage_t *gausImg, *magImg, *dirImg;
-	muSize_t size;
-
-	MU_8U kernel[25] = {2,4,5,4,2,4,9,12,9,4,5,12,15,12,5,4,9,12,9,4,2,4,5,4,2};
-	MU_8S gx[9] = {-1,-1,-1,0,0,0,1,1,1};
-	MU_8S gy[9] = {-1,0,1,-1,0,1,-1,0,1};
+	MU_32S width, height, nband, b;
+	MU_16S lo, hi;
 
 	ret = muCheckDepth(4, src, MU_IMG_DEPTH_8U, dst, MU_IMG_DEPTH_8U);
 	if(ret)
@@ -742,25 +996,85 @@ muError_t muCannyEdge(const muImage_t *src, muImage_t *dst, muDoubleThreshold_t
 		return MU_ERR_NOT_SUPPORT;
 	}
 
-	size.width = src->width;
-	size.height = src->height;
+	if(src->width != dst->width || src->height != dst->height)
+	{
+		return MU_ERR_INVALID_PARAMETER;
+	}
+
+	width = src->width;
+	height = src->height;
 
-	gausImg = muCreateImage(size, MU_IMG_DEPTH_16S, 1);
-	magImg = muCreateImage(size, MU_IMG_DEPTH_16S, 1);
-	dirImg = muCreateImage(size, MU_IMG_DEPTH_8U, 1);
+	memset(dst->imagedata, NOEDGE, width*height);
+	if(width < 9 || height < 9)
+	{
+		return MU_ERR_SUCCESS;
+	}
 
-	muSetZero(gausImg);
-	muSetZero(magImg);
-	muSetZero(gausImg);
+	/* magnitudes are at most 1530 */
+	lo = (MU_16S)(th.min < 0 ? 0 : (th.min > 2000 ? 2000 : th.min));
+	hi = (MU_16S)(th.max < -1 ? -1 : (th.max > 2000 ? 2000 : th.max));
 
-	muFilter16S55(src, gausImg, kernel, 159);
-	edgeFilter(gausImg, magImg, dirImg, gx, gy, 2);
-	nonMaxSuppress(magImg, dirImg, dst, th, 3);
-	
-	muReleaseImage(&gausImg);
-	muReleaseImage(&magImg);
-	muReleaseImage(&dirImg);
+	/* NMS rows [4, height-4) */
+	nband = (height - 8 + MU_CANNY_BAND - 1) / MU_CANNY_BAND;
 
-	return MU_ERR_SUCCESS;
-}
+#pragma omp parallel for
+	for(b=0; b<nband; b++)
+	{
+		MU_16S *gbuf, *mbuf;
+		MU_8U *dbuf;
+		const MU_8U *rows[5];
+		const MU_16S *g[3], *m[3];
+		MU_32S y0, y1, y, i;
+
+		y0 = 4 + b*MU_CANNY_BAND;
+		y1 = y0 + MU_CANNY_BAND < height - 4 ? y0 + MU_CANNY_BAND : height - 4;
+
+		gbuf = (MU_16S *)calloc(6*width, sizeof(MU_16S));
+		dbuf = (MU_8U *)malloc(3*width);
+		if(gbuf == NULL || dbuf == NULL)
+		{
+#pragma omp critical
+			ret = MU_ERR_OUT_OF_MEMORY;
+			if(gbuf)
+				free(gbuf);
+			if(dbuf)
+				free(dbuf);
+			continue;
+		}
+		mbuf = gbuf + 3*width;
+
+		/* Gaussian rows y-2 .. y+1 and gradient rows y-1, y ahead of the first output row */
+		for(y=y0-2; y<y1+2; y++)
+		{
+			for(i=0; i<5; i++)
+				rows[i] = src->imagedata + (y - 2 + i)*width;
+			muCannyBlurRow(rows, gbuf + (y % 3)*width, width);
+
+			if(y >= y0)
+			{
+				/* gradient row y-1 */
+				for(i=0; i<3; i++)
+					g[i] = gbuf + ((y - 2 + i) % 3)*width;
+				muCannyGradRow(g, mbuf + ((y - 1) % 3)*width, dbuf + ((y - 1) % 3)*width, width);
+			}
+
+			if(y >= y0 + 2)
+			{
+				/* NMS row y-2 */
+				for(i=0; i<3; i++)
+					m[i] = mbuf + ((y - 3 + i) % 3)*width;
+				muCannyNMSRow(m, dbuf + ((y - 2) % 3)*width, dst->imagedata + (y - 2)*width, width, lo, hi);
+			}
+		}
+
+		free(gbuf);
+		free(dbuf);
+	}
 
+	if(ret)
+	{
+		return ret;
+	}
+
+	return muCannyHysteresis(dst);
+}
@@ -28,12 +28,17 @@
  * Author: Joe Lin
  *
  * Description:
- *    Histogram, Histogram equlization.
+ *    Histogram, Histogram equlization, block histograms, CLAHE.
  *
  -------------------------------------------------------------------------- */
 
 #include "muCore.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define MU_HIST_BANKS 8
 
 typedef struct _Link
 {
@@ -128,6 +133,8 @@ muError_t muEqualization( const muImage_t* src, muImage_t* dst)
 /*   output = 32bits level = 256 --> stride  = 256*4 byte                                    */
 /*                                                                                           */
 /*   NOTE                                                                                    */
+/*   The pixels are counted in MU_HIST_BANKS interleaved sub-histograms merged at the end. */
+/*   It is the histogram the global thresholds of muThreshold.c are computed from.          */
 /*                                                                                           */
 /*   USAGE                                                                                   */
 /*   muImage_t *src --> input image                                                           */
@@ -144,28 +151,43 @@ MU_32U* muCreateHistogram()
 muError_t muHistogram( const muImage_t* src, MU_32U *dst)
 {
 	muError_t ret;
-	MU_32S i,j;
+	MU_32U bank[MU_HIST_BANKS][256];
+	MU_32S i, n;
+	const MU_8U *in;
+
+	if( src==NULL || dst==NULL )
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
 	ret = muCheckDepth(2, src, MU_IMG_DEPTH_8U);
 	if(ret)
 	{
 		return ret;
 	}
-    
-	for( i=0;i<256;i++)
-    {
-        dst[i]=0;
-    }
- 	if( src==NULL )
+
+	/* consecutive pixels are counted in different banks so that runs of equal values
+	   do not wait on the increment of the same counter */
+	memset(bank, 0, sizeof(bank));
+	in = src->imagedata;
+	n = src->width*src->height;
+
+	for(i=0; i+8<=n; i+=8)
 	{
-		return MU_ERR_NULL_POINTER;
-	}   
-	for( i=0; i!=src->height; i++)
-    {
-		for(j=0; j!=src->width;j++)
-		{
-            dst[src->imagedata[i*src->width+j]]++;
-        }
-    }
+		bank[0][in[i]]++;
+		bank[1][in[i+1]]++;
+		bank[2][in[i+2]]++;
+		bank[3][in[i+3]]++;
+		bank[4][in[i+4]]++;
+		bank[5][in[i+5]]++;
+		bank[6][in[i+6]]++;
+		bank[7][in[i+7]]++;
+	}
+	for(; i<n; i++)
+		bank[0][in[i]]++;
+
+	for(i=0; i<256; i++)
+		dst[i] = bank[0][i] + bank[1][i] + bank[2][i] + bank[3][i] + bank[4][i] + bank[5][i] + bank[6][i] + bank[7][i];
 
 	return MU_ERR_SUCCESS;
 }
@@ -176,12 +198,12 @@ muError_t muHistogram( const muImage_t* src, MU_32U *dst)
 /*  win_h_s:The height of the block(exchange to shift type)                               */
 /*  win_w_s:The width of the block(exchange to shift type)                                */
 /*  hist_blk_result:The result of histogram (for block)                                    */
-/*                                                                                       */
+/*                                                                                           */
 /*  about hist_blk_result:                                                                 */ 
 /*  size:total number of block*16                                                        */
 /*  save type:                                                                           */
 /*  |block0|block1|..............|block(total number of block)|                          */
-/*                                                                                       */
+/*                                                                                           */
 /*  block:devide the 256bits color into 16 regions                                       */
 /*  Ex: How many pixels of the graylevel from 0 to 15 in the block 5?                    */
 /*  Ans:                                                                                 */
@@ -198,10 +220,8 @@ MU_16U* muCreateHistogramBlk(MU_32S blk_num_h,MU_32S blk_num_v)
       
 muError_t muHistogramBlk(muImage_t* src, MU_16U* hist_blk_result, MU_8U win_h_s, MU_8U win_w_s)
 {
-    MU_32S i,j,win_h=1,win_w=1,blk_num_v,blk_num_h;
-	MU_32S two_2_one_index;
-	MU_32S true_index;
-    MU_32S hist_blk_size;
+	muBlockHist_t *bh;
+	MU_32S i, n;
 	muError_t ret;
 
 	ret = muCheckDepth(2, src, MU_IMG_DEPTH_8U);
@@ -210,51 +230,608 @@ muError_t muHistogramBlk(muImage_t* src, MU_16U* hist_blk_result, MU_8U win_h_s,
 		return ret;
 	}
 
-	if( src==NULL )
+	if( src==NULL || hist_blk_result==NULL )
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	/* 32 bit counters narrowed on the way out, as the 16 bit ones always wrapped */
+	bh = muCreateBlockHist(muRect(0, 0, src->width, src->height), muSize(1 << win_w_s, 1 << win_h_s), 16, MU_IMG_DEPTH_32U);
+	if(bh == NULL)
+	{
+		return MU_ERR_INVALID_PARAMETER;
+	}
+
+	ret = muCalcBlockHist(src, NULL, bh);
+	n = bh->grid.width*bh->grid.height*16;
+	for(i=0; i<n; i++)
+	{
+		hist_blk_result[i] = (MU_16U)((MU_32U *)bh->data)[i];
+	}
+
+	muReleaseBlockHist(&bh);
+
+	return ret;
+}
+
+/*===========================================================================================*/
+/*   Block histograms                                                                        */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   A muBlockHist_t splits a ROI into a grid of blocks (the last column and row of blocks   */
+/*   take what is left) and keeps bins counters per block. muCalcBlockHist fills it in one   */
+/*   pass over the pixels in memory order: the bin of a value comes from a 256 entry table,  */
+/*   the counters of a block row are accumulated in 32 bits and stored once, and the block   */
+/*   rows run in parallel. With a change mask only the blocks holding a non-zero mask pixel  */
+/*   are recounted, the others keep the counts of the previous frame.                        */
+/*===========================================================================================*/
+
+/* 1 if a row segment holds a non-zero byte */
+static MU_32S muBlockHistAny(const MU_8U *p, MU_32S n)
+{
+	MU_32S x = 0;
+
+#if defined(__SSE2__)
+	const __m128i z = _mm_setzero_si128();
+
+	for(; x+16<=n; x+=16)
+		if(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + x)), z)) != 0xFFFF)
+			return 1;
+#endif
+
+	for(; x<n; x++)
+		if(p[x])
+			return 1;
+
+	return 0;
+}
+
+muBlockHist_t *muCreateBlockHist(muRect_t roi, muSize_t block, MU_32S bins, MU_32S depth)
+{
+	muBlockHist_t *bh;
+	MU_32S size;
+
+	if(roi.x < 0 || roi.y < 0 || roi.width <= 0 || roi.height <= 0 || block.width <= 0 || block.height <= 0 ||
+	   bins < 1 || bins > 256 || (depth != MU_IMG_DEPTH_16U && depth != MU_IMG_DEPTH_32U))
+	{
+		return NULL;
+	}
+
+	/* 16 bit counters must hold a whole block */
+	if(depth == MU_IMG_DEPTH_16U && (MU_64F)block.width*block.height > 65535)
+	{
+		return NULL;
+	}
+
+	bh = (muBlockHist_t *)malloc(sizeof(muBlockHist_t));
+	if(bh == NULL)
+	{
+		return NULL;
+	}
+
+	bh->roi = roi;
+	bh->block = block;
+	bh->grid.width = (roi.width + block.width - 1)/block.width;
+	bh->grid.height = (roi.height + block.height - 1)/block.height;
+	bh->bins = bins;
+	bh->depth = depth;
+
+	size = bh->grid.width*bh->grid.height*bins*(depth == MU_IMG_DEPTH_16U ? sizeof(MU_16U) : sizeof(MU_32U));
+	bh->data = calloc(size, 1);
+	if(bh->data == NULL)
+	{
+		free(bh);
+		return NULL;
+	}
+
+	return bh;
+}
+
+muError_t muReleaseBlockHist(muBlockHist_t **bh)
+{
+	if(bh == NULL || *bh == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	free((*bh)->data);
+	free(*bh);
+	*bh = NULL;
+
+	return MU_ERR_SUCCESS;
+}
+
+/*===========================================================================================*/
+/*   muCalcBlockHist                                                                         */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine counts the pixels of every block of bh: value v of src goes to bin         */
+/*   v*bins/256 of its block. Block (bx, by) has its counters at                             */
+/*   data[((by*grid.width) + bx)*bins].                                                      */
+/*                                                                                           */
+/*   NOTE                                                                                    */
+/*   With mask != NULL (an 8U image of the src size) only the blocks where mask has a        */
+/*   non-zero pixel are recounted, e.g. from a frame difference.                             */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muImage_t *src --> input image                                                          */
+/*   muImage_t *mask --> change mask or NULL                                                 */
+/*   muBlockHist_t *bh --> block histogram from muCreateBlockHist                            */
+/*===========================================================================================*/
+muError_t muCalcBlockHist(const muImage_t *src, const muImage_t *mask, muBlockHist_t *bh)
+{
+	MU_8U lut[256];
+	MU_32S i, by;
+	muError_t ret = MU_ERR_SUCCESS;
+
+	if(src == NULL || bh == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	if(src->depth != MU_IMG_DEPTH_8U || src->channels != 1 ||
+	   (mask && (mask->depth != MU_IMG_DEPTH_8U || mask->channels != 1)))
+	{
+		return MU_ERR_NOT_SUPPORT;
+	}
+
+	if(bh->roi.x + bh->roi.width > src->width || bh->roi.y + bh->roi.height > src->height ||
+	   (mask && (mask->width != src->width || mask->height != src->height)))
+	{
+		return MU_ERR_INVALID_PARAMETER;
+	}
+
+	for(i=0; i<256; i++)
+		lut[i] = (MU_8U)((i*bh->bins) >> 8);
+
+#pragma omp parallel for
+	for(by=0; by<bh->grid.height; by++)
+	{
+		MU_32U *cnt, *c;
+		MU_8U *touched;
+		const MU_8U *in;
+		MU_32S gw, bins, y0, y1, bx, x0, x1, x, y, n;
+
+		gw = bh->grid.width;
+		bins = bh->bins;
+		y0 = bh->roi.y + by*bh->block.height;
+		y1 = y0 + bh->block.height < bh->roi.y + bh->roi.height ? y0 + bh->block.height : bh->roi.y + bh->roi.height;
+
+		cnt = (MU_32U *)malloc(gw*bins*sizeof(MU_32U));
+		touched = (MU_8U *)malloc(gw);
+		if(cnt == NULL || touched == NULL)
+		{
+#pragma omp critical
+			ret = MU_ERR_OUT_OF_MEMORY;
+			if(cnt)
+				free(cnt);
+			if(touched)
+				free(touched);
+			continue;
+		}
+
+		n = 0;
+		for(bx=0; bx<gw; bx++)
+		{
+			x0 = bh->roi.x + bx*bh->block.width;
+			x1 = x0 + bh->block.width < bh->roi.x + bh->roi.width ? x0 + bh->block.width : bh->roi.x + bh->roi.width;
+
+			touched[bx] = 1;
+			if(mask)
+			{
+				touched[bx] = 0;
+				for(y=y0; y<y1 && !touched[bx]; y++)
+					touched[bx] = (MU_8U)muBlockHistAny(mask->imagedata + y*mask->width + x0, x1 - x0);
+			}
+
+			if(touched[bx])
+			{
+				memset(cnt + bx*bins, 0, bins*sizeof(MU_32U));
+				n++;
+			}
+		}
+
+		if(n)
+		{
+			for(y=y0; y<y1; y++)
+			{
+				in = src->imagedata + y*src->width;
+				for(bx=0; bx<gw; bx++)
+				{
+					if(!touched[bx])
+						continue;
+
+					x0 = bh->roi.x + bx*bh->block.width;
+					x1 = x0 + bh->block.width < bh->roi.x + bh->roi.width ? x0 + bh->block.width : bh->roi.x + bh->roi.width;
+					c = cnt + bx*bins;
+
+					for(x=x0; x+4<=x1; x+=4)
+					{
+						c[lut[in[x]]]++;
+						c[lut[in[x+1]]]++;
+						c[lut[in[x+2]]]++;
+						c[lut[in[x+3]]]++;
+					}
+					for(; x<x1; x++)
+						c[lut[in[x]]]++;
+				}
+			}
+
+			for(bx=0; bx<gw; bx++)
+			{
+				if(!touched[bx])
+					continue;
+
+				c = cnt + bx*bins;
+				if(bh->depth == MU_IMG_DEPTH_16U)
+				{
+					MU_16U *out = (MU_16U *)bh->data + (by*gw + bx)*bins;
+					for(x=0; x<bins; x++)
+						out[x] = (MU_16U)c[x];
+				}
+				else
+				{
+					memcpy((MU_32U *)bh->data + (by*gw + bx)*bins, c, bins*sizeof(MU_32U));
+				}
+			}
+		}
+
+		free(cnt);
+		free(touched);
+	}
+
+	return ret;
+}
+
+/*===========================================================================================*/
+/*   CLAHE                                                                                   */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   Tile i of an axis of n pixels cut in g tiles spans [i*n/g, (i+1)*n/g), so the grid is   */
+/*   kept as asked and tile sizes differ by at most one pixel. The tile histograms are       */
+/*   gathered in one pass, tile rows in parallel. Each tile clips its histogram              */
+/*   at clipLimit times the mean bin count, spreads the excess evenly over all bins and      */
+/*   turns the cdf into a LUT; tiles run in parallel. With temporal smoothing the float      */
+/*   LUTs are blended with those of the previous frame before they are rounded.              */
+/*   Every pixel is then mapped by the 4 LUTs of the tile centres around it, weighted        */
+/*   bilinearly: the LUT lookups are scalar, the blend runs on 8 pixels per SSE2 step in     */
+/*   7 bit fixed point.                                                                      */
+/*===========================================================================================*/
+
+#define MU_CLAHE_SHIFT 7
+#define MU_CLAHE_ONE   (1 << MU_CLAHE_SHIFT)
+
+muCLAHE_t *muCreateCLAHE(muSize_t tiles, MU_64F clipLimit, MU_64F smooth)
+{
+	muCLAHE_t *c;
+
+	if(tiles.width < 1 || tiles.height < 1 || smooth < 0 || smooth >= 1)
+	{
+		return NULL;
+	}
+
+	c = (muCLAHE_t *)malloc(sizeof(muCLAHE_t));
+	if(c == NULL)
+	{
+		return NULL;
+	}
+
+	c->tiles = tiles;
+	c->clipLimit = clipLimit;
+	c->smooth = smooth;
+	c->size = muSize(0, 0);
+	c->lut = NULL;
+
+	return c;
+}
+
+muError_t muReleaseCLAHE(muCLAHE_t **c)
+{
+	if(c == NULL || *c == NULL)
 	{
 		return MU_ERR_NULL_POINTER;
 	}
-	for(i=0;i<win_h_s;i++)
-	{
-		win_h*=2;
-	}
-	for(i=0;i<win_w_s;i++)
-	{
-		win_w*=2;
-	}
-    if (src->height%win_h  != 0)
-    {
-        blk_num_v=src->height/win_h+1;
-    }
-    else
-    {
-        blk_num_v=src->height/win_h;
-    }
-    if (src->width%win_w != 0)
-    {
-        blk_num_h=src->width/win_w+1;
-    }
-    else
-    {
-        blk_num_h=src->width/win_w;
-    }
-	hist_blk_size=blk_num_h*blk_num_v<<4;
-	for (i=0; i!=hist_blk_size; i++)
-	{
-		hist_blk_result[i]=0;
-	}
-	for( i=0; i!=src->height; i++)
-    {
-		for(j=0; j!=src->width;j++)
+
+	if((*c)->lut)
+		free((*c)->lut);
+	free(*c);
+	*c = NULL;
+
+	return MU_ERR_SUCCESS;
+}
+
+/* clipped and equalized LUT of one tile histogram */
+static void muCLAHETileLut(const MU_32U *hist, MU_64F clipLimit, MU_32F *lut)
+{
+	MU_32U h[256];
+	MU_32S i, area = 0, limit, excess = 0, add, rest, step;
+	MU_64F sum, scale;
+
+	for(i=0; i<256; i++)
+	{
+		h[i] = hist[i];
+		area += hist[i];
+	}
+
+	if(clipLimit > 0)
+	{
+		limit = (MU_32S)(clipLimit*area/256);
+		limit = limit < 1 ? 1 : limit;
+
+		for(i=0; i<256; i++)
 		{
-			two_2_one_index=(i>>win_h_s)*blk_num_h+(j>>win_w_s);
-			true_index=(two_2_one_index<<4)+(src->imagedata[i*src->width+j]>>4);
-            if (true_index > hist_blk_size)
+			if((MU_32S)h[i] > limit)
 			{
-				return MU_ERR_INVALID_PARAMETER;
-            }
-			hist_blk_result[true_index]++;
+				excess += h[i] - limit;
+				h[i] = limit;
+			}
 		}
+
+		/* the excess goes to every bin, what does not divide to evenly spaced ones */
+		add = excess/256;
+		rest = excess - add*256;
+		step = rest ? 256/rest : 0;
+		for(i=0; i<256; i++)
+			h[i] += add;
+		for(i=0; i<256 && rest > 0; i+=step, rest--)
+			h[i]++;
 	}
-    return MU_ERR_SUCCESS;
+
+	sum = 0;
+	scale = area ? 255.0/area : 0;
+	for(i=0; i<256; i++)
+	{
+		sum += h[i];
+		lut[i] = (MU_32F)(sum*scale);
+	}
+}
+
+/* first pixel of tile i of an axis of n pixels cut in grid tiles */
+#define MU_CLAHE_EDGE(i, n, grid) ((MU_32S)((MU_64S)(i)*(n)/(grid)))
+
+/* centre of tile i of an axis of n pixels cut in grid tiles */
+static MU_64F muCLAHECentre(MU_32S i, MU_32S n, MU_32S grid)
+{
+	return (MU_CLAHE_EDGE(i, n, grid) + MU_CLAHE_EDGE(i+1, n, grid))*0.5 - 0.5;
+}
+
+/* per pixel of an axis: the tile centre at or before it and the weight of the next one */
+static void muCLAHEAxis(MU_32S n, MU_32S grid, MU_32S *idx, MU_16S *wt)
+{
+	MU_32S p, i = 0;
+	MU_64F c0, c1;
+
+	for(p=0; p<n; p++)
+	{
+		while(i+1 < grid && p >= muCLAHECentre(i+1, n, grid))
+			i++;
+
+		idx[p] = i;
+		c0 = muCLAHECentre(i, n, grid);
+		if(i+1 >= grid || p <= c0)
+		{
+			wt[p] = 0;
+		}
+		else
+		{
+			c1 = muCLAHECentre(i+1, n, grid);
+			wt[p] = (MU_16S)muRound((p - c0)/(c1 - c0)*MU_CLAHE_ONE);
+		}
+	}
+}
+
+/* one row: lut0 / lut1 the LUT rows of the tile rows above and below, wy the weight of lut1 */
+static void muCLAHERow(const MU_8U *in, MU_8U *out, MU_32S width, const MU_8U *lut0, const MU_8U *lut1, MU_32S wy,
+					   const MU_32S *ix, const MU_16S *wx, MU_32S gw)
+{
+	MU_32S x = 0, i0, i1, v, top, bot;
+	const MU_8U *a, *b, *c, *d;
+
+	while(x < width)
+	{
+		MU_32S x1 = x;
+
+		/* a run of pixels between the same two tile centres */
+		i0 = ix[x];
+		while(x1 < width && ix[x1] == i0)
+			x1++;
+		i1 = i0 + 1 < gw ? i0 + 1 : i0;
+		a = lut0 + i0*256;
+		b = lut0 + i1*256;
+		c = lut1 + i0*256;
+		d = lut1 + i1*256;
+
+#if defined(__SSE2__)
+		{
+			MU_16S ta[8], tb[8], tc[8], td[8];
+			const __m128i one = _mm_set1_epi16(MU_CLAHE_ONE);
+			const __m128i wyv = _mm_set1_epi32((MU_CLAHE_ONE - wy) | (wy << 16));
+			const __m128i rnd = _mm_set1_epi32(1 << (2*MU_CLAHE_SHIFT - 1));
+			__m128i w, t, s, lo, hi;
+			MU_32S k;
+
+			for(; x+8<=x1; x+=8)
+			{
+				for(k=0; k<8; k++)
+				{
+					v = in[x+k];
+					ta[k] = a[v];
+					tb[k] = b[v];
+					tc[k] = c[v];
+					td[k] = d[v];
+				}
+
+				/* horizontal blends in Q7 (at most 255*128, still a positive 16 bit value) */
+				w = _mm_loadu_si128((const __m128i *)(wx + x));
+				t = _mm_add_epi16(_mm_mullo_epi16(_mm_loadu_si128((const __m128i *)ta), _mm_sub_epi16(one, w)),
+								  _mm_mullo_epi16(_mm_loadu_si128((const __m128i *)tb), w));
+				s = _mm_add_epi16(_mm_mullo_epi16(_mm_loadu_si128((const __m128i *)tc), _mm_sub_epi16(one, w)),
+								  _mm_mullo_epi16(_mm_loadu_si128((const __m128i *)td), w));
+
+				/* vertical blend of (top, bottom) pairs by madd, Q14 */
+				lo = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpacklo_epi16(t, s), wyv), rnd), 2*MU_CLAHE_SHIFT);
+				hi = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(_mm_unpackhi_epi16(t, s), wyv), rnd), 2*MU_CLAHE_SHIFT);
+				lo = _mm_packs_epi32(lo, hi);
+				_mm_storel_epi64((__m128i *)(out + x), _mm_packus_epi16(lo, lo));
+			}
+		}
+#endif
+
+		for(; x<x1; x++)
+		{
+			v = in[x];
+			top = a[v]*(MU_CLAHE_ONE - wx[x]) + b[v]*wx[x];
+			bot = c[v]*(MU_CLAHE_ONE - wx[x]) + d[v]*wx[x];
+			out[x] = (MU_8U)((top*(MU_CLAHE_ONE - wy) + bot*wy + (1 << (2*MU_CLAHE_SHIFT - 1))) >> (2*MU_CLAHE_SHIFT));
+		}
+	}
+}
+
+/*===========================================================================================*/
+/*   muCLAHE                                                                                 */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   Contrast-limited adaptive histogram equalization: every tile of the grid of c gets      */
+/*   its own clipped equalization LUT and pixels are mapped by a bilinear blend of the       */
+/*   LUTs of the 4 nearest tile centres.                                                     */
+/*                                                                                           */
+/*   NOTE                                                                                    */
+/*   The grid is tiles.width x tiles.height (at most one tile per pixel), tile sizes of an   */
+/*   axis differ by at most one pixel. clipLimit is a multiple of the mean bin count (2~4    */
+/*   is usual, <= 0 disables clipping). smooth in [0, 1) blends the LUTs of the previous     */
+/*   call, sized alike, in:                                                                  */
+/*   lut = smooth*previous + (1-smooth)*current, to steady video.                            */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muImage_t *src --> input image                                                          */
+/*   muImage_t *dst --> output image, may be src                                             */
+/*   muCLAHE_t *c --> parameters and LUT state from muCreateCLAHE                            */
+/*===========================================================================================*/
+muError_t muCLAHE(const muImage_t *src, muImage_t *dst, muCLAHE_t *c)
+{
+	MU_32S width, height, gw, gh, t, y, nlut;
+	MU_32S *ix, *iy, *tx;
+	MU_16S *wx, *wy;
+	MU_32U *hist;
+	MU_8U *lut;
+	MU_32F *cur;
+	muError_t ret;
+
+	if(c == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	ret = muCheckDepth(4, src, MU_IMG_DEPTH_8U, dst, MU_IMG_DEPTH_8U);
+	if(ret)
+	{
+		return ret;
+	}
+
+	if(src->channels != 1 || dst->channels != 1)
+	{
+		return MU_ERR_NOT_SUPPORT;
+	}
+
+	if(src->width != dst->width || src->height != dst->height)
+	{
+		return MU_ERR_INVALID_PARAMETER;
+	}
+
+	width = src->width;
+	height = src->height;
+
+	/* no empty tiles */
+	gw = c->tiles.width < width ? c->tiles.width : width;
+	gh = c->tiles.height < height ? c->tiles.height : height;
+	nlut = gw*gh*256;
+
+	hist = (MU_32U *)calloc(nlut, sizeof(MU_32U));
+	cur = (MU_32F *)malloc(nlut*sizeof(MU_32F));
+	lut = (MU_8U *)malloc(nlut);
+	ix = (MU_32S *)malloc((2*width + height)*sizeof(MU_32S));
+	wx = (MU_16S *)malloc((width + height)*sizeof(MU_16S));
+	if(hist == NULL || cur == NULL || lut == NULL || ix == NULL || wx == NULL)
+	{
+		if(hist)
+			free(hist);
+		if(cur)
+			free(cur);
+		if(lut)
+			free(lut);
+		if(ix)
+			free(ix);
+		if(wx)
+			free(wx);
+		return MU_ERR_OUT_OF_MEMORY;
+	}
+	iy = ix + width;
+	tx = iy + height;
+	wy = wx + width;
+
+	for(t=0; t<gw; t++)
+	{
+		MU_32S x;
+
+		for(x=MU_CLAHE_EDGE(t, width, gw); x<MU_CLAHE_EDGE(t+1, width, gw); x++)
+			tx[x] = t*256;
+	}
+
+	/* tile histograms, every tile row owns its own counters */
+#pragma omp parallel for
+	for(t=0; t<gh; t++)
+	{
+		MU_32U *h = hist + t*gw*256;
+		const MU_8U *in;
+		MU_32S x, yy;
+
+		for(yy=MU_CLAHE_EDGE(t, height, gh); yy<MU_CLAHE_EDGE(t+1, height, gh); yy++)
+		{
+			in = src->imagedata + yy*width;
+			for(x=0; x<width; x++)
+				h[tx[x] + in[x]]++;
+		}
+	}
+
+#pragma omp parallel for
+	for(t=0; t<gw*gh; t++)
+		muCLAHETileLut(hist + t*256, c->clipLimit, cur + t*256);
+
+	free(hist);
+
+	/* temporal smoothing against the LUTs of the previous frame of the same geometry */
+	if(c->smooth > 0 && c->lut && c->size.width == width && c->size.height == height)
+	{
+		for(t=0; t<nlut; t++)
+			c->lut[t] = (MU_32F)(c->smooth*c->lut[t] + (1 - c->smooth)*cur[t]);
+		free(cur);
+	}
+	else
+	{
+		if(c->lut)
+			free(c->lut);
+		c->lut = cur;
+		c->size = muSize(width, height);
+	}
+
+	for(t=0; t<nlut; t++)
+		lut[t] = (MU_8U)(c->lut[t] + 0.5F);
+
+	muCLAHEAxis(width, gw, ix, wx);
+	muCLAHEAxis(height, gh, iy, wy);
+
+#pragma omp parallel for
+	for(y=0; y<height; y++)
+	{
+		MU_32S j0 = iy[y], j1 = iy[y] + 1 < gh ? iy[y] + 1 : iy[y];
+
+		muCLAHERow(src->imagedata + y*width, dst->imagedata + y*width, width,
+				   lut + j0*gw*256, lut + j1*gw*256, wy[y], ix, wx, gw);
+	}
+
+	free(lut);
+	free(ix);
+	free(wx);
+
+	return MU_ERR_SUCCESS;
 }
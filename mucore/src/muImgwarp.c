@@ -34,6 +34,10 @@
 
 #include "muCore.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 /* Resizes image (input array is resized to fit the destination array) */
 muError_t muResize( const muImage_t* src, muImage_t* dst,
 		MU_32S interpolation MU_DEFAULT( MU_INTER_NN ) )
@@ -333,6 +337,277 @@ muError_t muBilinearScale(const muImage_t *in, muImage_t *out)
 }
 
 
+/*  Area resampling table: output i averages src[ofs[i] .. ofs[i]+cnt[i]-1] with fixed-point
+    weights that sum to one, the boundary pixels are weighted by their coverage. */
+static void muAreaTable(MU_32S slen, MU_32S dlen, MU_32S one, MU_32S *ofs, MU_32S *cnt, MU_32S *wofs, MU_32S *wt)
+{
+	MU_64F scale, f0, f1, cov;
+	MU_32S i, k, n, k0, k1, sum, big;
+
+	scale = slen / (MU_64F)dlen;
+	n = 0;
+	for(i=0; i<dlen; i++)
+	{
+		f0 = i*scale;
+		f1 = (i+1)*scale;
+		if(f1 > slen)
+			f1 = slen;
+		k0 = (MU_32S)f0;
+		k1 = (MU_32S)ceil(f1);
+		if(k1 <= k0)
+			k1 = k0 + 1;
+		if(k1 > slen)
+			k1 = slen;
+
+		ofs[i] = k0;
+		cnt[i] = k1 - k0;
+		wofs[i] = n;
+		sum = 0;
+		big = n;
+		for(k=k0; k<k1; k++)
+		{
+			cov = (k+1 < f1 ? k+1 : f1) - (k > f0 ? k : f0);
+			wt[n] = (MU_32S)(cov*one/(f1 - f0) + 0.5);
+			sum += wt[n];
+			if(wt[n] > wt[big])
+				big = n;
+			n++;
+		}
+		wt[big] += one - sum;
+	}
+}
+
+/*  Adds w * luma row to the column accumulators. ps is the byte distance of two luma
+    samples (2 for packed 4:2:2) and off the position of the first one. */
+static void muAccumulateLumaRow(const MU_8U *row, MU_32S ps, MU_32S off, MU_32S w, MU_32S *acc, MU_32S width)
+{
+	MU_32S x = 0;
+
+#if defined(__SSE2__)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i mask = _mm_set1_epi16(0x00ff);
+		const __m128i wv = _mm_set1_epi32(w);
+		__m128i v;
+
+		for(; x+8<=width; x+=8)
+		{
+			if(ps == 1)
+				v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(row + x)), zero);
+			else if(off == 0)
+				v = _mm_and_si128(_mm_loadu_si128((const __m128i *)(row + x*2)), mask);
+			else
+				v = _mm_srli_epi16(_mm_loadu_si128((const __m128i *)(row + x*2)), 8);
+
+			/* zero extended samples against (w, 0) pairs, madd gives the 32 bit products */
+			_mm_storeu_si128((__m128i *)(acc + x), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(acc + x)),
+							 _mm_madd_epi16(_mm_unpacklo_epi16(v, zero), wv)));
+			_mm_storeu_si128((__m128i *)(acc + x + 4), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(acc + x + 4)),
+							 _mm_madd_epi16(_mm_unpackhi_epi16(v, zero), wv)));
+		}
+	}
+#endif
+
+	for(; x<width; x++)
+	{
+		acc[x] += w * row[x*ps + off];
+	}
+}
+
+/*===========================================================================================*/
+/*   muYUVtoGrayScale                                                                        */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine reads the luma of a YUV frame and writes a grayscale image of the dst size */
+/*   in one pass, replacing YUV->RGB, RGB->gray and a down scale for analytics input.        */
+/*                                                                                           */
+/*   NOTE                                                                                    */
+/*   MU_INTER_AREA averages the covered source pixels with fixed-point weights, the source   */
+/*   rows are accumulated per column (SSE2) and then reduced horizontally. It is meant for   */
+/*   down scaling, e.g. FHD->CIF. MU_INTER_LINEAR samples the pixel centers bilinearly and   */
+/*   MU_INTER_NN picks the nearest pixel; both only read the rows they need.                 */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   const muPlanarImage_t *src --> input frame, any MU_YUV_XXX layout                       */
+/*   muImage_t *dst --> output gray image, 1 channel                                         */
+/*   MU_32S interpolation --> MU_INTER_AREA, MU_INTER_LINEAR or MU_INTER_NN                  */
+/*===========================================================================================*/
+muError_t muYUVtoGrayScale(const muPlanarImage_t *src, muImage_t *dst, MU_32S interpolation)
+{
+	const MU_8U *base;
+	MU_32S sw, sh, dw, dh, ps, off, step;
+	MU_32S *xofs, *xcnt, *xwofs, *xwt;
+	MU_32S *yofs, *ycnt, *ywofs, *ywt;
+	MU_32S i, j;
+	MU_64F scale, f;
+	muError_t ret;
+
+	if(src == NULL || dst == NULL || src->data[0] == NULL || dst->imagedata == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	ret = muCheckDepth(2, dst, MU_IMG_DEPTH_8U);
+	if(ret)
+	{
+		return ret;
+	}
+
+	if(dst->channels != 1)
+	{
+		return MU_ERR_NOT_SUPPORT;
+	}
+
+	if(interpolation != MU_INTER_AREA && interpolation != MU_INTER_LINEAR && interpolation != MU_INTER_NN)
+	{
+		return MU_ERR_NOT_SUPPORT;
+	}
+
+	sw = src->width;
+	sh = src->height;
+	dw = dst->width;
+	dh = dst->height;
+	base = src->data[0];
+	step = src->step[0];
+	ps = 1;
+	off = 0;
+	if(src->format == MU_YUV_YUYV || src->format == MU_YUV_UYVY)
+	{
+		ps = 2;
+		off = src->format == MU_YUV_UYVY;
+	}
+
+	if(sw <= 0 || sh <= 0 || dw <= 0 || dh <= 0)
+	{
+		return MU_ERR_INVALID_PARAMETER;
+	}
+
+	xofs  = (MU_32S *)malloc(sizeof(MU_32S)*(dw*3 + sw + dw*2 + 1));
+	yofs  = (MU_32S *)malloc(sizeof(MU_32S)*(dh*3 + sh + dh*2 + 1));
+	if(xofs == NULL || yofs == NULL)
+	{
+		if(xofs)
+			free(xofs);
+		if(yofs)
+			free(yofs);
+		return MU_ERR_OUT_OF_MEMORY;
+	}
+	xcnt  = xofs + dw;
+	xwofs = xcnt + dw;
+	xwt   = xwofs + dw;
+	ycnt  = yofs + dh;
+	ywofs = ycnt + dh;
+	ywt   = ywofs + dh;
+
+	if(interpolation == MU_INTER_AREA)
+	{
+		/* Q14 row weights keep the column sums in 32 bits, Q16 column weights reduce in 64 bits */
+		muAreaTable(sw, dw, 1 << 16, xofs, xcnt, xwofs, xwt);
+		muAreaTable(sh, dh, 1 << 14, yofs, ycnt, ywofs, ywt);
+
+#pragma omp parallel private(i, j)
+		{
+			MU_32S k;
+			MU_64S s;
+			MU_32S *acc, *w;
+			const MU_32S *a;
+			MU_8U *out;
+
+			acc = (MU_32S *)malloc(sizeof(MU_32S)*sw);
+
+#pragma omp for
+			for(j=0; j<dh; j++)
+			{
+				if(acc == NULL)
+					continue;
+
+				memset(acc, 0, sizeof(MU_32S)*sw);
+				for(k=0; k<ycnt[j]; k++)
+				{
+					muAccumulateLumaRow(base + (yofs[j] + k)*step, ps, off, ywt[ywofs[j] + k], acc, sw);
+				}
+
+				out = dst->imagedata + j*dw;
+				for(i=0; i<dw; i++)
+				{
+					a = acc + xofs[i];
+					w = xwt + xwofs[i];
+					s = (MU_64S)1 << 29;
+					for(k=0; k<xcnt[i]; k++)
+					{
+						s += (MU_64S)w[k]*a[k];
+					}
+					out[i] = (MU_8U)(s >> 30);
+				}
+			}
+
+			if(acc)
+				free(acc);
+		}
+	}
+	else
+	{
+		/* pixel center aligned positions, xcnt/ycnt hold the Q8 fraction */
+		scale = sw / (MU_64F)dw;
+		for(i=0; i<dw; i++)
+		{
+			f = interpolation == MU_INTER_NN ? (i + 0.5)*scale : (i + 0.5)*scale - 0.5;
+			if(f < 0)
+				f = 0;
+			xofs[i] = (MU_32S)f;
+			xcnt[i] = interpolation == MU_INTER_NN ? 0 : (MU_32S)((f - xofs[i])*256.0 + 0.5);
+			if(xofs[i] >= sw - 1)
+			{
+				xofs[i] = sw - 1;
+				xcnt[i] = 0;
+			}
+		}
+		scale = sh / (MU_64F)dh;
+		for(j=0; j<dh; j++)
+		{
+			f = interpolation == MU_INTER_NN ? (j + 0.5)*scale : (j + 0.5)*scale - 0.5;
+			if(f < 0)
+				f = 0;
+			yofs[j] = (MU_32S)f;
+			ycnt[j] = interpolation == MU_INTER_NN ? 0 : (MU_32S)((f - yofs[j])*256.0 + 0.5);
+			if(yofs[j] >= sh - 1)
+			{
+				yofs[j] = sh - 1;
+				ycnt[j] = 0;
+			}
+		}
+
+#pragma omp parallel for private(i)
+		for(j=0; j<dh; j++)
+		{
+			const MU_8U *r0, *r1;
+			MU_32S x0, x1, ax, fy, t0, t1;
+			MU_8U *out;
+
+			r0 = base + yofs[j]*step + off;
+			r1 = ycnt[j] ? r0 + step : r0;
+			fy = ycnt[j];
+			out = dst->imagedata + j*dw;
+
+			for(i=0; i<dw; i++)
+			{
+				x0 = xofs[i]*ps;
+				ax = xcnt[i];
+				x1 = ax ? x0 + ps : x0;
+				t0 = r0[x0]*(256 - ax) + r0[x1]*ax;
+				t1 = r1[x0]*(256 - ax) + r1[x1]*ax;
+				out[i] = (MU_8U)((t0*(256 - fy) + t1*fy + 32768) >> 16);
+			}
+		}
+	}
+
+	free(xofs);
+	free(yofs);
+
+	return MU_ERR_SUCCESS;
+}
+
+
 /*===========================================================================================*/
 /*   muImageRotate                                                                           */
 /*                                                                                           */
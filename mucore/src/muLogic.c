@@ -35,6 +35,10 @@
 /* MU include files */
 #include "muCore.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 
 /*===========================================================================================*/
 /*   muAnd                                                                                  */
@@ -200,3 +204,339 @@ muError_t muOr(const muImage_t *src1, muImage_t *src2, muImage_t *dst)
 }
 
 
+/* mask of the bits inside the last word of a row */
+static MU_64U muBitLastMask(MU_32S width)
+{
+	return width & 63 ? ((MU_64U)1 << (width & 63)) - 1 : ~(MU_64U)0;
+}
+
+static MU_32S muPopCount64(MU_64U v)
+{
+#if defined(__GNUC__)
+	return __builtin_popcountll(v);
+#else
+	v = v - ((v >> 1) & 0x5555555555555555ULL);
+	v = (v & 0x3333333333333333ULL) + ((v >> 2) & 0x3333333333333333ULL);
+	v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (MU_32S)((v*0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/*===========================================================================================*/
+/*   muCreateBitMask                                                                         */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine allocates a cleared binary mask holding 64 pixels per MU_64U word, 1 bit   */
+/*   where an 8U mask holds 255. Rows start on a word, so logic operations and counts work   */
+/*   on whole words and move an eighth of the memory of the 8U mask.                         */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muSize_t size --> mask size                                                             */
+/*===========================================================================================*/
+muBitMask_t *muCreateBitMask(muSize_t size)
+{
+	muBitMask_t *mask;
+
+	if(size.width <= 0 || size.height <= 0)
+	{
+		return NULL;
+	}
+
+	mask = (muBitMask_t *)malloc(sizeof(muBitMask_t));
+	if(mask == NULL)
+	{
+		return NULL;
+	}
+
+	mask->size = size;
+	mask->step = (size.width + 63)/64;
+	mask->data = (MU_64U *)calloc(mask->step*size.height, sizeof(MU_64U));
+	if(mask->data == NULL)
+	{
+		free(mask);
+		return NULL;
+	}
+
+	return mask;
+}
+
+muError_t muReleaseBitMask(muBitMask_t **mask)
+{
+	if(mask == NULL || *mask == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	free((*mask)->data);
+	free(*mask);
+	*mask = NULL;
+
+	return MU_ERR_SUCCESS;
+}
+
+/*===========================================================================================*/
+/*   muPackBitMask                                                                           */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine packs an 8U mask: every non-zero pixel sets its bit. SSE2 compares 64      */
+/*   pixels with zero and gathers the four byte masks into one word.                         */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muImage_t *src --> input 8U mask                                                        */
+/*   muBitMask_t *dst --> packed mask of the src size                                        */
+/*===========================================================================================*/
+muError_t muPackBitMask(const muImage_t *src, muBitMask_t *dst)
+{
+	MU_32S width, height, y;
+	muError_t ret;
+
+	if(dst == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	ret = muCheckDepth(2, src, MU_IMG_DEPTH_8U);
+	if(ret)
+	{
+		return ret;
+	}
+
+	if(src->channels != 1)
+	{
+		return MU_ERR_NOT_SUPPORT;
+	}
+
+	width = src->width;
+	height = src->height;
+
+	if(dst->size.width != width || dst->size.height != height)
+	{
+		return MU_ERR_INVALID_PARAMETER;
+	}
+
+#pragma omp parallel for
+	for(y=0; y<height; y++)
+	{
+		const MU_8U *in = src->imagedata + y*width;
+		MU_64U *out = dst->data + y*dst->step;
+		MU_64U word;
+		MU_32S x = 0, b;
+#if defined(__SSE2__)
+		const __m128i zero = _mm_setzero_si128();
+		for(; x+64<=width; x+=64)
+		{
+			MU_64U m0 = (MU_32U)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(in + x)), zero));
+			MU_64U m1 = (MU_32U)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(in + x + 16)), zero));
+			MU_64U m2 = (MU_32U)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(in + x + 32)), zero));
+			MU_64U m3 = (MU_32U)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(in + x + 48)), zero));
+			*out++ = ~(m0 | m1 << 16 | m2 << 32 | m3 << 48);
+		}
+#endif
+		for(; x<width; x+=64)
+		{
+			word = 0;
+			for(b=0; b<64 && x+b<width; b++)
+			{
+				word |= (MU_64U)(in[x+b] != 0) << b;
+			}
+			*out++ = word;
+		}
+	}
+
+	return MU_ERR_SUCCESS;
+}
+
+/*===========================================================================================*/
+/*   muUnpackBitMask                                                                         */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine expands a packed mask to 8U, 255 for a set bit and 0 otherwise. SSE2       */
+/*   spreads 16 bits over 16 bytes and compares each byte with its bit.                      */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muBitMask_t *src --> packed mask                                                        */
+/*   muImage_t *dst --> output 8U mask of the src size                                       */
+/*===========================================================================================*/
+muError_t muUnpackBitMask(const muBitMask_t *src, muImage_t *dst)
+{
+	MU_32S width, height, y;
+	muError_t ret;
+
+	if(src == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	ret = muCheckDepth(2, dst, MU_IMG_DEPTH_8U);
+	if(ret)
+	{
+		return ret;
+	}
+
+	if(dst->channels != 1)
+	{
+		return MU_ERR_NOT_SUPPORT;
+	}
+
+	width = dst->width;
+	height = dst->height;
+
+	if(src->size.width != width || src->size.height != height)
+	{
+		return MU_ERR_INVALID_PARAMETER;
+	}
+
+#pragma omp parallel for
+	for(y=0; y<height; y++)
+	{
+		const MU_64U *in = src->data + y*src->step;
+		MU_8U *out = dst->imagedata + y*width;
+		MU_32S x = 0;
+#if defined(__SSE2__)
+		const __m128i bit = _mm_setr_epi8(1, 2, 4, 8, 16, 32, 64, -128, 1, 2, 4, 8, 16, 32, 64, -128);
+		for(; x+16<=width; x+=16)
+		{
+			MU_32U bits = (MU_32U)(in[x >> 6] >> (x & 63));
+			__m128i v = _mm_unpacklo_epi64(_mm_set1_epi8((char)bits), _mm_set1_epi8((char)(bits >> 8)));
+			_mm_storeu_si128((__m128i *)(out + x), _mm_cmpeq_epi8(_mm_and_si128(v, bit), bit));
+		}
+#endif
+		for(; x<width; x++)
+		{
+			out[x] = (MU_8U)(0 - ((in[x >> 6] >> (x & 63)) & 1));
+		}
+	}
+
+	return MU_ERR_SUCCESS;
+}
+
+/* op 0 and, 1 or, 2 sub */
+static muError_t muBitLogic(const muBitMask_t *src1, const muBitMask_t *src2, muBitMask_t *dst, MU_32S op)
+{
+	MU_32S i, n;
+	const MU_64U *in1, *in2;
+	MU_64U *out;
+
+	if(src1 == NULL || src2 == NULL || dst == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	if(src1->size.width != dst->size.width || src1->size.height != dst->size.height ||
+	   src2->size.width != dst->size.width || src2->size.height != dst->size.height)
+	{
+		return MU_ERR_INVALID_PARAMETER;
+	}
+
+	in1 = src1->data;
+	in2 = src2->data;
+	out = dst->data;
+	n = dst->step*dst->size.height;
+
+	switch(op)
+	{
+		case 0:
+			for(i=0; i<n; i++)
+				out[i] = in1[i] & in2[i];
+			break;
+		case 1:
+			for(i=0; i<n; i++)
+				out[i] = in1[i] | in2[i];
+			break;
+		default:
+			for(i=0; i<n; i++)
+				out[i] = in1[i] ^ in2[i];
+			break;
+	}
+
+	return MU_ERR_SUCCESS;
+}
+
+/*===========================================================================================*/
+/*   muBitAnd, muBitOr, muBitSub                                                             */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   These routines give the packed result of muAnd, muOr and muSub on 0/255 masks, one      */
+/*   word for 64 pixels. muSub takes |src1 - src2|, so muBitSub keeps the pixels set in      */
+/*   exactly one of the masks.                                                               */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muBitMask_t *src1 --> input mask 1                                                      */
+/*   muBitMask_t *src2 --> input mask 2                                                      */
+/*   muBitMask_t *dst --> output mask, may be src1 or src2                                   */
+/*===========================================================================================*/
+muError_t muBitAnd(const muBitMask_t *src1, const muBitMask_t *src2, muBitMask_t *dst)
+{
+	return muBitLogic(src1, src2, dst, 0);
+}
+
+muError_t muBitOr(const muBitMask_t *src1, const muBitMask_t *src2, muBitMask_t *dst)
+{
+	return muBitLogic(src1, src2, dst, 1);
+}
+
+muError_t muBitSub(const muBitMask_t *src1, const muBitMask_t *src2, muBitMask_t *dst)
+{
+	return muBitLogic(src1, src2, dst, 2);
+}
+
+/*===========================================================================================*/
+/*   muBitCount                                                                              */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine counts the set pixels of a packed mask, the area of a foreground mask.     */
+/*   The first and last words of each roi row are masked to the roi, the words between are   */
+/*   counted whole.                                                                          */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muBitMask_t *src --> packed mask                                                        */
+/*   muRect_t *roi --> region inside the mask, NULL for the whole mask                       */
+/*   MU_32U *count --> number of set pixels                                                  */
+/*===========================================================================================*/
+muError_t muBitCount(const muBitMask_t *src, const muRect_t *roi, MU_32U *count)
+{
+	muRect_t r;
+	MU_32S y, w0, w1;
+	MU_64U lo, hi;
+	MU_32U total = 0;
+
+	if(src == NULL || count == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	r = roi ? *roi : muRect(0, 0, src->size.width, src->size.height);
+	if(r.x < 0 || r.y < 0 || r.width <= 0 || r.height <= 0 ||
+	   r.x + r.width > src->size.width || r.y + r.height > src->size.height)
+	{
+		return MU_ERR_INVALID_PARAMETER;
+	}
+
+	w0 = r.x >> 6;
+	w1 = (r.x + r.width - 1) >> 6;
+	lo = ~(MU_64U)0 << (r.x & 63);
+	hi = muBitLastMask(r.x + r.width);
+	if(w0 == w1)
+	{
+		lo &= hi;
+	}
+
+#pragma omp parallel for reduction(+:total)
+	for(y=r.y; y<r.y+r.height; y++)
+	{
+		const MU_64U *row = src->data + y*src->step;
+		MU_32S w;
+		MU_32U c = muPopCount64(row[w0] & lo);
+		if(w1 > w0)
+		{
+			for(w=w0+1; w<w1; w++)
+				c += muPopCount64(row[w]);
+			c += muPopCount64(row[w1] & hi);
+		}
+		total += c;
+	}
+
+	*count = total;
+
+	return MU_ERR_SUCCESS;
+}
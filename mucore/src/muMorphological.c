@@ -35,6 +35,10 @@
 /* MU include files */
 #include "muCore.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 
 /*===========================================================================================*/
 /*   muDilate33                                                                             */
@@ -605,3 +609,575 @@ muError_t muGrayErode33(const muImage_t *src, muImage_t *dst, MU_8U *se)
 	return MU_ERR_SUCCESS;
 
 }
+
+
+/*===========================================================================================*/
+/*   Rectangular morphology                                                                  */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   A k-wide min/max follows van Herk/Gil-Werman: the line, padded with the neutral value   */
+/*   (255 for erosion, 0 for dilation), is cut in blocks of k; g runs the min/max forward    */
+/*   inside each block, h backward, and the window [j, j+k-1] is op(h[j], g[j+k-1]). That    */
+/*   is 3 comparisons per pixel whatever k. Rows run one by one in parallel; the vertical    */
+/*   pass treats a strip of columns as vectors and takes 16 columns per SSE2 step.           */
+/*   Erosion takes the window from x-k/2, dilation the reflected one from x-(k-1)/2, so      */
+/*   openings and closings of even sizes are idempotent too.                                 */
+/*===========================================================================================*/
+
+#define MU_MORPH_STRIP 256
+
+static MU_8U muMorphOp(MU_8U a, MU_8U b, MU_32S dil)
+{
+	return dil ? (a > b ? a : b) : (a < b ? a : b);
+}
+
+#if defined(__SSE2__)
+static __m128i muMorphOp16(__m128i a, __m128i b, MU_32S dil)
+{
+	return dil ? _mm_max_epu8(a, b) : _mm_min_epu8(a, b);
+}
+#endif
+
+/* out[x] = op of in[x-a .. x-a+k-1], buf holds 3*(n+k-1) bytes */
+static void muMorphRow(const MU_8U *in, MU_8U *out, MU_32S n, MU_32S k, MU_32S a, MU_32S dil, MU_8U *buf)
+{
+	MU_8U *e, *g, *h;
+	MU_8U pad = dil ? 0 : 255;
+	MU_32S m = n + k - 1, b, end, j, x;
+
+	e = buf;
+	g = buf + m;
+	h = buf + 2*m;
+
+	memset(e, pad, a);
+	memcpy(e + a, in, n);
+	memset(e + a + n, pad, k - 1 - a);
+
+	for(b=0; b<m; b+=k)
+	{
+		end = b + k < m ? b + k : m;
+
+		g[b] = e[b];
+		for(j=b+1; j<end; j++)
+			g[j] = muMorphOp(g[j-1], e[j], dil);
+
+		h[end-1] = e[end-1];
+		for(j=end-2; j>=b; j--)
+			h[j] = muMorphOp(h[j+1], e[j], dil);
+	}
+
+	x = 0;
+#if defined(__SSE2__)
+	for(; x+16<=n; x+=16)
+		_mm_storeu_si128((__m128i *)(out + x), muMorphOp16(_mm_loadu_si128((const __m128i *)(h + x)), _mm_loadu_si128((const __m128i *)(g + x + k - 1)), dil));
+#endif
+	for(; x<n; x++)
+		out[x] = muMorphOp(h[x], g[x+k-1], dil);
+}
+
+/* the same down columns [x0, x1) of a width-wide image, buf holds 2*(height+k-1)*(x1-x0) bytes */
+static void muMorphColumns(const MU_8U *in, MU_8U *out, MU_32S width, MU_32S height, MU_32S x0, MU_32S x1,
+						   MU_32S k, MU_32S a, MU_32S dil, MU_8U *buf)
+{
+	MU_32S m = height + k - 1, sw = x1 - x0, j, x;
+	MU_8U pad = dil ? 0 : 255;
+	MU_8U *g, *h, *gr, *hr;
+	const MU_8U *er;
+
+	g = buf;
+	h = buf + m*sw;
+
+	/* forward: g row j from g row j-1 and source row j-a */
+	for(j=0; j<m; j++)
+	{
+		gr = g + j*sw;
+		if(j - a < 0 || j - a >= height)
+		{
+			/* op with the neutral value leaves the running value as it is */
+			if(j % k)
+				memcpy(gr, gr - sw, sw);
+			else
+				memset(gr, pad, sw);
+			continue;
+		}
+
+		er = in + (j - a)*width + x0;
+		if(j % k == 0)
+		{
+			memcpy(gr, er, sw);
+			continue;
+		}
+
+		x = 0;
+#if defined(__SSE2__)
+		for(; x+16<=sw; x+=16)
+			_mm_storeu_si128((__m128i *)(gr + x), muMorphOp16(_mm_loadu_si128((const __m128i *)(gr - sw + x)), _mm_loadu_si128((const __m128i *)(er + x)), dil));
+#endif
+		for(; x<sw; x++)
+			gr[x] = muMorphOp(gr[x - sw], er[x], dil);
+	}
+
+	/* backward */
+	for(j=m-1; j>=0; j--)
+	{
+		hr = h + j*sw;
+		if(j - a < 0 || j - a >= height)
+		{
+			if(j < m-1 && (j+1) % k)
+				memcpy(hr, hr + sw, sw);
+			else
+				memset(hr, pad, sw);
+			continue;
+		}
+
+		er = in + (j - a)*width + x0;
+		if(j == m-1 || (j+1) % k == 0)
+		{
+			memcpy(hr, er, sw);
+			continue;
+		}
+
+		x = 0;
+#if defined(__SSE2__)
+		for(; x+16<=sw; x+=16)
+			_mm_storeu_si128((__m128i *)(hr + x), muMorphOp16(_mm_loadu_si128((const __m128i *)(hr + sw + x)), _mm_loadu_si128((const __m128i *)(er + x)), dil));
+#endif
+		for(; x<sw; x++)
+			hr[x] = muMorphOp(hr[x + sw], er[x], dil);
+	}
+
+	for(j=0; j<height; j++)
+	{
+		hr = h + j*sw;
+		gr = g + (j + k - 1)*sw;
+		x = 0;
+#if defined(__SSE2__)
+		for(; x+16<=sw; x+=16)
+			_mm_storeu_si128((__m128i *)(out + j*width + x0 + x), muMorphOp16(_mm_loadu_si128((const __m128i *)(hr + x)), _mm_loadu_si128((const __m128i *)(gr + x)), dil));
+#endif
+		for(; x<sw; x++)
+			out[j*width + x0 + x] = muMorphOp(hr[x], gr[x], dil);
+	}
+}
+
+/* separable pass src -> dst of a kw x kh window anchored at (ax, ay), tmp is a width*height buffer */
+static muError_t muMorphPass(const muImage_t *src, muImage_t *dst, MU_32S kw, MU_32S kh, MU_32S ax, MU_32S ay, MU_32S dil, MU_8U *tmp)
+{
+	MU_32S width, height, y, s, strip;
+	const MU_8U *rows;
+	muError_t ret = MU_ERR_SUCCESS;
+
+	width = src->width;
+	height = src->height;
+	strip = width < MU_MORPH_STRIP ? width : MU_MORPH_STRIP;
+
+	/* rows into tmp, or straight to dst for a 1 pixel high window */
+	rows = src->imagedata;
+	if(kw > 1)
+	{
+		/* one scratch line per thread */
+#pragma omp parallel
+		{
+			MU_8U *buf = (MU_8U *)malloc(3*(width + kw - 1));
+			if(buf == NULL)
+#pragma omp critical
+				ret = MU_ERR_OUT_OF_MEMORY;
+
+#pragma omp for
+			for(y=0; y<height; y++)
+			{
+				if(buf)
+					muMorphRow(src->imagedata + y*width, (kh > 1 ? tmp : dst->imagedata) + y*width, width, kw, ax, dil, buf);
+			}
+
+			if(buf)
+				free(buf);
+		}
+		rows = kh > 1 ? tmp : dst->imagedata;
+	}
+	else if(kh == 1)
+	{
+		if(dst->imagedata != src->imagedata)
+			memcpy(dst->imagedata, src->imagedata, width*height);
+		return MU_ERR_SUCCESS;
+	}
+
+	if(kh > 1 && ret == MU_ERR_SUCCESS)
+	{
+		/* one scratch strip per thread */
+#pragma omp parallel
+		{
+			MU_8U *buf = (MU_8U *)malloc(2*(height + kh - 1)*strip);
+			if(buf == NULL)
+#pragma omp critical
+				ret = MU_ERR_OUT_OF_MEMORY;
+
+#pragma omp for
+			for(s=0; s<(width + MU_MORPH_STRIP - 1)/MU_MORPH_STRIP; s++)
+			{
+				MU_32S x0 = s*MU_MORPH_STRIP, x1 = x0 + MU_MORPH_STRIP < width ? x0 + MU_MORPH_STRIP : width;
+				if(buf)
+					muMorphColumns(rows, dst->imagedata, width, height, x0, x1, kh, ay, dil, buf);
+			}
+
+			if(buf)
+				free(buf);
+		}
+	}
+
+	return ret;
+}
+
+/*===========================================================================================*/
+/*   muMorphology                                                                            */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine performs a morphological operation with a ksize rectangle on a binary or   */
+/*   gray level image, at a cost per pixel that does not depend on ksize.                    */
+/*   MU_MORPH_ERODE    --> minimum over the rectangle                                        */
+/*   MU_MORPH_DILATE   --> maximum over the rectangle                                        */
+/*   MU_MORPH_OPEN     --> erode then dilate                                                 */
+/*   MU_MORPH_CLOSE    --> dilate then erode                                                 */
+/*   MU_MORPH_TOPHAT   --> src - open                                                        */
+/*   MU_MORPH_BLACKHAT --> close - src                                                       */
+/*                                                                                           */
+/*   NOTE                                                                                    */
+/*   dst may be src. Pixels outside the image do not take part.                              */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muImage_t *src --> input image                                                          */
+/*   muImage_t *dst --> output image                                                         */
+/*   op --> operation                                                                        */
+/*   ksize --> width and height of the structuring element                                   */
+/*===========================================================================================*/
+muError_t muMorphology(const muImage_t *src, muImage_t *dst, MU_32S op, muSize_t ksize)
+{
+	MU_32S kw, kh, n, i;
+	MU_8U *tmp, *res;
+	muImage_t tmpImg;
+	muError_t ret;
+
+	ret = muCheckDepth(4, src, MU_IMG_DEPTH_8U, dst, MU_IMG_DEPTH_8U);
+	if(ret)
+	{
+		return ret;
+	}
+
+	if(src->channels != 1 || dst->channels != 1)
+	{
+		return MU_ERR_NOT_SUPPORT;
+	}
+
+	if(src->width != dst->width || src->height != dst->height || ksize.width < 1 || ksize.height < 1 ||
+	   op < MU_MORPH_ERODE || op > MU_MORPH_BLACKHAT)
+	{
+		return MU_ERR_INVALID_PARAMETER;
+	}
+
+	kw = ksize.width;
+	kh = ksize.height;
+	n = src->width*src->height;
+
+	/* the hats keep src for the difference and build the opening or closing aside */
+	tmp = (MU_8U *)malloc(op >= MU_MORPH_TOPHAT ? 2*n : n);
+	if(tmp == NULL)
+	{
+		return MU_ERR_OUT_OF_MEMORY;
+	}
+
+	tmpImg = *dst;
+	tmpImg.imagedata = op >= MU_MORPH_TOPHAT ? tmp + n : dst->imagedata;
+
+	switch(op)
+	{
+		case MU_MORPH_ERODE:
+			ret = muMorphPass(src, dst, kw, kh, kw/2, kh/2, 0, tmp);
+			break;
+		case MU_MORPH_DILATE:
+			ret = muMorphPass(src, dst, kw, kh, (kw-1)/2, (kh-1)/2, 1, tmp);
+			break;
+		case MU_MORPH_OPEN:
+		case MU_MORPH_TOPHAT:
+			ret = muMorphPass(src, &tmpImg, kw, kh, kw/2, kh/2, 0, tmp);
+			if(ret == MU_ERR_SUCCESS)
+				ret = muMorphPass(&tmpImg, &tmpImg, kw, kh, (kw-1)/2, (kh-1)/2, 1, tmp);
+			break;
+		case MU_MORPH_CLOSE:
+		case MU_MORPH_BLACKHAT:
+			ret = muMorphPass(src, &tmpImg, kw, kh, (kw-1)/2, (kh-1)/2, 1, tmp);
+			if(ret == MU_ERR_SUCCESS)
+				ret = muMorphPass(&tmpImg, &tmpImg, kw, kh, kw/2, kh/2, 0, tmp);
+			break;
+	}
+
+	if(ret == MU_ERR_SUCCESS && op >= MU_MORPH_TOPHAT)
+	{
+		res = tmpImg.imagedata;
+		i = 0;
+#if defined(__SSE2__)
+		for(; i+16<=n; i+=16)
+		{
+			__m128i s = _mm_loadu_si128((const __m128i *)(src->imagedata + i));
+			__m128i r = _mm_loadu_si128((const __m128i *)(res + i));
+			_mm_storeu_si128((__m128i *)(dst->imagedata + i), op == MU_MORPH_TOPHAT ? _mm_subs_epu8(s, r) : _mm_subs_epu8(r, s));
+		}
+#endif
+		for(; i<n; i++)
+			dst->imagedata[i] = (MU_8U)(op == MU_MORPH_TOPHAT ? src->imagedata[i] - res[i] : res[i] - src->imagedata[i]);
+	}
+
+	free(tmp);
+
+	return ret;
+}
+
+/* out bit x = in bit x+d for the nout words of out, bits from outside the nin words of in are the bits of fill */
+static MU_VOID muBitShift(const MU_64U *in, MU_32S nin, MU_64U *out, MU_32S nout, MU_32S d, MU_64U fill)
+{
+	MU_32S i, j, q, r;
+	MU_64U lo, hi;
+
+	q = d >= 0 ? d/64 : -((63 - d)/64);
+	r = d - q*64;
+
+	for(i=0; i<nout; i++)
+	{
+		j = i + q;
+		lo = j >= 0 && j < nin ? in[j] : fill;
+		if(r == 0)
+		{
+			out[i] = lo;
+			continue;
+		}
+		hi = j+1 >= 0 && j+1 < nin ? in[j+1] : fill;
+		out[i] = lo >> r | hi << (64 - r);
+	}
+}
+
+/* out bit x = op of in bits [x-a, x-a+k-1] of a width-pixel row, buf holds 2*(n + (a+63)/64) words */
+static MU_VOID muBitMorphRow(const MU_64U *in, MU_64U *out, MU_32S n, MU_32S width, MU_32S k, MU_32S a, MU_32S dil, MU_64U *buf)
+{
+	MU_32S len = n + (a + 63)/64;
+	MU_64U *acc = buf, *sh = buf + len;
+	MU_64U fill = dil ? 0 : ~(MU_64U)0;
+	MU_64U last = width & 63 ? ((MU_64U)1 << (width & 63)) - 1 : ~(MU_64U)0;
+	MU_32S i, m;
+
+	/* bits past the width act as outside, acc bit x is in bit x-a over a line long enough for the windows
+	   starting inside the row */
+	memcpy(sh, in, n*sizeof(MU_64U));
+	sh[n-1] |= fill & ~last;
+	muBitShift(sh, n, acc, len, -a, fill);
+
+	/* acc bit x covers [x, x+m-1], doubled with a shifted copy until 2m > k */
+	for(m=1; 2*m<=k; m*=2)
+	{
+		muBitShift(acc, len, sh, len, m, fill);
+		for(i=0; i<len; i++)
+			acc[i] = dil ? acc[i] | sh[i] : acc[i] & sh[i];
+	}
+	if(k > m)
+	{
+		muBitShift(acc, len, sh, len, k - m, fill);
+		for(i=0; i<len; i++)
+			acc[i] = dil ? acc[i] | sh[i] : acc[i] & sh[i];
+	}
+
+	memcpy(out, acc, n*sizeof(MU_64U));
+	out[n-1] &= last;
+}
+
+/* the same down the words [w0, w1) of step-word rows, buf holds 2*(height+k-1)*(w1-w0) words */
+static MU_VOID muBitMorphColumns(const MU_64U *in, MU_64U *out, MU_32S step, MU_32S height, MU_32S w0, MU_32S w1, MU_32S k, MU_32S a, MU_32S dil, MU_64U *buf)
+{
+	MU_32S nw = w1 - w0, len = height + k - 1;
+	MU_64U *g = buf, *h = buf + len*nw;
+	MU_64U fill = dil ? 0 : ~(MU_64U)0;
+	MU_32S i, y, w, s;
+
+	/* padded line i is row i-a, van Herk/Gil-Werman over blocks of k rows */
+	for(i=0; i<len; i++)
+	{
+		const MU_64U *row = i - a >= 0 && i - a < height ? in + (i - a)*step + w0 : NULL;
+		for(w=0; w<nw; w++)
+		{
+			MU_64U v = row ? row[w] : fill;
+			g[i*nw + w] = i % k == 0 ? v : dil ? g[(i-1)*nw + w] | v : g[(i-1)*nw + w] & v;
+		}
+	}
+	for(s=(len-1)/k*k; s>=0; s-=k)
+	{
+		MU_32S e = s + k < len ? s + k : len;
+		for(i=e-1; i>=s; i--)
+		{
+			const MU_64U *row = i - a >= 0 && i - a < height ? in + (i - a)*step + w0 : NULL;
+			for(w=0; w<nw; w++)
+			{
+				MU_64U v = row ? row[w] : fill;
+				h[i*nw + w] = i == e-1 ? v : dil ? h[(i+1)*nw + w] | v : h[(i+1)*nw + w] & v;
+			}
+		}
+	}
+
+	for(y=0; y<height; y++)
+	{
+		for(w=0; w<nw; w++)
+		{
+			out[y*step + w0 + w] = dil ? h[y*nw + w] | g[(y+k-1)*nw + w] : h[y*nw + w] & g[(y+k-1)*nw + w];
+		}
+	}
+}
+
+/* separable pass src -> dst of a kw x kh window anchored at (ax, ay), tmp holds the src words */
+static muError_t muBitMorphPass(const muBitMask_t *src, muBitMask_t *dst, MU_32S kw, MU_32S kh, MU_32S ax, MU_32S ay, MU_32S dil, MU_64U *tmp)
+{
+	MU_32S step, height, y, s, strip;
+	const MU_64U *rows;
+	muError_t ret = MU_ERR_SUCCESS;
+
+	step = src->step;
+	height = src->size.height;
+
+	rows = src->data;
+	if(kw > 1)
+	{
+		/* one scratch line per thread */
+#pragma omp parallel
+		{
+			MU_64U *buf = (MU_64U *)malloc(2*(step + (ax + 63)/64)*sizeof(MU_64U));
+			if(buf == NULL)
+#pragma omp critical
+				ret = MU_ERR_OUT_OF_MEMORY;
+
+#pragma omp for
+			for(y=0; y<height; y++)
+			{
+				if(buf)
+					muBitMorphRow(src->data + y*step, (kh > 1 ? tmp : dst->data) + y*step, step, src->size.width, kw, ax, dil, buf);
+			}
+
+			if(buf)
+				free(buf);
+		}
+		rows = kh > 1 ? tmp : dst->data;
+	}
+	else if(kh == 1)
+	{
+		if(dst->data != src->data)
+			memcpy(dst->data, src->data, step*height*sizeof(MU_64U));
+		return MU_ERR_SUCCESS;
+	}
+
+	if(kh > 1 && ret == MU_ERR_SUCCESS)
+	{
+		strip = MU_MORPH_STRIP/64;
+
+		/* one scratch strip per thread */
+#pragma omp parallel
+		{
+			MU_64U *buf = (MU_64U *)malloc(2*(height + kh - 1)*(step < strip ? step : strip)*sizeof(MU_64U));
+			if(buf == NULL)
+#pragma omp critical
+				ret = MU_ERR_OUT_OF_MEMORY;
+
+#pragma omp for
+			for(s=0; s<(step + strip - 1)/strip; s++)
+			{
+				MU_32S w0 = s*strip, w1 = w0 + strip < step ? w0 + strip : step;
+				if(buf)
+					muBitMorphColumns(rows, dst->data, step, height, w0, w1, kh, ay, dil, buf);
+			}
+
+			if(buf)
+				free(buf);
+		}
+	}
+
+	return ret;
+}
+
+/*===========================================================================================*/
+/*   muBitMorphology                                                                         */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine is muMorphology on a packed mask, 64 pixels per word operation. A row      */
+/*   window of k pixels ANDs (erosion) or ORs (dilation) the row with shifted copies of      */
+/*   itself, doubling the covered run each time, so log2(k) + 2 shifts. The vertical pass    */
+/*   runs van Herk/Gil-Werman on whole words. Anchors and borders follow muMorphology:       */
+/*   TOPHAT keeps src pixels missing from the opening, BLACKHAT the closing pixels missing   */
+/*   from src.                                                                               */
+/*                                                                                           */
+/*   NOTE                                                                                    */
+/*   dst may be src.                                                                         */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muBitMask_t *src --> input mask                                                         */
+/*   muBitMask_t *dst --> output mask                                                        */
+/*   op --> MU_MORPH_ERODE, MU_MORPH_DILATE, MU_MORPH_OPEN, MU_MORPH_CLOSE, MU_MORPH_TOPHAT  */
+/*          or MU_MORPH_BLACKHAT                                                             */
+/*   ksize --> width and height of the structuring element                                   */
+/*===========================================================================================*/
+muError_t muBitMorphology(const muBitMask_t *src, muBitMask_t *dst, MU_32S op, muSize_t ksize)
+{
+	MU_32S kw, kh, n, i;
+	MU_64U *tmp;
+	muBitMask_t tmpMask;
+	muError_t ret = MU_ERR_SUCCESS;
+
+	if(src == NULL || dst == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	if(src->size.width != dst->size.width || src->size.height != dst->size.height || ksize.width < 1 || ksize.height < 1 ||
+	   op < MU_MORPH_ERODE || op > MU_MORPH_BLACKHAT)
+	{
+		return MU_ERR_INVALID_PARAMETER;
+	}
+
+	kw = ksize.width;
+	kh = ksize.height;
+	n = src->step*src->size.height;
+
+	/* the hats keep src for the difference and build the opening or closing aside */
+	tmp = (MU_64U *)malloc((op >= MU_MORPH_TOPHAT ? 2*n : n)*sizeof(MU_64U));
+	if(tmp == NULL)
+	{
+		return MU_ERR_OUT_OF_MEMORY;
+	}
+
+	tmpMask = *dst;
+	tmpMask.data = op >= MU_MORPH_TOPHAT ? tmp + n : dst->data;
+
+	switch(op)
+	{
+		case MU_MORPH_ERODE:
+			ret = muBitMorphPass(src, dst, kw, kh, kw/2, kh/2, 0, tmp);
+			break;
+		case MU_MORPH_DILATE:
+			ret = muBitMorphPass(src, dst, kw, kh, (kw-1)/2, (kh-1)/2, 1, tmp);
+			break;
+		case MU_MORPH_OPEN:
+		case MU_MORPH_TOPHAT:
+			ret = muBitMorphPass(src, &tmpMask, kw, kh, kw/2, kh/2, 0, tmp);
+			if(ret == MU_ERR_SUCCESS)
+				ret = muBitMorphPass(&tmpMask, &tmpMask, kw, kh, (kw-1)/2, (kh-1)/2, 1, tmp);
+			break;
+		case MU_MORPH_CLOSE:
+		case MU_MORPH_BLACKHAT:
+			ret = muBitMorphPass(src, &tmpMask, kw, kh, (kw-1)/2, (kh-1)/2, 1, tmp);
+			if(ret == MU_ERR_SUCCESS)
+				ret = muBitMorphPass(&tmpMask, &tmpMask, kw, kh, kw/2, kh/2, 0, tmp);
+			break;
+	}
+
+	if(ret == MU_ERR_SUCCESS && op >= MU_MORPH_TOPHAT)
+	{
+		for(i=0; i<n; i++)
+			dst->data[i] = op == MU_MORPH_TOPHAT ? src->data[i] & ~tmpMask.data[i] : tmpMask.data[i] & ~src->data[i];
+	}
+
+	free(tmp);
+
+	return ret;
+}
@@ -0,0 +1,801 @@
+/*
+% MIT License
+%
+% Copyright (c) 2016 OneCV
+%
+% Permission is hereby granted, free of charge, to any person obtaining a copy
+% of this software and associated documentation files (the "Software"), to deal
+% in the Software without restriction, including without limitation the rights
+% to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+% copies of the Software, and to permit persons to whom the Software is
+% furnished to do so, subject to the following conditions:
+%
+% The above copyright notice and this permission notice shall be included in all
+% copies or substantial portions of the Software.
+%
+% THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+% IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+% FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+% AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+% LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+% OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+% SOFTWARE.
+*/
+
+/* ------------------------------------------------------------------------- /
+ *
+ * Module: muRunLength.c
+ *
+ * Description:
+ *  This file is presented the run-length encoded mask: thresholding straight
+ *  to runs, logic operations, area, bounding box, dilation and connected
+ *  components computed on the runs.
+ *
+ -------------------------------------------------------------------------- */
+
+/* MU include files */
+#include "muCore.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define MU_RLE_AND 0
+#define MU_RLE_OR  1
+#define MU_RLE_SUB 2
+
+
+/* appends [start, end) to row y, merging with the last run when they overlap or touch */
+static muError_t muRLEPush(muRLEMask_t *m, MU_32S y, MU_32S start, MU_32S end)
+{
+	muRun_t *last, *runs;
+	MU_32S capacity;
+
+	if(m->count > 0)
+	{
+		last = m->runs + m->count - 1;
+		if(last->y == y && start <= last->end)
+		{
+			if(end > last->end)
+				last->end = end;
+			return MU_ERR_SUCCESS;
+		}
+	}
+
+	if(m->count == m->capacity)
+	{
+		capacity = m->capacity ? 2*m->capacity : 256;
+		runs = (muRun_t *)realloc(m->runs, capacity*sizeof(muRun_t));
+		if(runs == NULL)
+		{
+			return MU_ERR_OUT_OF_MEMORY;
+		}
+		m->runs = runs;
+		m->capacity = capacity;
+	}
+
+	m->runs[m->count].y = y;
+	m->runs[m->count].start = start;
+	m->runs[m->count].end = end;
+	m->count++;
+
+	return MU_ERR_SUCCESS;
+}
+
+#if defined(__SSE2__)
+/* index of the lowest set bit of t != 0 */
+static MU_32S muLowestBit(MU_32S t)
+{
+#if defined(__GNUC__)
+	return __builtin_ctz(t);
+#else
+	MU_32S b = 0;
+	while(!(t & 1))
+	{
+		t >>= 1;
+		b++;
+	}
+	return b;
+#endif
+}
+#endif
+
+/* empty mask of size in a caller's struct */
+static muError_t muRLEInit(muRLEMask_t *m, muSize_t size)
+{
+	m->size = size;
+	m->count = 0;
+	m->capacity = 0;
+	m->runs = NULL;
+	m->rowStart = (MU_32S *)calloc(size.height + 1, sizeof(MU_32S));
+
+	return m->rowStart ? MU_ERR_SUCCESS : MU_ERR_OUT_OF_MEMORY;
+}
+
+/* hands the runs of a built mask over to dst, or frees them on failure */
+static muError_t muRLEMove(muRLEMask_t *m, muRLEMask_t *dst, muError_t ret)
+{
+	if(ret == MU_ERR_SUCCESS)
+	{
+		free(dst->runs);
+		free(dst->rowStart);
+		*dst = *m;
+	}
+	else
+	{
+		free(m->runs);
+		free(m->rowStart);
+	}
+
+	return ret;
+}
+
+/*===========================================================================================*/
+/*   muRLECombine                                                                            */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   Row y of dst is op of row y+ya of a and row y+yb of b, rows outside a or b are empty.   */
+/*   Each row walks the run boundaries of both inputs in order, keeping whether it is        */
+/*   inside a and inside b, and opens or closes an output run where op of the two changes.   */
+/*   The cost follows the number of runs, not the width. dst keeps its size.                 */
+/*===========================================================================================*/
+static muError_t muRLECombine(const muRLEMask_t *a, MU_32S ya, const muRLEMask_t *b, MU_32S yb, MU_32S op, muRLEMask_t *dst)
+{
+	muRLEMask_t out;
+	MU_32S y, r, ia, ea, ib, eb, inA, inB, xa, xb, x, state, v, start = 0;
+	muError_t ret;
+
+	ret = muRLEInit(&out, dst->size);
+	if(ret)
+	{
+		return ret;
+	}
+
+	for(y=0; y<out.size.height && ret == MU_ERR_SUCCESS; y++)
+	{
+		out.rowStart[y] = out.count;
+
+		r = y + ya;
+		ia = r >= 0 && r < a->size.height ? a->rowStart[r] : 0;
+		ea = r >= 0 && r < a->size.height ? a->rowStart[r+1] : 0;
+		r = y + yb;
+		ib = r >= 0 && r < b->size.height ? b->rowStart[r] : 0;
+		eb = r >= 0 && r < b->size.height ? b->rowStart[r+1] : 0;
+
+		inA = inB = state = 0;
+		while((ia < ea || ib < eb) && ret == MU_ERR_SUCCESS)
+		{
+			xa = ia < ea ? (inA ? a->runs[ia].end : a->runs[ia].start) : 0x7FFFFFFF;
+			xb = ib < eb ? (inB ? b->runs[ib].end : b->runs[ib].start) : 0x7FFFFFFF;
+			x = xa < xb ? xa : xb;
+
+			if(xa == x)
+			{
+				ia += inA;
+				inA = !inA;
+			}
+			if(xb == x)
+			{
+				ib += inB;
+				inB = !inB;
+			}
+
+			v = op == MU_RLE_AND ? inA && inB : op == MU_RLE_OR ? inA || inB : inA != inB;
+			if(v && !state)
+				start = x;
+			else if(!v && state)
+				ret = muRLEPush(&out, y, start, x);
+			state = v;
+		}
+	}
+	out.rowStart[out.size.height] = out.count;
+
+	return muRLEMove(&out, dst, ret);
+}
+
+/*===========================================================================================*/
+/*   muCreateRLEMask                                                                         */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine allocates an empty run-length encoded mask. A mask is kept as the list of  */
+/*   its runs of set pixels, row by row and left to right, runs of a row never overlap or    */
+/*   touch. For mostly empty foreground masks every routine of this file costs in the        */
+/*   number of runs instead of the number of pixels.                                         */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muSize_t size --> mask size                                                             */
+/*===========================================================================================*/
+muRLEMask_t *muCreateRLEMask(muSize_t size)
+{
+	muRLEMask_t *mask;
+
+	if(size.width <= 0 || size.height <= 0)
+	{
+		return NULL;
+	}
+
+	mask = (muRLEMask_t *)malloc(sizeof(muRLEMask_t));
+	if(mask == NULL)
+	{
+		return NULL;
+	}
+
+	if(muRLEInit(mask, size))
+	{
+		free(mask);
+		return NULL;
+	}
+
+	return mask;
+}
+
+muError_t muReleaseRLEMask(muRLEMask_t **mask)
+{
+	if(mask == NULL || *mask == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	free((*mask)->runs);
+	free((*mask)->rowStart);
+	free(*mask);
+	*mask = NULL;
+
+	return MU_ERR_SUCCESS;
+}
+
+/*===========================================================================================*/
+/*   muRLEThreshold                                                                          */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine encodes the pixels th.min < v <= th.max straight to runs, the rule of      */
+/*   muThresholding, with v = src, or v = |src - ref| for a background subtraction. SSE2     */
+/*   tests 16 pixels at once and skips blocks lying wholly inside or outside a run, so a     */
+/*   mostly empty frame costs little more than reading it.                                   */
+/*                                                                                           */
+/*   NOTE                                                                                    */
+/*   A 0/255 mask is encoded with ref NULL and th = {0, 255}.                                */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muImage_t *src --> input image                                                          */
+/*   muImage_t *ref --> background image of the src size, or NULL                            */
+/*   muDoubleThreshold_t th --> th.min < v <= th.max is set                                  */
+/*   muRLEMask_t *dst --> output mask of the src size                                        */
+/*===========================================================================================*/
+muError_t muRLEThreshold(const muImage_t *src, const muImage_t *ref, muDoubleThreshold_t th, muRLEMask_t *dst)
+{
+	muRLEMask_t out;
+	const MU_8U *in, *bg;
+	MU_32S width, height, x, y, v, in_run, start = 0;
+	MU_32S min, max;
+	muError_t ret;
+
+	if(dst == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	ret = ref ? muCheckDepth(4, src, MU_IMG_DEPTH_8U, ref, MU_IMG_DEPTH_8U) : muCheckDepth(2, src, MU_IMG_DEPTH_8U);
+	if(ret)
+	{
+		return ret;
+	}
+
+	if(src->channels != 1 || (ref && ref->channels != 1))
+	{
+		return MU_ERR_NOT_SUPPORT;
+	}
+
+	width = src->width;
+	height = src->height;
+
+	if(dst->size.width != width || dst->size.height != height ||
+	   (ref && (ref->width != width || ref->height != height)))
+	{
+		return MU_ERR_INVALID_PARAMETER;
+	}
+
+	ret = muRLEInit(&out, dst->size);
+	if(ret)
+	{
+		return ret;
+	}
+
+	/* an empty range leaves the mask empty */
+	min = th.min < -1 ? -1 : th.min;
+	max = th.max > 255 ? 255 : th.max;
+	if(min >= 255 || max < 0 || max <= min)
+	{
+		return muRLEMove(&out, dst, ret);
+	}
+
+	for(y=0; y<height && ret == MU_ERR_SUCCESS; y++)
+	{
+		in = src->imagedata + y*width;
+		bg = ref ? ref->imagedata + y*width : NULL;
+		out.rowStart[y] = out.count;
+		in_run = 0;
+		x = 0;
+
+#if defined(__SSE2__)
+		{
+			const __m128i sign = _mm_set1_epi8((MU_8S)0x80);
+			const __m128i lo = _mm_set1_epi8((MU_8S)(min ^ 0x80));
+			const __m128i hi = _mm_set1_epi8((MU_8S)(max ^ 0x80));
+			__m128i p, q, m;
+			MU_32S bits, t, b;
+
+			for(; x+16<=width && ret == MU_ERR_SUCCESS; x+=16)
+			{
+				p = _mm_loadu_si128((const __m128i *)(in + x));
+				if(bg)
+				{
+					q = _mm_loadu_si128((const __m128i *)(bg + x));
+					p = _mm_or_si128(_mm_subs_epu8(p, q), _mm_subs_epu8(q, p));
+				}
+				p = _mm_xor_si128(p, sign);
+				m = min < 0 ? _mm_set1_epi8(-1) : _mm_cmpgt_epi8(p, lo);
+				if(max < 255)
+					m = _mm_andnot_si128(_mm_cmpgt_epi8(p, hi), m);
+				bits = _mm_movemask_epi8(m);
+
+				/* bit b of t is set where pixel x+b differs from the one before */
+				t = (bits ^ (bits << 1 | in_run)) & 0xFFFF;
+				while(t && ret == MU_ERR_SUCCESS)
+				{
+					b = muLowestBit(t);
+					t &= t - 1;
+					if(!in_run)
+						start = x + b;
+					else
+						ret = muRLEPush(&out, y, start, x + b);
+					in_run = !in_run;
+				}
+			}
+		}
+#endif
+		for(; x<width && ret == MU_ERR_SUCCESS; x++)
+		{
+			v = bg ? abs(in[x] - bg[x]) : in[x];
+			v = v > min && v <= max;
+			if(v && !in_run)
+				start = x;
+			else if(!v && in_run)
+				ret = muRLEPush(&out, y, start, x);
+			in_run = v;
+		}
+		if(in_run && ret == MU_ERR_SUCCESS)
+			ret = muRLEPush(&out, y, start, width);
+	}
+	out.rowStart[height] = out.count;
+
+	return muRLEMove(&out, dst, ret);
+}
+
+/*===========================================================================================*/
+/*   muDecodeRLEMask                                                                         */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine draws a run-length encoded mask to 8U, 255 on the runs and 0 elsewhere.    */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muRLEMask_t *src --> input mask                                                         */
+/*   muImage_t *dst --> output 8U mask of the src size                                       */
+/*===========================================================================================*/
+muError_t muDecodeRLEMask(const muRLEMask_t *src, muImage_t *dst)
+{
+	MU_32S i;
+	muError_t ret;
+
+	if(src == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	ret = muCheckDepth(2, dst, MU_IMG_DEPTH_8U);
+	if(ret)
+	{
+		return ret;
+	}
+
+	if(dst->channels != 1)
+	{
+		return MU_ERR_NOT_SUPPORT;
+	}
+
+	if(src->size.width != dst->width || src->size.height != dst->height)
+	{
+		return MU_ERR_INVALID_PARAMETER;
+	}
+
+	memset(dst->imagedata, 0, dst->width*dst->height);
+	for(i=0; i<src->count; i++)
+	{
+		memset(dst->imagedata + src->runs[i].y*dst->width + src->runs[i].start, 255, src->runs[i].end - src->runs[i].start);
+	}
+
+	return MU_ERR_SUCCESS;
+}
+
+static muError_t muRLELogic(const muRLEMask_t *src1, const muRLEMask_t *src2, muRLEMask_t *dst, MU_32S op)
+{
+	if(src1 == NULL || src2 == NULL || dst == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	if(src1->size.width != dst->size.width || src1->size.height != dst->size.height ||
+	   src2->size.width != dst->size.width || src2->size.height != dst->size.height)
+	{
+		return MU_ERR_INVALID_PARAMETER;
+	}
+
+	return muRLECombine(src1, 0, src2, 0, op, dst);
+}
+
+/*===========================================================================================*/
+/*   muRLEAnd, muRLEOr, muRLESub                                                             */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   These routines give the runs of muAnd, muOr and muSub on 0/255 masks: intersection,     */
+/*   union, and as muSub takes |src1 - src2|, the pixels set in exactly one of the masks.    */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muRLEMask_t *src1 --> input mask 1                                                      */
+/*   muRLEMask_t *src2 --> input mask 2                                                      */
+/*   muRLEMask_t *dst --> output mask, may be src1 or src2                                   */
+/*===========================================================================================*/
+muError_t muRLEAnd(const muRLEMask_t *src1, const muRLEMask_t *src2, muRLEMask_t *dst)
+{
+	return muRLELogic(src1, src2, dst, MU_RLE_AND);
+}
+
+muError_t muRLEOr(const muRLEMask_t *src1, const muRLEMask_t *src2, muRLEMask_t *dst)
+{
+	return muRLELogic(src1, src2, dst, MU_RLE_OR);
+}
+
+muError_t muRLESub(const muRLEMask_t *src1, const muRLEMask_t *src2, muRLEMask_t *dst)
+{
+	return muRLELogic(src1, src2, dst, MU_RLE_SUB);
+}
+
+/*===========================================================================================*/
+/*   muRLEArea                                                                               */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine sums the run lengths, the number of set pixels.                            */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muRLEMask_t *src --> input mask                                                         */
+/*   MU_32U *area --> number of set pixels                                                   */
+/*===========================================================================================*/
+muError_t muRLEArea(const muRLEMask_t *src, MU_32U *area)
+{
+	MU_32S i;
+	MU_32U sum = 0;
+
+	if(src == NULL || area == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	for(i=0; i<src->count; i++)
+	{
+		sum += src->runs[i].end - src->runs[i].start;
+	}
+	*area = sum;
+
+	return MU_ERR_SUCCESS;
+}
+
+/*===========================================================================================*/
+/*   muRLEBoundingRect                                                                       */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine gives the smallest rectangle holding every set pixel, the top and bottom   */
+/*   from the first and last runs, the sides from the run ends.                              */
+/*                                                                                           */
+/*   NOTE                                                                                    */
+/*   An empty mask gives a 0 x 0 rectangle at (0, 0).                                        */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muRLEMask_t *src --> input mask                                                         */
+/*   muRect_t *rect --> bounding rectangle                                                   */
+/*===========================================================================================*/
+muError_t muRLEBoundingRect(const muRLEMask_t *src, muRect_t *rect)
+{
+	MU_32S i, minx, maxx;
+
+	if(src == NULL || rect == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	if(src->count == 0)
+	{
+		*rect = muRect(0, 0, 0, 0);
+		return MU_ERR_SUCCESS;
+	}
+
+	minx = src->size.width;
+	maxx = 0;
+	for(i=0; i<src->count; i++)
+	{
+		if(src->runs[i].start < minx)
+			minx = src->runs[i].start;
+		if(src->runs[i].end > maxx)
+			maxx = src->runs[i].end;
+	}
+
+	*rect = muRect(minx, src->runs[0].y, maxx - minx, src->runs[src->count-1].y - src->runs[0].y + 1);
+
+	return MU_ERR_SUCCESS;
+}
+
+/*===========================================================================================*/
+/*   muRLEDilate                                                                             */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine dilates the mask with a ksize rectangle anchored as in muMorphology. Each  */
+/*   run first grows by ksize.width - 1 pixels and merges with its neighbours. The rows are  */
+/*   then shifted to the anchor and OR'ed with copies of themselves shifted down by 1, 2,    */
+/*   4, ... rows until the window is covered, log2(ksize.height) + 2 passes over the runs.   */
+/*                                                                                           */
+/*   NOTE                                                                                    */
+/*   dst may be src.                                                                         */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muRLEMask_t *src --> input mask                                                         */
+/*   muRLEMask_t *dst --> output mask                                                        */
+/*   muSize_t ksize --> width and height of the rectangle                                    */
+/*===========================================================================================*/
+muError_t muRLEDilate(const muRLEMask_t *src, muRLEMask_t *dst, muSize_t ksize)
+{
+	muRLEMask_t rows;
+	MU_32S i, m, ax, ay, start, end;
+	muError_t ret;
+
+	if(src == NULL || dst == NULL)
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	if(src->size.width != dst->size.width || src->size.height != dst->size.height || ksize.width < 1 || ksize.height < 1)
+	{
+		return MU_ERR_INVALID_PARAMETER;
+	}
+
+	ax = (ksize.width - 1)/2;
+	ay = (ksize.height - 1)/2;
+
+	/* rows i of the line padded for the window, row i is the src row i - ay */
+	ret = muRLEInit(&rows, muSize(src->size.width, src->size.height + ksize.height - 1));
+	if(ret)
+	{
+		return ret;
+	}
+
+	/* horizontal, pixel x reaches the outputs [x-(kw-1-ax), x+ax], growing runs merge in muRLEPush */
+	for(i=0; i<src->count && ret == MU_ERR_SUCCESS; i++)
+	{
+		start = src->runs[i].start - (ksize.width - 1 - ax);
+		end = src->runs[i].end + ax;
+		ret = muRLEPush(&rows, src->runs[i].y + ay, start < 0 ? 0 : start, end > src->size.width ? src->size.width : end);
+	}
+	for(i=0, m=0; i<=rows.size.height; i++)
+	{
+		while(m < rows.count && rows.runs[m].y < i)
+			m++;
+		rows.rowStart[i] = m;
+	}
+
+	/* row i covers the padded rows [i, i+m-1] */
+	for(m=1; 2*m<=ksize.height && ret == MU_ERR_SUCCESS; m*=2)
+	{
+		ret = muRLECombine(&rows, 0, &rows, m, MU_RLE_OR, &rows);
+	}
+
+	if(ret == MU_ERR_SUCCESS)
+	{
+		ret = muRLECombine(&rows, 0, &rows, ksize.height - m, MU_RLE_OR, dst);
+	}
+
+	free(rows.runs);
+	free(rows.rowStart);
+
+	return ret;
+}
+
+static MU_32S muRLEFind(MU_32S *parent, MU_32S i)
+{
+	while(parent[i] != i)
+	{
+		parent[i] = parent[parent[i]];
+		i = parent[i];
+	}
+
+	return i;
+}
+
+/*===========================================================================================*/
+/*   muRLELabel                                                                              */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine labels the connected components of the mask on its runs. Each row is       */
+/*   swept together with the row above and every pair of touching runs is united in a        */
+/*   union-find forest, the lower run index staying the root. Roots then take the labels     */
+/*   1, 2, ... in raster order of their first run and every run the label of its root.       */
+/*                                                                                           */
+/*   NOTE                                                                                    */
+/*   labels holds src->count entries, one per run.                                           */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muRLEMask_t *src --> input mask                                                         */
+/*   connectivity --> 4 or 8                                                                 */
+/*   MU_32S *labels --> label of every run                                                   */
+/*   MU_32S *num --> number of components                                                    */
+/*===========================================================================================*/
+muError_t muRLELabel(const muRLEMask_t *src, MU_32S connectivity, MU_32S *labels, MU_32S *num)
+{
+	const muRun_t *runs;
+	MU_32S *parent;
+	MU_32S y, i, j, ie, je, d, ri, rj, n;
+
+	if(src == NULL || num == NULL || (labels == NULL && src->count > 0))
+	{
+		return MU_ERR_NULL_POINTER;
+	}
+
+	if(connectivity != 4 && connectivity != 8)
+	{
+		return MU_ERR_INVALID_PARAMETER;
+	}
+
+	*num = 0;
+	if(src->count == 0)
+	{
+		return MU_ERR_SUCCESS;
+	}
+
+	parent = (MU_32S *)malloc(src->count*sizeof(MU_32S));
+	if(parent == NULL)
+	{
+		return MU_ERR_OUT_OF_MEMORY;
+	}
+
+	runs = src->runs;
+	for(i=0; i<src->count; i++)
+	{
+		parent[i] = i;
+	}
+
+	/* runs touch when they share a column, or a corner with 8-connectivity */
+	d = connectivity == 8 ? 1 : 0;
+	for(y=1; y<src->size.height; y++)
+	{
+		i = src->rowStart[y-1];
+		ie = src->rowStart[y];
+		j = src->rowStart[y];
+		je = src->rowStart[y+1];
+
+		while(i < ie && j < je)
+		{
+			if(runs[i].end + d <= runs[j].start)
+			{
+				i++;
+			}
+			else if(runs[j].end + d <= runs[i].start)
+			{
+				j++;
+			}
+			else
+			{
+				ri = muRLEFind(parent, i);
+				rj = muRLEFind(parent, j);
+				if(ri < rj)
+					parent[rj] = ri;
+				else if(rj < ri)
+					parent[ri] = rj;
+
+				if(runs[i].end <= runs[j].end)
+					i++;
+				else
+					j++;
+			}
+		}
+	}
+
+	/* roots come before the runs of their component */
+	n = 0;
+	for(i=0; i<src->count; i++)
+	{
+		ri = muRLEFind(parent, i);
+		labels[i] = ri == i ? ++n : labels[ri];
+	}
+	*num = n;
+
+	free(parent);
+
+	return MU_ERR_SUCCESS;
+}
+
+/*===========================================================================================*/
+/*   muRLEFindBoundingBox                                                                    */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine is muFindBoundingBox for the labels of muRLELabel, one pass over the runs  */
+/*   whatever the number of components.                                                      */
+/*                                                                                           */
+/*   NOTE                                                                                    */
+/*   NULL is returned when no component passes th.                                           */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muRLEMask_t *src --> input mask                                                         */
+/*   MU_32S *labels --> labels from muRLELabel                                               */
+/*   num --> number of components                                                            */
+/*   muDoubleThreshold_t th --> limitation object size, th.min <= area <= th.max             */
+/*===========================================================================================*/
+muSeq_t *muRLEFindBoundingBox(const muRLEMask_t *src, const MU_32S *labels, MU_32S num, muDoubleThreshold_t th)
+{
+	muBoundingBox_t *box, *b;
+	const muRun_t *r;
+	muSeq_t *sqhead = NULL;
+	MU_32S i;
+
+	if(src == NULL || labels == NULL || num <= 0)
+	{
+		return NULL;
+	}
+
+	box = (muBoundingBox_t *)malloc(num*sizeof(muBoundingBox_t));
+	if(box == NULL)
+	{
+		muDebugError(MU_ERR_OUT_OF_MEMORY);
+		return NULL;
+	}
+
+	for(i=0; i<num; i++)
+	{
+		box[i].minx = src->size.width;
+		box[i].miny = src->size.height;
+		box[i].maxx = 0;
+		box[i].maxy = 0;
+		box[i].area = 0;
+		box[i].overlap = 0;
+		box[i].label = i + 1;
+	}
+
+	for(i=0; i<src->count; i++)
+	{
+		r = src->runs + i;
+		b = box + labels[i] - 1;
+		if(r->start < b->minx)
+			b->minx = r->start;
+		if(r->end - 1 > b->maxx)
+			b->maxx = r->end - 1;
+		if(r->y < b->miny)
+			b->miny = r->y;
+		b->maxy = r->y;
+		b->area += r->end - r->start;
+	}
+
+	for(i=0; i<num; i++)
+	{
+		if(box[i].area >= th.min && box[i].area <= th.max)
+		{
+			box[i].width = box[i].maxx - box[i].minx + 1;
+			box[i].height = box[i].maxy - box[i].miny + 1;
+
+			if(sqhead == NULL)
+			{
+				sqhead = muCreateSeq(sizeof(muBoundingBox_t));
+			}
+			muPushSeq(sqhead, box + i);
+		}
+	}
+
+	free(box);
+
+	return sqhead;
+}
@@ -28,292 +28,248 @@
  * Author: Joe Lin
  *
  * Description:
- *    OtsuThresholding.
+ *    Global thresholding: fixed, Otsu, ISODATA and mean.
+ *    Adaptive thresholding: local mean, Gaussian and Sauvola.
  *
  -------------------------------------------------------------------------- */
  
 #include "muCore.h"
 
-typedef struct _Link{
-
-		struct _Link *add;
-		int data;
-}Link;
-
-typedef struct _GrayScale{
-		
-		Link *firstptr;
-		int count;
-}GrayScale;
-
-typedef struct _Otsuparameter{
-		
-		int WB;
-		int WO;
-		int MeanB;
-		int MeanO;
-}Otsuparameter;
-// has bug ... Joe 2017 06
-/* Test on 400MHZ SOC which cost 0.8s for D1 resolution */
-muError_t muOtsuThresholding(const muImage_t * src, muImage_t * dst)
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/* out = 255 where min < in <= max, else 0 */
+static void muBinarize(const MU_8U *in, MU_8U *out, MU_32S n, MU_32S min, MU_32S max)
 {
-	int idx = 0, jdx = 0;
-	int hidx = 0, widx = 0;
-	float BeVar = 0, TempVar = 0;
-	int FixedBeVar = 0, FixedTempVar = 0;
-	int Candidateflag = 0;// initially set the threshold = 0; 
-	short thidx = 0;
-	float tempdenominator = 0, tempdenominator2 = 0;
-	int outidx = 0, Idxnum = 0;
-	int ohidx = 0, owidx = 0;
-	int iheight;
-	int iwidth; 
-	int piwidth;
-	int totalsize;
-	int **InData;
-	int *In;
-	int *OutData;
-	int inidx = 0;
-	unsigned char *in, *out; 
-
-	GrayScale graynum[256] = {NULL, 0};
-
-	Link *temp[256] ={NULL, 0}, *current, *buffer;
-
-	Otsuparameter Thres[256] = {0, 0, 0, 0};
-	
-	muError_t ret;
+	MU_32S i = 0;
 
-	ret = muCheckDepth(4, src, MU_IMG_DEPTH_8U, dst, MU_IMG_DEPTH_8U);
-	if(ret)
+	if(min >= 255 || max < 0 || max <= min)
 	{
-		return ret;
+		memset(out, 0, n);
+		return;
 	}
+	min = min < -1 ? -1 : min;
+	max = max > 255 ? 255 : max;
 
-	if(src->channels != 1 || dst->channels != 1)
+#if defined(__SSE2__)
 	{
-		return MU_ERR_NOT_SUPPORT;
+		/* unsigned compares through the signed ones with the sign bit flipped */
+		const __m128i sign = _mm_set1_epi8((MU_8S)0x80);
+		const __m128i lo = _mm_set1_epi8((MU_8S)(min ^ 0x80));
+		const __m128i hi = _mm_set1_epi8((MU_8S)(max ^ 0x80));
+		const __m128i ones = _mm_set1_epi8(-1);
+		__m128i x, m;
+
+		for(; i+16<=n; i+=16)
+		{
+			x = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(in + i)), sign);
+			m = min < 0 ? ones : _mm_cmpgt_epi8(x, lo);
+			if(max < 255)
+				m = _mm_andnot_si128(_mm_cmpgt_epi8(x, hi), m);
+			_mm_storeu_si128((__m128i *)(out + i), m);
+		}
 	}
+#endif
 
-	iwidth = src->width;
-
-	iheight = src->height;
-
-	in = src->imagedata;
-
-	out = dst->imagedata;
-
-	//piwidth = Image1->widthStep;
-
-	totalsize = ( iheight * iwidth );
-
-	/***memory allcoate of the input data***/
-
-	InData = (int **) malloc( (iheight) * sizeof(void *) );
-
-	In = (int *) malloc((iheight) * (iwidth) * sizeof(int ) );
-
-	for( inidx = 0; inidx < (iheight); inidx++, In += (iwidth) )
-		InData[ inidx ] = In;
+	for(; i<n; i++)
+		out[i] = (in[i] > min && in[i] <= max) ? 255 : 0;
+}
 
-	/**************************************/
+/* Otsu: the t maximizing the between-class variance of {<= t} and {> t}, the smallest one on ties */
+static MU_32S muOtsuFromHist(const MU_32U *hist)
+{
+	MU_64F n = 0, sum = 0, wb = 0, sb = 0, wo, var, best = 0;
+	MU_32S t, th = 0;
 
-	/***memory allcoate of the input data***/
-	
-	OutData = (int *) calloc( iheight * iwidth, sizeof(int) );
-
-	/**************************************/
-
-		/*!
- ****************************************************************************************************************
- * \brief
- *    construt the Histogram parameter (Statistical number). 
- *    
- *    in: image data InData[height][width]          out: graynum[0].count: the total number of ro,
- *                                                      graynum[1].count: the total number of r1,
- *                                                                        .
- *                                                                        .
- *                                                                        .
- *                                                      graynum[255].ocunt: the total number of r255
- *                                                      and the graynum[num].firstptr is the first node 
- *                                                      which could use the link visitation to search each positin
- *                                                      of gray scale num.
- *****************************************************************************************************************
-*/
-	for( idx = 0; idx < (iheight); idx++)
+	for(t=0; t<256; t++)
 	{
-		for(jdx = 0; jdx < (iwidth); jdx++)
-			InData[ idx ][ jdx ] = (int) in[ idx * (iwidth) + jdx ];
+		n += hist[t];
+		sum += (MU_64F)t*hist[t];
 	}
 
-	for(hidx = 0; hidx < (iheight); hidx++)//record the data and location of each pixel in whole image
+	/* n^2 times the between-class variance is wb*wo*(mean_b - mean_o)^2 */
+	for(t=0; t<256; t++)
 	{
-		for(widx = 0; widx < (iwidth); widx++)
+		wb += hist[t];
+		sb += (MU_64F)t*hist[t];
+		wo = n - wb;
+		if(wb == 0 || wo == 0)
+			continue;
+
+		var = sb/wb - (sum - sb)/wo;
+		var = wb*wo*var*var;
+		if(var > best)
 		{
-			graynum[ InData[hidx][widx] ].count += 1;
-
-			current = ( Link * ) malloc( sizeof(Link) );
-
-			current->data = ( hidx * (iwidth) ) + widx;
-
-			if( graynum[ InData[hidx][widx] ].firstptr == NULL )
-				graynum[ InData[hidx][widx] ].firstptr = current;
-
-			else
-				temp[ InData[hidx][widx] ]->add = current;
-			
-			current->add = NULL;
-
-			temp[ InData[hidx][widx] ] = current;
-				
+			best = var;
+			th = t;
 		}
-		
 	}
 
-	free(InData[0]);
-
-	free(InData);
-
-	/*!
- ****************************************************************************************************************
- * \brief
- *    Find the threshold of the Otsu Algorithm.
- *    
- *    WB( T + 1) = WB( T ) + P( T + 1)    MeanB( T + 1 ) = [ MeanB( T ) WB( T ) + ( T + 1) P( T + 1) ] / WB( T + 1)
- *
- *    WO( T + 1) = WO( T ) + P( T + 1)    MeanO( T + 1 ) = [ MeanO( T ) WO( T ) + ( T + 1) P( T + 1) ] / WO( T + 1)
- *
- *    in: graynum[0].count                             out: Maximum between variance BeVar.
- *        graynum[1].count                                             
- *                .                                         The Cadidateflag = the chosen threshold.                
- *                .                                                        
- *                .                                                        
- *        graynum[255].count                                                                                           
- *****************************************************************************************************************
-*/
-	//set the initial value T = 0 of the otsu parameter.
-	
-	Thres[0].WB = graynum[0].count;
-
-	Thres[0].WO = totalsize - graynum[0].count;
-
-	Thres[0].MeanB = 0;
-
-	for( idx = 1; idx < 256; idx++)
-		Thres[0].MeanO +=( (graynum[idx].count) * idx );
+	return th;
+}
 
-	 /*** avoid the denominator being 0. ***/
+/* ISODATA: iterate t = (mean below t + mean from t up)/2 from 128, saturated pixels excluded */
+static MU_32S muIsodataFromHist(const MU_32U *hist)
+{
+	MU_64F c[257], s[257];
+	MU_32S i, th1 = 0, th2 = 128, iter;
 
-	if( Thres[0].WB == 0)
-		tempdenominator = 0.0000000001;
-	else
-		tempdenominator = (float)Thres[0].WB;
+	/* prefix counts and sums make each iteration O(1) */
+	c[0] = s[0] = 0;
+	for(i=0; i<256; i++)
+	{
+		c[i+1] = c[i] + (i < 255 ? hist[i] : 0);
+		s[i+1] = s[i] + (i < 255 ? (MU_64F)i*hist[i] : 0);
+	}
 
-	if( Thres[0].WO == 0)
-		tempdenominator2 = 0.0000000001;
-	else
-		tempdenominator2 = (float)Thres[0].WO;
+	/* the mean pair can cycle, 256 steps are more than any converging run needs */
+	for(iter=0; iter<256 && th1 != th2; iter++)
+	{
+		th1 = th2;
+		if(c[th1] != 0 && c[256] - c[th1] != 0)
+			th2 = (MU_32S)(((MU_32F)s[th1]/(MU_32F)c[th1] + (MU_32F)(s[256] - s[th1])/(MU_32F)(c[256] - c[th1]))/2);
+	}
 
-	/***************************************/
+	return th2;
+}
 
-	BeVar = ( ( (float)Thres[0].WO / tempdenominator ) * Thres[0].MeanB * Thres[0].MeanB )// calculate and set the maximum between variance. 
-	    
-	    - (2 * (float)Thres[0].MeanB * Thres[0].MeanO)
-	         
-		+  ( ( (float)Thres[0].WB / tempdenominator2 ) * Thres[0].MeanO * Thres[0].MeanO);
+/* mean of the non-zero pixels */
+static MU_32S muMeanFromHist(const MU_32U *hist)
+{
+	MU_64F n = 0, sum = 0;
+	MU_32S i;
 
-		for( thidx = 1; thidx < 256; thidx++)//perform in each threshold and find the correspoding threshold.
+	for(i=1; i<256; i++)
 	{
-		Thres[ thidx ].WB = Thres[ thidx -1 ].WB + graynum[ thidx ].count;
+		n += hist[i];
+		sum += (MU_64F)i*hist[i];
+	}
 
-		Thres[ thidx ].MeanB = Thres[ thidx-1 ].MeanB + ( thidx * graynum[ thidx ].count);
+	return n == 0 ? 0 : (MU_32S)(sum/n);
+}
 
-		Thres[ thidx ].WO = Thres[ thidx -1 ].WO - graynum[ thidx ].count;
+/*===========================================================================================*/
+/*   muHistThreshold                                                                         */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine selects a global threshold from a 256 bin histogram (see muHistogram)      */
+/*   in O(256): MU_THRESH_OTSU, MU_THRESH_ISODATA or MU_THRESH_MEAN. Foreground is the       */
+/*   pixels above the returned value.                                                        */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   MU_32U *hist --> histogram                                                              */
+/*   method --> threshold selector                                                           */
+/*   return --> threshold 0~255, -1 for an unknown method                                    */
+/*===========================================================================================*/
+MU_32S muHistThreshold(const MU_32U *hist, MU_32S method)
+{
+	if(hist == NULL)
+	{
+		return -1;
+	}
 
-		Thres[ thidx ].MeanO = Thres[ thidx-1 ].MeanO - ( thidx * graynum[ thidx ].count);
+	switch(method)
+	{
+		case MU_THRESH_OTSU:
+			return muOtsuFromHist(hist);
+		case MU_THRESH_ISODATA:
+			return muIsodataFromHist(hist);
+		case MU_THRESH_MEAN:
+			return muMeanFromHist(hist);
+	}
 
-		if( Thres[thidx].WB == 0)
-			tempdenominator = 0.0000000001;
+	return -1;
+}
 
-		else
-			tempdenominator = (float)Thres[thidx].WB;
+/*===========================================================================================*/
+/*   muAutoThresholding                                                                      */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine computes the histogram of src, selects a threshold with muHistThreshold    */
+/*   and binarizes: dst = 255 where src > threshold, else 0.                                 */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muImage_t *src --> input image                                                          */
+/*   muImage_t *dst --> output image, may be src                                             */
+/*   method --> MU_THRESH_OTSU, MU_THRESH_ISODATA or MU_THRESH_MEAN                          */
+/*   MU_32S *th --> the selected threshold, may be NULL                                      */
+/*===========================================================================================*/
+muError_t muAutoThresholding(const muImage_t *src, muImage_t *dst, MU_32S method, MU_32S *th)
+{
+	MU_32U hist[256];
+	MU_32S t;
+	muError_t ret;
 
-		if( Thres[thidx].WO == 0)
-			tempdenominator2 = 0.0000000001;
+	ret = muCheckDepth(4, src, MU_IMG_DEPTH_8U, dst, MU_IMG_DEPTH_8U);
+	if(ret)
+	{
+		return ret;
+	}
 
-		else
-			tempdenominator2 = (float)Thres[thidx].WO;
-
-		TempVar = ( ( (float)Thres[ thidx ].WO / tempdenominator ) * Thres[ thidx ].MeanB * Thres[ thidx ].MeanB ) 
-		    
-		    - (2 * (float)Thres[ thidx ].MeanB * Thres[ thidx ].MeanO)
-		         
-			+  ( ( (float)Thres[ thidx ].WB / tempdenominator2 ) * Thres[ thidx ].MeanO * Thres[ thidx ].MeanO);
-				
-		if( TempVar > BeVar)
-		{
-			BeVar = TempVar;
+	if(src->channels != 1 || dst->channels != 1)
+	{
+		return MU_ERR_NOT_SUPPORT;
+	}
 
-			Candidateflag = thidx;
-		}
-	}//end loop for
-
-		
-	/*!
- ****************************************************************************************************************
- * \brief
- *   Utilize the chosen threshold to get the binarization outputdata.
- *    
- *    in: Cadidateflag                out: binarition image.
- *                                                      
- *        graynum[0].firstptr                                                                
- *                 .                                                       
- *                 .                                                       
- *                 .                                     
- *        graynum[255].firstptr                                               
- *                                                      
- *                                                      
- *****************************************************************************************************************
-*/
+	if(src->width != dst->width || src->height != dst->height)
+	{
+		return MU_ERR_INVALID_PARAMETER;
+	}
 
-	while( outidx < 256)
+	muHistogram(src, hist);
+	t = muHistThreshold(hist, method);
+	if(t < 0)
 	{
-		while(graynum[ outidx ].firstptr != NULL)
-		{
-			buffer =  graynum[outidx].firstptr;
+		return MU_ERR_INVALID_PARAMETER;
+	}
 
-			Idxnum = graynum[ outidx ].firstptr->data;
+	muBinarize(src->imagedata, dst->imagedata, src->width*src->height, t, 255);
+	if(th)
+		*th = t;
 
-			ohidx = (int)(Idxnum / iwidth);
+	return MU_ERR_SUCCESS;
+}
 
-			owidx = (Idxnum % iwidth);
-		
-			if(outidx <= Candidateflag || (ohidx == 0) || (owidx == 0) || (ohidx == (iheight-1)) || (owidx == (iwidth-1)))
-				OutData[ohidx*iwidth+owidx ] = 0;
-			else
-				OutData[ohidx*iwidth+owidx ] = 255;
+/*===========================================================================================*/
+/*   muOtsuThresholding                                                                      */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine binarizes the input image by the Otsu threshold: dst = 255 where src is    */
+/*   above it, else 0.                                                                       */
+/*                                                                                           */
+/*   NOTE                                                                                    */
+/*   The one pixel border of dst is set to 0.                                                */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muImage_t *src --> input image                                                          */
+/*   muImage_t *dst --> output image                                                         */
+/*===========================================================================================*/
+muError_t muOtsuThresholding(const muImage_t * src, muImage_t * dst)
+{
+	MU_32S i, width, height;
+	muError_t ret;
 
-			out[ ohidx * iwidth + owidx ] = (unsigned char)OutData[ ohidx * iwidth + owidx ];
+	ret = muAutoThresholding(src, dst, MU_THRESH_OTSU, NULL);
+	if(ret)
+	{
+		return ret;
+	}
 
-			graynum[outidx].firstptr = graynum[outidx].firstptr->add;
+	width = dst->width;
+	height = dst->height;
 
-			free( buffer );//release each node.
-		}
-				
-		++outidx;
+	memset(dst->imagedata, 0, width);
+	memset(dst->imagedata + (height-1)*width, 0, width);
+	for(i=1; i<height-1; i++)
+	{
+		dst->imagedata[i*width] = 0;
+		dst->imagedata[i*width + width-1] = 0;
 	}
 
-	free(OutData);
-
 	return MU_ERR_SUCCESS;
-
-
 }
 
-
-
-
-
 /*===========================================================================================*/
 /*   muThreshold                                                                             */
 /*                                                                                           */
@@ -335,7 +291,6 @@ muError_t muOtsuThresholding(const muImage_t * src, muImage_t * dst)
 muError_t muThresholding(const muImage_t *src, muImage_t *dst,  muDoubleThreshold_t th)
 {
 	MU_8U *in, *out;
-	MU_32S i;
 	MU_32S width, height;
 	muError_t ret;
 
@@ -355,95 +310,47 @@ muError_t muThresholding(const muImage_t *src, muImage_t *dst,  muDoubleThreshol
 	in = src->imagedata;
 	out = dst->imagedata;
 
-	i = width*height;
-
-	do
-	{
-		if((*in > th.min) && (*in <= th.max))
-			*out = 255;
-		else
-			*out = 0;
-
-		in++;
-		out++;
-
-	}while(--i);
+	muBinarize(in, out, width*height, th.min, th.max);
 
 	return MU_ERR_SUCCESS;
 }
 
-/* find iso data from input image */
-static MU_8U findThresholdIsodata(const muImage_t *src)
-{
-	MU_8U th1 = 0,th2 = 128;
-	MU_32S i, width, height;
-	MU_32U th1_count = 0, th2_count = 0, th1_sum = 0, th2_sum = 0;
-	MU_16U	histogram[256] = {0};
-
-	width = src->width;
-	height = src->height;
-	
-	i = width*height;
-
-	do
-	{
-		histogram[src->imagedata[i]]++;	
-	}while(--i);
-	
-	histogram[255] = 0;
-
-	while( abs(th1-th2) >= 1)
-	{
-		th1_count = 0;
-		th2_count = 0;
-		th1_sum = 0;
-		th2_sum = 0;
-		for(i=0; i<256; i++)
-		{
-			if(i<th2)
-			{
-				th1_count += histogram[i];
-				th1_sum += histogram[i]*i;
-			}
-			else
-			{
-				th2_count += histogram[i];
-				th2_sum += histogram[i]*i;
-			}
-		}
-
-		th1 = th2;
-		if(th1_count != 0 && th2_count != 0)
-		{
-			th2 = ((th1_sum/(float)th1_count) + (th2_sum/(float)th2_count))/(float)2;
-		}
-
-	}
+/*===========================================================================================*/
+/*   muISOThreshold                                                                          */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   This routine binarizes the input image by the ISODATA threshold: dst = 255 where src    */
+/*   is above it, else 0.                                                                    */
+/*                                                                                           */
+/*   NOTE                                                                                    */
+/*   Saturated (255) pixels are left out of the threshold selection.                         */
+/*                                                                                           */
+/*   USAGE                                                                                   */
+/*   muImage_t *src --> input image                                                          */
+/*   muImage_t *dst --> output image                                                         */
+/*===========================================================================================*/
 
-	return th2;
+muError_t muISOThresholding(const muImage_t *src, muImage_t *dst)
+{
+	return muAutoThresholding(src, dst, MU_THRESH_ISODATA, NULL);
 }
 
 /*===========================================================================================*/
-/*   muISOThreshold                                                                         */
+/*   muMeanThreshold                                                                        */
 /*                                                                                           */
 /*   DESCRIPTION:                                                                            */
-/*   This routine performs a thresholding on an input data, and the thresholded pixels are   */
-/*   overwritten to the input buffer.                                                        */
-/*   if src data is between with threshold1 and threshold2, then src data = 255, else        */
-/*   src data = 0.                                                                           */      
+/*   This routine finds the mean of total pixels and add the offset to do the thresholding   */      
 /*                                                                                           */
-/*   NOTE                                                                                    */
-/*   This routine would be modified the original data.                                       */
 /*                                                                                           */
 /*   USAGE                                                                                   */
 /*   muImage_t *src --> input image                                                           */
-/*   MU_8U th1 --> threshold1                                                                */
-/*   MU_8U th2 --> threshold2                                                                */
+/*   muImage_t *dst --> output image                                                          */
+/*   MU_8U offset --> offset                                                                 */
 /*===========================================================================================*/
-
-muError_t muISOThresholding(const muImage_t *src, muImage_t *dst)
+muError_t muMeanThresholding(const muImage_t *src, muImage_t *dst, MU_8U offset)
 {
 	muDoubleThreshold_t th;
+	MU_32U hist[256];
 	muError_t ret;
 
 	ret = muCheckDepth(4, src, MU_IMG_DEPTH_8U, dst, MU_IMG_DEPTH_8U);
@@ -457,62 +364,268 @@ muError_t muISOThresholding(const muImage_t *src, muImage_t *dst)
 		return MU_ERR_NOT_SUPPORT;
 	}
 
-	if(src == NULL)
+	if(muHistogram(src, hist))
 	{
-			return MU_ERR_NOT_SUPPORT; 
+		return MU_ERR_NOT_SUPPORT;
 	}
 
 	th.max = 255;
+
+	th.min = muHistThreshold(hist, MU_THRESH_MEAN);
 	
-	th.min = findThresholdIsodata(src);
+	th.min += offset;
 
 	if(muThresholding(src, dst, th))
 	{
 		return MU_ERR_NOT_SUPPORT;
 	}
-
+	
 	return MU_ERR_SUCCESS;
+
 }
 
-static MU_8U findThresholdMean(const muImage_t *src)
+/*===========================================================================================*/
+/*   Adaptive thresholding                                                                   */
+/*                                                                                           */
+/*   DESCRIPTION:                                                                            */
+/*   The local mean (and for Sauvola the local deviation) of every pixel comes from an       */
+/*   integral image with one zero row and column in front: a window sum is 4 lookups         */
+/*   whatever the block size. The sums are kept in 32 bits, their differences stay right     */
+/*   modulo 2^32; the squares are kept in 64 bit floats, which hold them exactly. Windows    */
+/*   are clipped at the image border and the mean is taken over the pixels inside.           */
+/*   Rows are built and thresholded in parallel, 4 pixels (2 for Sauvola) per SSE2 step.     */
+/*===========================================================================================*/
+
+#define MU_ADAPTIVE_STRIP 256
+#define MU_SAUVOLA_R      128.0
+
+/* integral images of width+1 x height+1, sq may be NULL */
+static void muAdaptiveIntegral(const muImage_t *src, MU_32U *sum, MU_64F *sq)
 {
-	MU_32S i;
-	MU_32S w, h;
-	MU_32S sum, count;
-	MU_8U *buf;
-	
-	sum = 0;
-	count = 0;
-	w = src->width;
-	h = src->height;
-	buf = src->imagedata;
-	for(i=0; i<w*h; i++)
-	{
-		sum += buf[i];
-		if(buf[i] > 0)
+	MU_32S width, height, w1, y, s;
+
+	width = src->width;
+	height = src->height;
+	w1 = width + 1;
+
+	memset(sum, 0, w1*sizeof(MU_32U));
+	if(sq)
+		memset(sq, 0, w1*sizeof(MU_64F));
+
+	/* prefix sums of every row */
+#pragma omp parallel for
+	for(y=0; y<height; y++)
+	{
+		const MU_8U *in = src->imagedata + y*width;
+		MU_32U *out = sum + (y+1)*w1, t = 0;
+		MU_64F *out2, t2 = 0;
+		MU_32S x;
+
+		out[0] = 0;
+		for(x=0; x<width; x++)
+		{
+			t += in[x];
+			out[x+1] = t;
+		}
+
+		if(sq)
+		{
+			out2 = sq + (y+1)*w1;
+			out2[0] = 0;
+			for(x=0; x<width; x++)
+			{
+				t2 += in[x]*in[x];
+				out2[x+1] = t2;
+			}
+		}
+	}
+
+	/* then down the columns, strip by strip */
+#pragma omp parallel for
+	for(s=0; s<(w1 + MU_ADAPTIVE_STRIP - 1)/MU_ADAPTIVE_STRIP; s++)
+	{
+		MU_32S x0, x1, x, yy;
+		MU_32U *p;
+		MU_64F *p2;
+
+		x0 = s*MU_ADAPTIVE_STRIP;
+		x1 = x0 + MU_ADAPTIVE_STRIP < w1 ? x0 + MU_ADAPTIVE_STRIP : w1;
+
+		for(yy=2; yy<=height; yy++)
+		{
+			p = sum + yy*w1;
+			x = x0;
+#if defined(__SSE2__)
+			for(; x+4<=x1; x+=4)
+				_mm_storeu_si128((__m128i *)(p + x), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(p + x)), _mm_loadu_si128((const __m128i *)(p - w1 + x))));
+#endif
+			for(; x<x1; x++)
+				p[x] += p[x - w1];
+
+			if(sq)
+			{
+				p2 = sq + yy*w1;
+				x = x0;
+#if defined(__SSE2__)
+				for(; x+2<=x1; x+=2)
+					_mm_storeu_pd(p2 + x, _mm_add_pd(_mm_loadu_pd(p2 + x), _mm_loadu_pd(p2 - w1 + x)));
+#endif
+				for(; x<x1; x++)
+					p2[x] += p2[x - w1];
+			}
+		}
+	}
+}
+
+/* 255 where in > mean - c, mean of the window rows [y0, y1) of the integral rows a = y0, b = y1 */
+static void muAdaptiveMeanRow(const MU_8U *in, MU_8U *out, const MU_32U *a, const MU_32U *b, MU_32S width, MU_32S r, MU_32S rows, MU_32F c)
+{
+	MU_32S x = 0, x0, x1;
+	MU_32F m;
+
+	for(; x<width; x++)
+	{
+#if defined(__SSE2__)
+		if(x >= r && x+4+r <= width)
+		{
+			/* whole windows: the area is constant and the four corners are contiguous loads */
+			const __m128i z = _mm_setzero_si128();
+			const __m128 area = _mm_set1_ps((MU_32F)(rows*(2*r + 1)));
+			const __m128 cv = _mm_set1_ps(c);
+			__m128i s, v, msk;
+			__m128 f;
+			MU_32S p4;
+
+			for(; x+4+r<=width; x+=4)
+			{
+				s = _mm_sub_epi32(_mm_sub_epi32(_mm_loadu_si128((const __m128i *)(b + x + r + 1)), _mm_loadu_si128((const __m128i *)(b + x - r))),
+								  _mm_sub_epi32(_mm_loadu_si128((const __m128i *)(a + x + r + 1)), _mm_loadu_si128((const __m128i *)(a - r + x))));
+				/* unsigned 32 bit to float */
+				f = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(s, 1)), _mm_set1_ps(2.0F)), _mm_cvtepi32_ps(_mm_and_si128(s, _mm_set1_epi32(1))));
+				f = _mm_sub_ps(_mm_div_ps(f, area), cv);
+
+				/* 4 pixels at any offset, through memcpy to stay aligned and alias safe */
+				memcpy(&p4, in + x, 4);
+				v = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(p4), z), z);
+				msk = _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(v), f));
+				msk = _mm_packs_epi32(msk, msk);
+				p4 = _mm_cvtsi128_si32(_mm_packs_epi16(msk, msk));
+				memcpy(out + x, &p4, 4);
+			}
+			if(x >= width)
+				break;
+		}
+#endif
+		x0 = x - r > 0 ? x - r : 0;
+		x1 = x + r + 1 < width ? x + r + 1 : width;
+		m = (MU_32F)(MU_32U)(b[x1] - b[x0] - a[x1] + a[x0]) / (MU_32F)(rows*(x1 - x0));
+		out[x] = (MU_32F)in[x] > m - c ? 255 : 0;
+	}
+}
+
+/* 255 where in > m*(1 + k*(s/R - 1)), m and s the mean and deviation of the window */
+static void muAdaptiveSauvolaRow(const MU_8U *in, MU_8U *out, const MU_32U *a, const MU_32U *b, const MU_64F *a2, const MU_64F *b2,
+								 MU_32S width, MU_32S r, MU_32S rows, MU_64F k)
+{
+	MU_32S x = 0, x0, x1, n;
+	MU_64F m, v;
+
+	for(; x<width; x++)
+	{
+#if defined(__SSE2__)
+		if(x >= r && x+2+r <= width)
 		{
-			count++;
+			const __m128d area = _mm_set1_pd((MU_64F)(rows*(2*r + 1)));
+			const __m128d kv = _mm_set1_pd(k);
+			const __m128d kr = _mm_set1_pd(k/MU_SAUVOLA_R);
+			__m128i s;
+			__m128d sd, qd, md, vd, t;
+
+			for(; x+2+r<=width; x+=2)
+			{
+				s = _mm_sub_epi32(_mm_sub_epi32(_mm_loadl_epi64((const __m128i *)(b + x + r + 1)), _mm_loadl_epi64((const __m128i *)(b + x - r))),
+								  _mm_sub_epi32(_mm_loadl_epi64((const __m128i *)(a + x + r + 1)), _mm_loadl_epi64((const __m128i *)(a - r + x))));
+				/* unsigned 32 bit to double, as the scalar MU_32U cast */
+				sd = _mm_add_pd(_mm_mul_pd(_mm_cvtepi32_pd(_mm_srli_epi32(s, 1)), _mm_set1_pd(2.0)), _mm_cvtepi32_pd(_mm_and_si128(s, _mm_set1_epi32(1))));
+				qd = _mm_sub_pd(_mm_sub_pd(_mm_loadu_pd(b2 + x + r + 1), _mm_loadu_pd(b2 + x - r)),
+								_mm_sub_pd(_mm_loadu_pd(a2 + x + r + 1), _mm_loadu_pd(a2 + x - r)));
+				md = _mm_div_pd(sd, area);
+				vd = _mm_max_pd(_mm_div_pd(_mm_sub_pd(qd, _mm_mul_pd(sd, md)), area), _mm_setzero_pd());
+
+				/* m*(1 + k*(s/R - 1)) = m*(1 - k + s*k/R) */
+				t = _mm_mul_pd(md, _mm_add_pd(_mm_sub_pd(_mm_set1_pd(1.0), kv), _mm_mul_pd(_mm_sqrt_pd(vd), kr)));
+				out[x] = (MU_64F)in[x] > _mm_cvtsd_f64(t) ? 255 : 0;
+				out[x+1] = (MU_64F)in[x+1] > _mm_cvtsd_f64(_mm_unpackhi_pd(t, t)) ? 255 : 0;
+			}
+			if(x >= width)
+				break;
 		}
+#endif
+		x0 = x - r > 0 ? x - r : 0;
+		x1 = x + r + 1 < width ? x + r + 1 : width;
+		n = rows*(x1 - x0);
+		m = (MU_64F)(MU_32U)(b[x1] - b[x0] - a[x1] + a[x0]);
+		v = (b2[x1] - b2[x0]) - (a2[x1] - a2[x0]);
+		m /= n;
+		v = (v - m*m*n)/n;
+		v = v > 0 ? v : 0;
+		out[x] = (MU_64F)in[x] > m*(1 - k + sqrt(v)*(k/MU_SAUVOLA_R)) ? 255 : 0;
+	}
+}
+
+/* 255 where in > g - c */
+static void muAdaptiveGaussRow(const MU_8U *in, MU_8U *out, const MU_32F *g, MU_32S width, MU_32F c)
+{
+	MU_32S x = 0;
+
+#if defined(__SSE2__)
+	const __m128i z = _mm_setzero_si128();
+	const __m128 cv = _mm_set1_ps(c);
+	__m128i v, m0, m1;
+
+	for(; x+8<=width; x+=8)
+	{
+		v = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(in + x)), z);
+		m0 = _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(v, z)), _mm_sub_ps(_mm_loadu_ps(g + x), cv)));
+		m1 = _mm_castps_si128(_mm_cmpgt_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(v, z)), _mm_sub_ps(_mm_loadu_ps(g + x + 4), cv)));
+		m0 = _mm_packs_epi32(m0, m1);
+		_mm_storel_epi64((__m128i *)(out + x), _mm_packs_epi16(m0, m0));
 	}
+#endif
 
-	return (MU_8U)(sum/(float)count);
+	for(; x<width; x++)
+		out[x] = (MU_32F)in[x] > g[x] - c ? 255 : 0;
 }
 
 /*===========================================================================================*/
-/*   muMeanThreshold                                                                        */
+/*   muAdaptiveThreshold                                                                     */
 /*                                                                                           */
 /*   DESCRIPTION:                                                                            */
-/*   This routine finds the mean of total pixels and add the offset to do the thresholding   */      
+/*   This routine binarizes the input image against a threshold T(x,y) computed over the     */
+/*   blockSize x blockSize neighbourhood of every pixel: dst = 255 where src > T, else 0.    */
+/*   MU_ADAPTIVE_MEAN     --> T = local mean - param                                         */
+/*   MU_ADAPTIVE_GAUSSIAN --> T = Gaussian weighted local mean - param, sigma as for a       */
+/*                            blockSize kernel: 0.3*((blockSize-1)/2 - 1) + 0.8              */
+/*   MU_ADAPTIVE_SAUVOLA  --> T = m*(1 + param*(s/128 - 1)), m and s the local mean and      */
+/*                            standard deviation, param (k) about 0.2~0.5                    */
 /*                                                                                           */
+/*   NOTE                                                                                    */
+/*   The cost does not depend on blockSize: mean and Sauvola use integral images, Gaussian   */
+/*   the recursive muGaussianIIR.                                                            */
 /*                                                                                           */
 /*   USAGE                                                                                   */
-/*   muImage_t *src --> input image                                                           */
-/*   muImage_t *dst --> output image                                                          */
-/*   MU_8U offset --> offset                                                                 */
+/*   muImage_t *src --> input image                                                          */
+/*   muImage_t *dst --> output image                                                         */
+/*   method --> MU_ADAPTIVE_MEAN, MU_ADAPTIVE_GAUSSIAN or MU_ADAPTIVE_SAUVOLA                */
+/*   blockSize --> odd window size >= 3                                                      */
+/*   param --> offset C (mean, Gaussian) or k (Sauvola)                                      */
 /*===========================================================================================*/
-muError_t muMeanThresholding(const muImage_t *src, muImage_t *dst, MU_8U offset)
+muError_t muAdaptiveThreshold(const muImage_t *src, muImage_t *dst, MU_32S method, MU_32S blockSize, MU_64F param)
 {
-	muDoubleThreshold_t th;
+	MU_32S width, height, w1, r, y;
+	MU_32U *sum = NULL;
+	MU_64F *sq = NULL;
+	muImage_t *gauss;
 	muError_t ret;
 
 	ret = muCheckDepth(4, src, MU_IMG_DEPTH_8U, dst, MU_IMG_DEPTH_8U);
@@ -526,27 +639,69 @@ muError_t muMeanThresholding(const muImage_t *src, muImage_t *dst, MU_8U offset)
 		return MU_ERR_NOT_SUPPORT;
 	}
 
-	if(src == NULL)
+	if(src->width != dst->width || src->height != dst->height || blockSize < 3 || !(blockSize & 1) ||
+	   (method != MU_ADAPTIVE_MEAN && method != MU_ADAPTIVE_GAUSSIAN && method != MU_ADAPTIVE_SAUVOLA))
 	{
-		return MU_ERR_NOT_SUPPORT; 
+		return MU_ERR_INVALID_PARAMETER;
 	}
 
-	th.max = 255;
+	width = src->width;
+	height = src->height;
+	w1 = width + 1;
+	r = blockSize/2;
 
-	th.min = findThresholdMean(src);
-	
-	th.min += offset;
+	if(method == MU_ADAPTIVE_GAUSSIAN)
+	{
+		gauss = muCreateImage(muGetSize(src), MU_IMG_DEPTH_32F, 1);
+		if(gauss == NULL)
+		{
+			return MU_ERR_OUT_OF_MEMORY;
+		}
 
-	if(muThresholding(src, dst, th))
+		ret = muGaussianIIR(src, gauss, 0.3*((blockSize - 1)*0.5 - 1) + 0.8);
+		if(ret == MU_ERR_SUCCESS)
+		{
+#pragma omp parallel for
+			for(y=0; y<height; y++)
+				muAdaptiveGaussRow(src->imagedata + y*width, dst->imagedata + y*width, (MU_32F *)gauss->imagedata + y*width, width, (MU_32F)param);
+		}
+
+		muReleaseImage(&gauss);
+		return ret;
+	}
+
+	sum = (MU_32U *)malloc(w1*(height + 1)*sizeof(MU_32U));
+	if(method == MU_ADAPTIVE_SAUVOLA)
+		sq = (MU_64F *)malloc(w1*(height + 1)*sizeof(MU_64F));
+	if(sum == NULL || (method == MU_ADAPTIVE_SAUVOLA && sq == NULL))
 	{
-		return MU_ERR_NOT_SUPPORT;
+		if(sum)
+			free(sum);
+		if(sq)
+			free(sq);
+		return MU_ERR_OUT_OF_MEMORY;
 	}
-	
-	return MU_ERR_SUCCESS;
 
-}
+	muAdaptiveIntegral(src, sum, sq);
 
+#pragma omp parallel for
+	for(y=0; y<height; y++)
+	{
+		MU_32S y0, y1;
 
+		y0 = y - r > 0 ? y - r : 0;
+		y1 = y + r + 1 < height ? y + r + 1 : height;
 
+		if(sq)
+			muAdaptiveSauvolaRow(src->imagedata + y*width, dst->imagedata + y*width, sum + y0*w1, sum + y1*w1, sq + y0*w1, sq + y1*w1,
+								 width, r, y1 - y0, param);
+		else
+			muAdaptiveMeanRow(src->imagedata + y*width, dst->imagedata + y*width, sum + y0*w1, sum + y1*w1, width, r, y1 - y0, (MU_32F)param);
+	}
 
+	free(sum);
+	if(sq)
+		free(sq);
 
+	return MU_ERR_SUCCESS;
+}
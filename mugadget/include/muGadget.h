@@ -259,7 +259,37 @@ MU_API(MU_VOID) muObjectDetection_SuperLight(muIntegralImg_t *Itlmg, muRect_t Sc
 MU_API(MU_VOID) muMergeRectangles(muSeq_t *Rectangles, int MergeObjDistTH, int HitNum);
 
 /*Boost Learning function*/
+enum
+{
+	MU_LEARNING_MEAN = 0,	/* threshold blended from pos/neg means */
+	MU_LEARNING_SORTED,		/* optimal threshold/polar from a sorted sweep */
+};
+
 MU_API(MU_VOID) muObjectLearning_Init(muImage_t *img, muRect_t *box, muImage_t *ultraNeg);
+MU_API(MU_VOID) muObjectLearning_InitEx(muImage_t *img, muRect_t *box, muImage_t *ultraNeg, MU_32S mode);
+
+/*Random haar feature inside box, shared by the learners*/
+MU_API(MU_VOID) muRandomFeatureGen(MuRandHaarFeature *RandomFeature, muRect_t *box);
+
+/*Offline cascade training, writes the muLoadSimpleDetector text format*/
+typedef struct MuCascadeTrainParams
+{
+    muSize_t winSize;       /* size of the positives and the detector window, at least 9x9 */
+    MU_32S maxStages;
+    MU_32S maxWeakCount;    /* per stage, 0 for no limit */
+    MU_32S numFeatures;     /* random haar feature pool */
+    MU_32S negPerStage;     /* negative windows mined for each stage */
+    MU_64F minHitRate;      /* per stage, e.g. 0.995 */
+    MU_64F maxFalseAlarm;   /* per stage, e.g. 0.5 */
+    MU_32U seed;            /* feature pool seed */
+} MuCascadeTrainParams;
+
+MU_API(muError_t) muTrainCascade(muImage_t **pos, MU_32S posNum, muImage_t **neg, MU_32S negNum,
+                                 const MuCascadeTrainParams *params, const char *filename);
+
+/*Online refinement of the learned detector from new frames, box must have the learned window size*/
+MU_API(muError_t) muObjectLearning_Update(muImage_t *img, muRect_t *box, MuSimpleDetector *Detector);
+MU_API(MU_VOID) muObjectLearning_Release();
 
 /**Examinator Function Headers**/
 MU_API(MU_VOID) Examinator_Init_Buf(MU_8U *buf, MuExaminator *Examinator);
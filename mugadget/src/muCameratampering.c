@@ -55,7 +55,6 @@ MU_32S muDetectCamTampering( const muImage_t* src, MU_32S flags, MU_32S sensitiv
 	// histogram contain only 32(256/8) fields
 	int Empty, Peak;
 	int HistogramData[9][32]={0};
-	int GrayLevelColor;
 
 	// represent the situation of each field
 	int BlkSituation[9]={0};
@@ -67,12 +66,20 @@ MU_32S muDetectCamTampering( const muImage_t* src, MU_32S flags, MU_32S sensitiv
 
 	// image
 	muImage_t *pSmallImg;  
-	muImage_t *pSubSrcImg;
-	muImage_t *pSubGradImg;
+	muSize_t smallSize;
+	muBlockHist_t *pBlkHist;
 	muRect_t ROI;
 
-    sub_block_w=src->width/3;
-    sub_block_h=src->height/3;
+	// size of the down scaled image, split into 3x3 blocks
+	if( src->width >= 640 )
+		smallSize = src->height >= 480 ? muSize(src->width/4, src->height/4) : muSize(src->width/4, src->height/2);
+	else if( src->width >= 320 )
+		smallSize = muSize(src->width/2, src->height/2);
+	else
+		smallSize = muGetSize(src);
+
+    sub_block_w=smallSize.width/3;
+    sub_block_h=smallSize.height/3;
     
     
 	// set initial parameter
@@ -147,18 +154,18 @@ MU_32S muDetectCamTampering( const muImage_t* src, MU_32S flags, MU_32S sensitiv
 	{
 		if(src->height >= 480) // D1/ 4CIF/ VGA
 		{
-			pSmallImg = muCreateImage( muSize(src->width/4, src->height/4), MU_IMG_DEPTH_8U, 1 );
+			pSmallImg = muCreateImage( smallSize, MU_IMG_DEPTH_8U, 1 );
 			muDownScale(src, pSmallImg, 4, 4);
 		}
 		else // 2CIF
 		{
-			pSmallImg = muCreateImage( muSize(src->width/4, src->height/2), MU_IMG_DEPTH_8U, 1 );
+			pSmallImg = muCreateImage( smallSize, MU_IMG_DEPTH_8U, 1 );
 			muDownScale(src, pSmallImg, 2, 4);
 		}
 	}
 	else if( src->width >= 320 ) // CIF/ QVGA
 	{
-		pSmallImg = muCreateImage( muSize(src->width/2, src->height/2), MU_IMG_DEPTH_8U, 1 );
+		pSmallImg = muCreateImage( smallSize, MU_IMG_DEPTH_8U, 1 );
 		muDownScale(src, pSmallImg, 2, 2);
 	}
 	else // QCIF
@@ -168,8 +175,6 @@ MU_32S muDetectCamTampering( const muImage_t* src, MU_32S flags, MU_32S sensitiv
 
 	// create image
 	pGradImg = muCreateImage( muGetSize(pSmallImg), MU_IMG_DEPTH_8U, 1 );
-	pSubSrcImg  = muCreateImage( muSize(sub_block_w, sub_block_h), MU_IMG_DEPTH_8U, 1 );
-	pSubGradImg = muCreateImage( muSize(sub_block_w, sub_block_h), MU_IMG_DEPTH_8U, 1 );
 
 	// calculate gradient magnitude (Laplace filter)
 	if( flags & MU_CAM_LOSTFOCUS )
@@ -181,43 +186,37 @@ MU_32S muDetectCamTampering( const muImage_t* src, MU_32S flags, MU_32S sensitiv
 
 
 	// image saparate into 9 parts, each size 40*30
-	for( i=0; i<3; i++)
+	ROI = muRect(0, 0, 3*sub_block_w, 3*sub_block_h);
+
+	// count high gradient number: bin 1 of 2 holds the 255 pixels
+	if( flags & MU_CAM_LOSTFOCUS )
 	{
-		for( j=0; j<3; j++)
+		pBlkHist = muCreateBlockHist(ROI, muSize(sub_block_w, sub_block_h), 2, MU_IMG_DEPTH_32U);
+		if( pBlkHist )
 		{
-			ROI=muRect(i*sub_block_w, j*sub_block_h, sub_block_w, sub_block_h);
-
-			muGetSubImage(pSmallImg, pSubSrcImg, ROI);
-			muGetSubImage(pGradImg, pSubGradImg, ROI);
+			muCalcBlockHist(pGradImg, NULL, pBlkHist);
+			for( k=0; k<9; k++)
+				HiGradCount[k] = ((MU_32U *)pBlkHist->data)[k*2+1];
+			muReleaseBlockHist(&pBlkHist);
+		}
+	}
 
-			for( k=0;k<sub_block_h;k++)
-			{
-				for( l=0;l<sub_block_w;l++)
-				{
-					if( flags & MU_CAM_LOSTFOCUS )
-					{ 
-						// count high gradient number
-						if( (muGet2D(pSubGradImg, k, l) == 255) )
-							HiGradCount[j*3+i]++;
-					}
-
-
-
-					// count graylevel histogram
-					if( flags & MU_CAM_OCCLUSION )
-					{
-						GrayLevelColor=(int)(muGet2D(pSubSrcImg, k, l)>>3);
-						HistogramData[j*3+i][GrayLevelColor]++;
-					}
-				}
-			}
+	// count graylevel histogram, 32 bins
+	if( flags & MU_CAM_OCCLUSION )
+	{
+		pBlkHist = muCreateBlockHist(ROI, muSize(sub_block_w, sub_block_h), 32, MU_IMG_DEPTH_32U);
+		if( pBlkHist )
+		{
+			muCalcBlockHist(pSmallImg, NULL, pBlkHist);
+			for( k=0; k<9; k++)
+				for( l=0; l<32; l++)
+					HistogramData[k][l] = ((MU_32U *)pBlkHist->data)[k*32+l];
+			muReleaseBlockHist(&pBlkHist);
 		}
 	}
 
 	// release image
 	muReleaseImage( &pGradImg );
-	muReleaseImage( &pSubSrcImg );
-	muReleaseImage( &pSubGradImg );
 
 	if(src != pSmallImg)
 	{
@@ -227,10 +226,14 @@ MU_32S muDetectCamTampering( const muImage_t* src, MU_32S flags, MU_32S sensitiv
 
 	if( flags & MU_CAM_LOSTFOCUS )
 	{
+		// a block out of focus keeps few strong edges
 		for(i=0; i<9; i++)
 		{
-			BlkSituation[i] += MU_CAM_LOSTFOCUS;
-			LFocBlkNum++;
+			if( HiGradCount[i] < HiGradNumTH )
+			{
+				BlkSituation[i] += MU_CAM_LOSTFOCUS;
+				LFocBlkNum++;
+			}
 		}
 
 	}
@@ -0,0 +1,712 @@
+/*
+% MIT License
+%
+% Copyright (c) 2016 OneCV
+%
+% Permission is hereby granted, free of charge, to any person obtaining a copy
+% of this software and associated documentation files (the "Software"), to deal
+% in the Software without restriction, including without limitation the rights
+% to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+% copies of the Software, and to permit persons to whom the Software is
+% furnished to do so, subject to the following conditions:
+%
+% The above copyright notice and this permission notice shall be included in all
+% copies or substantial portions of the Software.
+%
+% THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+% IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+% FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+% AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+% LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+% OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+% SOFTWARE.
+*/
+
+/* ------------------------------------------------------------------------- /
+ *
+ * Module: muCascadeTraining.c
+ * Author: OneCV
+ *
+ * Description:
+ * This file is presented offline multi-stage haar-cascade training. The
+ * result is written in the text format read by muLoadSimpleDetector.
+ *  
+ -------------------------------------------------------------------------- */
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#include "muGadget.h"
+
+#define TRAIN_STD_TH 5          //muObjectDetection rejects windows below this std
+#define TRAIN_MAX_WEAK 1000     //upper bound of weak classifiers per stage
+#define TRAIN_SCALE_STEP 1.25   //pyramid step of the negative images
+#define TRAIN_SCAN_STEP 2       //window step on each negative level
+#define TRAIN_MINE_BLOCK 4096   //windows checked per parallel mining block
+
+//Integral image of one training image
+typedef struct _muTrainImage
+{
+    muSize_t size;
+    int *sum;
+    double *sqsum;
+} muTrainImage_t;
+
+//A training window, sum points to its top-left in the integral image
+typedef struct _muTrainSample
+{
+    const int *sum;
+    int stride;
+    double inv_std;
+} muTrainSample_t;
+
+//Haar feature with the weights muSetImagesForHaarClassifierCascade sets at scale 1
+typedef struct _muTrainFeature
+{
+    int rect_num;
+    muRect_t r[3];
+    float ori_weight[3];
+    float weight[3];
+} muTrainFeature_t;
+
+//Stump: v >= threshold gives right, else left
+typedef struct _muTrainWeak
+{
+    int feature;
+    float threshold;
+    float left;
+    float right;
+} muTrainWeak_t;
+
+typedef struct _muTrainStage
+{
+    int count;
+    float threshold;
+    muTrainWeak_t weak[TRAIN_MAX_WEAK];
+} muTrainStage_t;
+
+typedef struct _muTrainPair
+{
+    float value;
+    int index;
+} muTrainPair_t;
+
+#define TRAIN_RECT_SUM(s, st, r) \
+    ((s)[(r).y*(st)+(r).x] - (s)[(r).y*(st)+(r).x+(r).width] - \
+     (s)[((r).y+(r).height)*(st)+(r).x] + (s)[((r).y+(r).height)*(st)+(r).x+(r).width])
+
+//Same arithmetic as ctRunHaarClassifierCascade, divided by the window std
+MU_INLINE float muTrainFeatureValue(const muTrainFeature_t *f, const muTrainSample_t *s)
+{
+    double v;
+
+    v = TRAIN_RECT_SUM(s->sum, s->stride, f->r[0]) * f->weight[0];
+    v += TRAIN_RECT_SUM(s->sum, s->stride, f->r[1]) * f->weight[1];
+    if(f->rect_num == 3)
+        v += TRAIN_RECT_SUM(s->sum, s->stride, f->r[2]) * f->weight[2];
+
+    return (float)(v*s->inv_std);
+}
+
+//Window (x,y) of img, returns 0 when the detector would skip it as flat
+static int muTrainSetSample(muTrainSample_t *s, const muTrainImage_t *img, int x, int y, muSize_t win)
+{
+    int st = img->size.width+1;
+    int offset = y*st + x;
+    muRect_t equRect;
+    double inv_area, mean, variance;
+
+    equRect.x = equRect.y = 1;
+    equRect.width = win.width-2;
+    equRect.height = win.height-2;
+    inv_area = 1./(equRect.width*equRect.height);
+
+    mean = TRAIN_RECT_SUM(img->sum+offset, st, equRect)*inv_area;
+    variance = TRAIN_RECT_SUM(img->sqsum+offset, st, equRect)*inv_area - mean*mean;
+    variance = (variance >= 0.) ? sqrt(variance) : 1.;
+    if(variance < TRAIN_STD_TH)
+        return 0;
+
+    s->sum = img->sum + offset;
+    s->stride = st;
+    s->inv_std = 1./variance;
+
+    return 1;
+}
+
+static int muTrainRunCascade(const muTrainStage_t *stages, int stageNum, const muTrainFeature_t *features,
+                             const muTrainSample_t *s)
+{
+    int i, j;
+
+    for(i=0; i<stageNum; i++)
+    {
+        double stage_sum = 0;
+
+        for(j=0; j<stages[i].count; j++)
+        {
+            const muTrainWeak_t *weak = &stages[i].weak[j];
+            stage_sum += muTrainFeatureValue(&features[weak->feature], s) >= weak->threshold ? weak->right : weak->left;
+        }
+        if(stage_sum < stages[i].threshold)
+            return 0;
+    }
+
+    return 1;
+}
+
+static int muTrainCompare(const void *a, const void *b)
+{
+    float fa = ((const muTrainPair_t *)a)->value, fb = ((const muTrainPair_t *)b)->value;
+    return (fa > fb) - (fa < fb);
+}
+
+static int muTrainCompareDesc(const void *a, const void *b)
+{
+    double da = *(const double *)a, db = *(const double *)b;
+    return (da < db) - (da > db);
+}
+
+//Weighted error of the best stump of one feature, one sweep over its sorted
+//samples (positives are the first posNum samples)
+static double muTrainBestStump(const float *vals, const int *order, int total, int posNum, const double *w,
+                               double wPos, double wNeg, float *threshold, int *polar)
+{
+    double sp = 0, sn = 0, err, best = 2;
+    int k;
+
+    for(k=0; k<=total; k++)
+    {
+        if(k == 0 || k == total || vals[order[k]] != vals[order[k-1]])
+        {
+            float th;
+
+            if(k == 0)
+                th = vals[order[0]] - 1.f - (float)fabs(vals[order[0]]);
+            else if(k == total)
+                th = vals[order[total-1]] + 1.f + (float)fabs(vals[order[total-1]]);
+            else
+            {
+                th = (vals[order[k-1]] + vals[order[k]])*0.5f;
+                if(th <= vals[order[k-1]])
+                    th = vals[order[k]];
+            }
+
+            //polar 1: v >= th is positive, -1: v < th is positive
+            err = sp + (wNeg - sn);
+            if(err < best)
+            {
+                best = err;
+                *threshold = th;
+                *polar = 1;
+            }
+            err = sn + (wPos - sp);
+            if(err < best)
+            {
+                best = err;
+                *threshold = th;
+                *polar = -1;
+            }
+        }
+
+        if(k < total)
+        {
+            if(order[k] < posNum)
+                sp += w[order[k]];
+            else
+                sn += w[order[k]];
+        }
+    }
+
+    return best;
+}
+
+//Windows of the negative pyramid, visited in a strided permutation so that
+//every stage samples the whole set instead of the first images in scan order
+typedef struct _muTrainNegSource
+{
+    muTrainImage_t *levels;
+    int levelNum;
+    double *start;      //first window index of each level
+    double total;
+    double cursor;
+    double stride;
+} muTrainNegSource_t;
+
+static void muTrainNegWindow(const muTrainNegSource_t *src, muSize_t win, double k, int *level, int *x, int *y)
+{
+    int l = 0, cols;
+    double local;
+
+    while(l+1 < src->levelNum && src->start[l+1] <= k)
+        l++;
+    local = k - src->start[l];
+    cols = (src->levels[l].size.width - win.width)/TRAIN_SCAN_STEP + 1;
+    *level = l;
+    *y = (int)(local/cols)*TRAIN_SCAN_STEP;
+    *x = (int)fmod(local, cols)*TRAIN_SCAN_STEP;
+}
+
+//Collect up to maxNum negative windows that pass the current cascade,
+//returns the number found after at most one full pass over the source
+static int muTrainMineNegatives(muTrainNegSource_t *src, muSize_t win, const muTrainStage_t *stages, int stageNum,
+                                const muTrainFeature_t *features, muTrainSample_t *samples, int maxNum, double *visited)
+{
+    int num = 0, i;
+    unsigned char pass[TRAIN_MINE_BLOCK];
+    muTrainSample_t block[TRAIN_MINE_BLOCK];
+
+    *visited = 0;
+    while(num < maxNum && *visited < src->total)
+    {
+        int blockNum = TRAIN_MINE_BLOCK;
+
+        if(src->total - *visited < blockNum)
+            blockNum = (int)(src->total - *visited);
+
+        #pragma omp parallel for schedule(dynamic, 64)
+        for(i=0; i<blockNum; i++)
+        {
+            int level, x, y;
+            double k = fmod((src->cursor + i)*src->stride, src->total);
+
+            muTrainNegWindow(src, win, k, &level, &x, &y);
+            pass[i] = muTrainSetSample(&block[i], &src->levels[level], x, y, win) &&
+                      muTrainRunCascade(stages, stageNum, features, &block[i]);
+        }
+
+        for(i=0; i<blockNum && num<maxNum; i++)
+            if(pass[i])
+                samples[num++] = block[i];
+
+        src->cursor = fmod(src->cursor + i, src->total);
+        *visited += i;
+    }
+
+    return num;
+}
+
+static double muTrainGcd(double a, double b)
+{
+    while(b > 0)
+    {
+        double r = fmod(a, b);
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+static void muTrainIntegral(muTrainImage_t *dst, const muImage_t *img)
+{
+    dst->size.width = img->width;
+    dst->size.height = img->height;
+    dst->sum = (int *)malloc(sizeof(int)*(img->width+1)*(img->height+1));
+    dst->sqsum = (double *)malloc(sizeof(double)*(img->width+1)*(img->height+1));
+    if(dst->sum != NULL && dst->sqsum != NULL)
+        muCalcIntegralImage(img->imagedata, dst->sum, dst->sqsum, dst->size);
+}
+
+static void muTrainWriteCascade(FILE *fp, muSize_t win, const muTrainStage_t *stages, int stageNum,
+                                const muTrainFeature_t *features)
+{
+    int i, j, k;
+
+    fprintf(fp, "%d %d\n", win.width, win.height);
+    fprintf(fp, "%d\n", stageNum);
+    for(i=0; i<stageNum; i++)
+    {
+        fprintf(fp, "%d\n", stages[i].count);
+        for(j=0; j<stages[i].count; j++)
+        {
+            const muTrainWeak_t *weak = &stages[i].weak[j];
+            const muTrainFeature_t *f = &features[weak->feature];
+
+            fprintf(fp, "%d\n", 1);
+            fprintf(fp, "%d\n", f->rect_num);
+            for(k=0; k<f->rect_num; k++)
+                fprintf(fp, "%d %d %d %d %f\n", f->r[k].x, f->r[k].y, f->r[k].width, f->r[k].height, f->ori_weight[k]);
+            fprintf(fp, "%d\n", 0);
+            fprintf(fp, "%.9g\n", weak->threshold);
+            fprintf(fp, "%.9g\n", weak->left);
+            fprintf(fp, "%.9g\n", weak->right);
+        }
+        fprintf(fp, "%.9g\n", stages[i].threshold);
+        fprintf(fp, "-1\n");
+        fprintf(fp, "-1\n");
+    }
+}
+
+/*
+ * Train a boosted haar cascade from gray 8U positives (exactly winSize) and
+ * negative images (any size, scanned over a 1.25 pyramid). Integral images are
+ * computed once; every stage keeps the positives the cascade still accepts,
+ * mines negPerStage false alarms, then adds AdaBoost stumps until the stage
+ * reaches minHitRate at no more than maxFalseAlarm.
+ */
+muError_t muTrainCascade(muImage_t **pos, MU_32S posNum, muImage_t **neg, MU_32S negNum,
+                         const MuCascadeTrainParams *params, const char *filename)
+{
+    int i, j, s, t, posKeep, negFound, total, stageNum = 0, noMem;
+    muSize_t win;
+    double inv_area, visited;
+    muTrainImage_t *posImg = NULL;
+    muTrainNegSource_t src;
+    muTrainFeature_t *features = NULL;
+    muTrainStage_t *stages = NULL;
+    muTrainSample_t *samples = NULL;
+    float *vals = NULL;
+    int *order = NULL;
+    double *w = NULL, *score = NULL, *posScore = NULL;
+    muError_t ret = MU_ERR_SUCCESS;
+    FILE *fp;
+
+    if(pos == NULL || neg == NULL || params == NULL || filename == NULL)
+        return MU_ERR_NULL_POINTER;
+    win = params->winSize;
+    //muRandomFeatureGen places 8 pixel wide (high) haar features at rand()%(size-8), so 8x8 is too small
+    if(posNum <= 0 || negNum <= 0 || win.width < 9 || win.height < 9 || params->numFeatures <= 0 ||
+       params->negPerStage <= 0 || params->maxStages <= 0)
+        return MU_ERR_INVALID_PARAMETER;
+    for(i=0; i<posNum; i++)
+        if(pos[i]->channels != 1 || (pos[i]->depth & 0xF) != MU_IMG_DEPTH_8U ||
+           pos[i]->width != win.width || pos[i]->height != win.height)
+            return MU_ERR_INVALID_PARAMETER;
+    for(i=0; i<negNum; i++)
+        if(neg[i]->channels != 1 || (neg[i]->depth & 0xF) != MU_IMG_DEPTH_8U)
+            return MU_ERR_INVALID_PARAMETER;
+
+    memset(&src, 0, sizeof(src));
+
+    //Feature pool with the detector's scale-1 weights
+    features = (muTrainFeature_t *)malloc(params->numFeatures*sizeof(muTrainFeature_t));
+    stages = (muTrainStage_t *)malloc(params->maxStages*sizeof(muTrainStage_t));
+    if(features == NULL || stages == NULL)
+    {
+        ret = MU_ERR_OUT_OF_MEMORY;
+        goto exit;
+    }
+    srand(params->seed);
+    inv_area = 1./((win.width-2)*(win.height-2));
+    for(i=0; i<params->numFeatures; i++)
+    {
+        MuRandHaarFeature rf;
+        muRect_t box;
+        double sum0 = 0;
+
+        box.x = box.y = 0;
+        box.width = win.width;
+        box.height = win.height;
+        muRandomFeatureGen(&rf, &box);
+        features[i].rect_num = rf.rect_num;
+        for(j=0; j<rf.rect_num; j++)
+        {
+            features[i].r[j].x = rf.rect[j].x;
+            features[i].r[j].y = rf.rect[j].y;
+            features[i].r[j].width = rf.rect[j].width;
+            features[i].r[j].height = rf.rect[j].height;
+            features[i].ori_weight[j] = rf.rect[j].weight;
+            features[i].weight[j] = (float)(rf.rect[j].weight*inv_area);
+            if(j > 0)
+                sum0 += features[i].weight[j] * rf.rect[j].width * rf.rect[j].height;
+        }
+        features[i].weight[0] = (float)(-sum0/(rf.rect[0].width*rf.rect[0].height));
+    }
+
+    //Integral images, once: positives and the negative pyramids
+    posImg = (muTrainImage_t *)calloc(posNum, sizeof(muTrainImage_t));
+    src.levels = (muTrainImage_t *)calloc(negNum*32, sizeof(muTrainImage_t));
+    src.start = (double *)calloc(negNum*32, sizeof(double));
+    if(posImg == NULL || src.levels == NULL || src.start == NULL)
+    {
+        ret = MU_ERR_OUT_OF_MEMORY;
+        goto exit;
+    }
+
+    #pragma omp parallel for schedule(dynamic)
+    for(i=0; i<posNum; i++)
+        muTrainIntegral(&posImg[i], pos[i]);
+
+    for(i=0; i<negNum; i++)
+    {
+        double scale = 1;
+        muSize_t size;
+
+        size.width = neg[i]->width;
+        size.height = neg[i]->height;
+        while(size.width >= win.width && size.height >= win.height && src.levelNum < negNum*32)
+        {
+            muTrainImage_t *level = &src.levels[src.levelNum];
+
+            if(scale == 1)
+                muTrainIntegral(level, neg[i]);
+            else
+            {
+                muImage_t *scaled = muCreateImage(size, MU_IMG_DEPTH_8U, 1);
+
+                muResize(neg[i], scaled, MU_INTER_NN);
+                muTrainIntegral(level, scaled);
+                muReleaseImage(&scaled);
+            }
+            src.start[src.levelNum] = src.total;
+            src.total += (double)((size.width-win.width)/TRAIN_SCAN_STEP + 1) *
+                         ((size.height-win.height)/TRAIN_SCAN_STEP + 1);
+            src.levelNum++;
+
+            scale *= TRAIN_SCALE_STEP;
+            size.width = (int)(neg[i]->width/scale);
+            size.height = (int)(neg[i]->height/scale);
+        }
+    }
+    for(i=0; i<posNum; i++)
+        if(posImg[i].sum == NULL || posImg[i].sqsum == NULL)
+            ret = MU_ERR_OUT_OF_MEMORY;
+    for(i=0; i<src.levelNum; i++)
+        if(src.levels[i].sum == NULL || src.levels[i].sqsum == NULL)
+            ret = MU_ERR_OUT_OF_MEMORY;
+    if(ret != MU_ERR_SUCCESS || src.total <= 0)
+    {
+        if(ret == MU_ERR_SUCCESS)
+            ret = MU_ERR_INVALID_PARAMETER;
+        goto exit;
+    }
+
+    //Stride coprime with the window count spreads each stage over all windows
+    src.stride = floor(fmod(2654435761., src.total));
+    if(src.stride < 1)
+        src.stride = 1;
+    while(muTrainGcd(src.total, src.stride) != 1)
+        src.stride += 1;
+
+    samples = (muTrainSample_t *)malloc((posNum+params->negPerStage)*sizeof(muTrainSample_t));
+    w = (double *)malloc((posNum+params->negPerStage)*sizeof(double));
+    score = (double *)malloc((posNum+params->negPerStage)*sizeof(double));
+    posScore = (double *)malloc(posNum*sizeof(double));
+    vals = (float *)malloc((size_t)params->numFeatures*(posNum+params->negPerStage)*sizeof(float));
+    order = (int *)malloc((size_t)params->numFeatures*(posNum+params->negPerStage)*sizeof(int));
+    if(samples == NULL || w == NULL || score == NULL || posScore == NULL || vals == NULL || order == NULL)
+    {
+        ret = MU_ERR_OUT_OF_MEMORY;
+        goto exit;
+    }
+
+    for(s=0; s<params->maxStages; s++)
+    {
+        muTrainStage_t *stage = &stages[s];
+        double hit = 1, fa = 1;
+
+        //Positives still accepted by the cascade
+        posKeep = 0;
+        for(i=0; i<posNum; i++)
+        {
+            muTrainSample_t sample;
+
+            if(muTrainSetSample(&sample, &posImg[i], 0, 0, win) &&
+               muTrainRunCascade(stages, stageNum, features, &sample))
+                samples[posKeep++] = sample;
+        }
+
+        //False alarms of the cascade
+        negFound = muTrainMineNegatives(&src, win, stages, stageNum, features, samples+posKeep,
+                                        params->negPerStage, &visited);
+        MU_DBG("stage %d: pos %d, neg %d (acceptance %g)\n", s, posKeep, negFound,
+               visited > 0 ? negFound/visited : 0.);
+        if(posKeep == 0 || negFound == 0)
+            break;
+        total = posKeep + negFound;
+
+        //Feature-major responses and their sorted order, fixed during the stage
+        noMem = 0;
+        #pragma omp parallel
+        {
+            muTrainPair_t *pairs = (muTrainPair_t *)malloc(total*sizeof(muTrainPair_t));
+            int f, k;
+
+            //a thread without pairs would leave its order rows unset
+            if(pairs == NULL)
+            {
+                #pragma omp critical
+                noMem = 1;
+            }
+
+            #pragma omp for schedule(dynamic, 16)
+            for(f=0; f<params->numFeatures; f++)
+            {
+                float *row = vals + (size_t)f*total;
+                int *ord = order + (size_t)f*total;
+
+                if(pairs == NULL)
+                    continue;
+                for(k=0; k<total; k++)
+                {
+                    row[k] = muTrainFeatureValue(&features[f], &samples[k]);
+                    pairs[k].value = row[k];
+                    pairs[k].index = k;
+                }
+                qsort(pairs, total, sizeof(muTrainPair_t), muTrainCompare);
+                for(k=0; k<total; k++)
+                    ord[k] = pairs[k].index;
+            }
+            free(pairs);
+        }
+        if(noMem)
+        {
+            ret = MU_ERR_OUT_OF_MEMORY;
+            goto exit;
+        }
+
+        for(i=0; i<total; i++)
+        {
+            w[i] = (i < posKeep) ? 0.5/posKeep : 0.5/negFound;
+            score[i] = 0;
+        }
+
+        //AdaBoost stumps until the stage meets its hit/false alarm targets
+        stage->count = 0;
+        for(t=0; t<TRAIN_MAX_WEAK && (params->maxWeakCount <= 0 || t < params->maxWeakCount); t++)
+        {
+            double wPos = 0, wNeg = 0, err, beta, alpha, sum, bestErr = 2;
+            int best = -1, bestPolar = 1, keep;
+            float bestTh = 0;
+            muTrainWeak_t *weak;
+            const float *row;
+
+            for(i=0; i<total; i++)
+            {
+                if(i < posKeep)
+                    wPos += w[i];
+                else
+                    wNeg += w[i];
+            }
+            sum = wPos + wNeg;
+            for(i=0; i<total; i++)
+                w[i] /= sum;
+            wPos /= sum;
+            wNeg /= sum;
+
+            #pragma omp parallel
+            {
+                double localErr = 2;
+                float localTh = 0;
+                int localBest = -1, localPolar = 1, f;
+
+                #pragma omp for schedule(static)
+                for(f=0; f<params->numFeatures; f++)
+                {
+                    float th;
+                    int polar;
+                    double e = muTrainBestStump(vals + (size_t)f*total, order + (size_t)f*total, total, posKeep,
+                                                w, wPos, wNeg, &th, &polar);
+                    if(e < localErr)
+                    {
+                        localErr = e;
+                        localTh = th;
+                        localPolar = polar;
+                        localBest = f;
+                    }
+                }
+
+                #pragma omp critical
+                {
+                    if(localBest >= 0 && (localErr < bestErr || (localErr == bestErr && localBest < best)))
+                    {
+                        bestErr = localErr;
+                        bestTh = localTh;
+                        bestPolar = localPolar;
+                        best = localBest;
+                    }
+                }
+            }
+
+            if(best < 0 || bestErr >= 0.5)
+                break;
+            err = (bestErr > 1e-10) ? bestErr : 1e-10;
+            beta = err/(1-err);
+            alpha = log(1/beta);
+
+            weak = &stage->weak[stage->count++];
+            weak->feature = best;
+            weak->threshold = bestTh;
+            weak->left = (bestPolar == 1) ? 0.f : (float)alpha;
+            weak->right = (bestPolar == 1) ? (float)alpha : 0.f;
+
+            row = vals + (size_t)best*total;
+            for(i=0; i<total; i++)
+            {
+                int positive = (bestPolar == 1) ? (row[i] >= bestTh) : (row[i] < bestTh);
+
+                score[i] += (row[i] >= bestTh) ? weak->right : weak->left;
+                if(positive == (i < posKeep))
+                    w[i] *= beta;
+            }
+
+            //Stage threshold keeping minHitRate of the positives
+            for(i=0; i<posKeep; i++)
+                posScore[i] = score[i];
+            qsort(posScore, posKeep, sizeof(double), muTrainCompareDesc);
+            keep = (int)ceil(params->minHitRate*posKeep);
+            if(keep < 1)
+                keep = 1;
+            if(keep > posKeep)
+                keep = posKeep;
+            stage->threshold = (float)(posScore[keep-1] - 1e-4);
+
+            hit = fa = 0;
+            for(i=0; i<total; i++)
+            {
+                if(score[i] < stage->threshold)
+                    continue;
+                if(i < posKeep)
+                    hit += 1;
+                else
+                    fa += 1;
+            }
+            hit /= posKeep;
+            fa /= negFound;
+
+            if(fa <= params->maxFalseAlarm)
+                break;
+        }
+
+        if(stage->count == 0)
+            break;
+        stageNum++;
+        MU_DBG("stage %d: %d weak, hit %g, false alarm %g\n", s, stage->count, hit, fa);
+    }
+
+    fp = fopen(filename, "w");
+    if(fp == NULL)
+    {
+        ret = MU_ERR_INVALID_PARAMETER;
+        goto exit;
+    }
+    muTrainWriteCascade(fp, win, stages, stageNum, features);
+    fclose(fp);
+
+exit:
+    if(posImg != NULL)
+        for(i=0; i<posNum; i++)
+        {
+            free(posImg[i].sum);
+            free(posImg[i].sqsum);
+        }
+    if(src.levels != NULL)
+        for(i=0; i<src.levelNum; i++)
+        {
+            free(src.levels[i].sum);
+            free(src.levels[i].sqsum);
+        }
+    free(posImg);
+    free(src.levels);
+    free(src.start);
+    free(features);
+    free(stages);
+    free(samples);
+    free(w);
+    free(score);
+    free(posScore);
+    free(vals);
+    free(order);
+
+    return ret;
+}
@@ -32,19 +32,46 @@
  *  
  -------------------------------------------------------------------------- */
 
+#include <time.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 #include "muGadget.h"
 
 #define FLOAT_MAX 3.4e38f
 #define FLOAT_MIN 1.2e-38f
 #define MAX_NEG 200
+#define MAX_POS 50
+#define MAX_SELECTED 50
 
-muSeq_t *selectedIndex = NULL; //Selected feature Index
-muSeq_t *poolIndex = NULL; //Remained Feature pool Index
-
-double HaarValueNegMean[features_num];
-double HaarValuePosMean[features_num];
-double HaarValuePos[50][features_num];
-double HaarValueNeg[MAX_NEG][features_num];
+//A scan window of the learning image
+typedef struct _muLearningSample
+{
+    int offset;     //offset of the window in the integral image
+    double norm;    //inv_window_area / std of the window
+    float score;    //mining score, higher is a harder negative
+} muLearningSample_t;
+
+int SelectedIndex[MAX_SELECTED]; //Selected feature Index
+int SelectedNum = 0;
+unsigned char PoolUsed[features_num]; //Feature already taken from the pool
+
+//Feature-major haar values: HaarValuePos[feature][sample]
+float HaarValueNegMean[features_num];
+float HaarValuePosMean[features_num];
+float HaarValuePos[features_num][MAX_POS];
+float HaarValueNeg[features_num][MAX_NEG];
+
+//Online update state: model of the last learning, candidate features
+//re-scored next to the selected ones, and pos/neg sample rings
+#define MAX_CANDIDATE 64
+#define MAX_ONLINE_NEG 32
+static MuLearningModel *LearnedModel = NULL;
+static int CandidateIndex[MAX_CANDIDATE];
+static int CandidateNum = 0;
+static int LearnedPosNum = 0, LearnedNegNum = 0;
+static int PosNext = 0, NegNext = 0;
+static int LearnedMode = MU_LEARNING_MEAN, LearnedAlpha = 5; //threshold rule of the learning
 
 void muRandomFeatureGen(MuRandHaarFeature *RandomFeature, muRect_t *box)
 {
@@ -304,32 +331,398 @@ void setLearningImage(MuLearningModel *LearningModel, int *sum, double *sqsum, m
     }
 }
 
+//Normalization of a window's haar sums: inv_window_area / std of the window
+static double muLearningWindowNorm(MuLearningModel *LearningModel, int p_offset)
+{
+    double mean, variance_norm_factor;
+
+    mean = calc_sum(*LearningModel,p_offset)*LearningModel->inv_window_area;
+    variance_norm_factor = LearningModel->pq0[p_offset] - LearningModel->pq1[p_offset] -
+                           LearningModel->pq2[p_offset] + LearningModel->pq3[p_offset];
+    variance_norm_factor = variance_norm_factor*LearningModel->inv_window_area - mean*mean; //Mean(Square sum) - mean(sum) square
+
+    if( variance_norm_factor > 0. )
+        variance_norm_factor = sqrt(variance_norm_factor);
+    else
+        variance_norm_factor = 1.;
+
+    return LearningModel->inv_window_area/variance_norm_factor;
+}
+
+//Weighted rectangle sum of one weak classifier's feature
+MU_INLINE double muLearningHaarSum(const MuLearningHaarClassifier *weak, int p_offset)
+{
+    const MuHaarFeature *feature = &weak->feature;
+    double HaarValue;
+
+    HaarValue = calc_sum(feature->rect[0],p_offset) * feature->rect[0].weight;
+    HaarValue += calc_sum(feature->rect[1],p_offset) * feature->rect[1].weight;
+    if(weak->rect_num == 3)
+        HaarValue += calc_sum(feature->rect[2],p_offset) * feature->rect[2].weight;
+
+    return HaarValue;
+}
+
+//Return 1 if the window passes every selected weak classifier,
+//margin gets the summed distance of the responses beyond the thresholds
+static int muRunLearnedCascade(MuLearningModel *LearningModel, int p_offset, double norm, double *margin)
+{
+    int j;
+
+    *margin = 0;
+    for(j=0; j<SelectedNum; j++)
+    {
+        const MuLearningHaarClassifier *weak = &LearningModel->pool[SelectedIndex[j]];
+        double HaarValue = muLearningHaarSum(weak, p_offset)*norm;
+
+        if(weak->polar==1)
+        {
+            if(HaarValue <= weak->threshold)
+                return 0;
+            *margin += HaarValue - weak->threshold;
+        }
+        else
+        {
+            if(HaarValue >= weak->threshold)
+                return 0;
+            *margin += weak->threshold - HaarValue;
+        }
+    }
+
+    return 1;
+}
+
+//Evaluate every pool feature on the sample windows.
+//Output is feature-major: values[j*stride + s] is feature j on sample s,
+//so the per-round statistics below read one contiguous row per feature.
+static void muEvalFeaturePool(MuLearningModel *LearningModel, const muLearningSample_t *samples,
+                              int num, float *values, int stride)
+{
+    int j;
+
+    #pragma omp parallel for schedule(static)
+    for(j=0; j<LearningModel->count; j++)
+    {
+        const MuLearningHaarClassifier *weak = &LearningModel->pool[j];
+        float *row = values + j*stride;
+        int s;
+
+        for(s=0; s<num; s++)
+            row[s] = (float)(muLearningHaarSum(weak, samples[s].offset)*samples[s].norm);
+    }
+}
+
+//Heap order of mined samples: lower score first, ties keep the lower offset
+#define MINED_LESS(a,b) ((a).score < (b).score || ((a).score == (b).score && (a).offset > (b).offset))
+
+//Keep the maxNum highest-scoring samples in a min-heap
+static void muPushMined(muLearningSample_t *heap, int *num, int maxNum, const muLearningSample_t *sample)
+{
+    int i, child;
+
+    if(*num < maxNum)
+    {
+        //sift up
+        i = (*num)++;
+        while(i > 0 && MINED_LESS(*sample, heap[(i-1)/2]))
+        {
+            heap[i] = heap[(i-1)/2];
+            i = (i-1)/2;
+        }
+        heap[i] = *sample;
+    }
+    else if(maxNum > 0 && MINED_LESS(heap[0], *sample))
+    {
+        //replace the weakest and sift down
+        i = 0;
+        while((child = 2*i+1) < maxNum)
+        {
+            if(child+1 < maxNum && MINED_LESS(heap[child+1], heap[child]))
+                child++;
+            if(!MINED_LESS(heap[child], *sample))
+                break;
+            heap[i] = heap[child];
+            i = child;
+        }
+        heap[i] = *sample;
+    }
+}
+
+//Mine negatives over every window position (top-left < EndX/EndY) outside of
+//exclude. Windows passing the selected weak classifiers are scored by their
+//margin; the best window of each quarter-window cell goes to a bounded heap
+//per thread so the hardest negatives are not all shifts of one spot, and the
+//heaps are merged at the end. Without selected features the score is a
+//position hash, so the first round gets a uniform random subset of the frame.
+static int muCollectNegatives(MuLearningModel *LearningModel, muSize_t sumSize, int EndX, int EndY,
+                              const muRect_t *exclude, muLearningSample_t *samples, int maxNum)
+{
+    int band, t, i, num = 0;
+    int threads = 1;
+    int cellW, cellH, cellCols, bands;
+    int *heapNum;
+    muLearningSample_t *heaps, *cells;
+
+    cellW = MU_MAX(LearningModel->orig_window_size.width/4, 1);
+    cellH = MU_MAX(LearningModel->orig_window_size.height/4, 1);
+    cellCols = (EndX+cellW-1)/cellW;
+    bands = (EndY+cellH-1)/cellH;
+
+#ifdef _OPENMP
+    threads = omp_get_max_threads();
+#endif
+    heapNum = (int *)calloc(threads, sizeof(int));
+    heaps = (muLearningSample_t *)malloc(threads*maxNum*sizeof(muLearningSample_t));
+    cells = (muLearningSample_t *)malloc(threads*(cellCols+1)*sizeof(muLearningSample_t));
+    if(heapNum == NULL || heaps == NULL || cells == NULL)
+    {
+        free(heapNum);
+        free(heaps);
+        free(cells);
+        return 0;
+    }
+
+    #pragma omp parallel for schedule(dynamic, 1)
+    for(band=0; band<bands; band++)
+    {
+        int ix, iy, c, iyEnd, tid = 0;
+        muLearningSample_t sample, *best;
+
+#ifdef _OPENMP
+        tid = omp_get_thread_num();
+#endif
+        best = cells + tid*(cellCols+1);
+        for(c=0; c<cellCols; c++)
+            best[c].offset = -1;
+
+        iyEnd = (band+1)*cellH;
+        if(iyEnd > EndY)
+            iyEnd = EndY;
+        for(iy=band*cellH; iy<iyEnd; iy++)
+            for(ix=0; ix<EndX; ix++)
+            {
+                double margin;
+
+                if(exclude != NULL &&
+                   iy>exclude->y && iy<exclude->y+exclude->height &&
+                   ix>exclude->x && ix<exclude->x+exclude->width)
+                    continue;
+
+                sample.offset = iy*sumSize.width+ix; //offset of sum
+                sample.norm = muLearningWindowNorm(LearningModel, sample.offset);
+
+                // >= Second round: check detection result for selected feature
+                if(!muRunLearnedCascade(LearningModel, sample.offset, sample.norm, &margin))
+                    continue;
+
+                if(SelectedNum > 0)
+                    sample.score = (float)margin;
+                else
+                    sample.score = (float)((((unsigned int)sample.offset*2654435761u) >> 8) & 0xffff);
+
+                c = ix/cellW;
+                if(best[c].offset < 0 || MINED_LESS(best[c], sample))
+                    best[c] = sample;
+            }
+
+        for(c=0; c<cellCols; c++)
+            if(best[c].offset >= 0)
+                muPushMined(heaps + tid*maxNum, &heapNum[tid], maxNum, &best[c]);
+    }
+
+    for(t=0; t<threads; t++)
+        for(i=0; i<heapNum[t]; i++)
+            muPushMined(samples, &num, maxNum, &heaps[t*maxNum+i]);
+
+    free(heapNum);
+    free(heaps);
+    free(cells);
+
+    return num;
+}
+
+//Threshold blended from the pos mean and the neg mean, polar and remain counts of feature i
+static void muMeanWeakClassifier(MuLearningModel *LearningModel, int i, int TotalPosNum, int TotalNegNum, int Alpha)
+{
+    MuLearningHaarClassifier *weak = &LearningModel->pool[i];
+    const float *pos = HaarValuePos[i];
+    const float *neg = HaarValueNeg[i];
+    float negSum = 0, th;
+    unsigned int remainPos = 0, remainNeg = 0;
+    int j;
+
+    //neg mean
+    for(j=0; j<TotalNegNum; j++)
+        negSum += neg[j];
+    HaarValueNegMean[i] = negSum/TotalNegNum;
+
+    th = ((10-Alpha)*HaarValueNegMean[i] + Alpha*HaarValuePosMean[i])/10;
+    weak->threshold = th;
+
+    //polar, remained neg (false positive) and true positive numbers
+    if(HaarValuePosMean[i]>HaarValueNegMean[i])
+    {
+        weak->polar = 1;
+        for(j=0; j<TotalNegNum; j++)
+            remainNeg += (neg[j] > th);
+        for(j=0; j<TotalPosNum; j++)
+            remainPos += (pos[j] > th);
+    }
+    else
+    {
+        weak->polar = -1;
+        for(j=0; j<TotalNegNum; j++)
+            remainNeg += (neg[j] < th);
+        for(j=0; j<TotalPosNum; j++)
+            remainPos += (pos[j] < th);
+    }
+
+    weak->remainNeg = remainNeg;
+    weak->remainPos = remainPos;
+}
+
+//Per-round threshold, polar and remain counts of every pool feature
+static void muUpdateWeakClassifiers(MuLearningModel *LearningModel, int TotalPosNum, int TotalNegNum, int Alpha)
+{
+    int i;
+
+    #pragma omp parallel for schedule(static)
+    for(i=0; i<features_num; i++)
+        muMeanWeakClassifier(LearningModel, i, TotalPosNum, TotalNegNum, Alpha);
+}
+
+static int muCompareFloat(const void *a, const void *b)
+{
+    float fa = *(const float *)a, fb = *(const float *)b;
+    return (fa > fb) - (fa < fb);
+}
+
+//One cumulative sweep over ascending pos/neg responses of a feature.
+//Every split between distinct values is tried for both polarities; the weak
+//classifier gets the split that passes the fewest negatives while passing at
+//least minPos positives, ties going to the wider gap between the neighbours.
+static void muSweepThreshold(const float *pos, int posNum, const float *neg, int negNum,
+                             int minPos, MuLearningHaarClassifier *weak)
+{
+    int ip = 0, in = 0, polar;
+    int hasLast = 0, hasNext;
+    int bestNeg = negNum+1;
+    float bestGap = -1, last = 0, next = 0, spread;
+
+    spread = 0;
+    if(posNum > 0)
+        spread = pos[posNum-1] - pos[0];
+    if(negNum > 0 && posNum > 0)
+        spread = (MU_MAX(pos[posNum-1], neg[negNum-1])) - (MU_MIN(pos[0], neg[0]));
+    if(spread <= 0)
+        spread = 1;
+
+    weak->polar = 1;
+    weak->threshold = 0;
+    weak->remainPos = 0;
+    weak->remainNeg = negNum;
+
+    for(;;)
+    {
+        float th, gap;
+
+        hasNext = (ip < posNum || in < negNum);
+        if(hasNext)
+        {
+            if(in >= negNum || (ip < posNum && pos[ip] < neg[in]))
+                next = pos[ip];
+            else
+                next = neg[in];
+        }
+
+        if(hasLast && hasNext)
+        {
+            th = (last + next)*0.5f;
+            gap = next - last;
+        }
+        else
+        {
+            th = hasNext ? next - 0.5f*spread : last + 0.5f*spread;
+            gap = FLOAT_MAX;
+        }
+
+        //polar 1 passes the values above the split, -1 the values below
+        for(polar=1; polar>=-1; polar-=2)
+        {
+            int passPos = (polar==1) ? posNum-ip : ip;
+            int passNeg = (polar==1) ? negNum-in : in;
+
+            if(passPos < minPos)
+                continue;
+            if(passNeg < bestNeg || (passNeg == bestNeg && gap > bestGap))
+            {
+                bestNeg = passNeg;
+                bestGap = gap;
+                weak->polar = polar;
+                weak->threshold = th;
+                weak->remainPos = passPos;
+                weak->remainNeg = passNeg;
+            }
+        }
+
+        if(!hasNext)
+            break;
+
+        while(ip < posNum && pos[ip] == next)
+            ip++;
+        while(in < negNum && neg[in] == next)
+            in++;
+        last = next;
+        hasLast = 1;
+    }
+}
+
+//Sorted mode: posSorted holds the pos rows sorted once at the start of
+//learning, a sorted copy of each neg row is made per round, then each feature
+//is swept once. The value rows stay in sample order for the online update.
+static void muSweepWeakClassifiers(MuLearningModel *LearningModel, const float *posSorted, int TotalPosNum, int TotalNegNum)
+{
+    int i;
+
+    #pragma omp parallel for schedule(static)
+    for(i=0; i<features_num; i++)
+    {
+        float neg[MAX_NEG];
+
+        memcpy(neg, HaarValueNeg[i], TotalNegNum*sizeof(float));
+        qsort(neg, TotalNegNum, sizeof(float), muCompareFloat);
+        muSweepThreshold(posSorted + i*MAX_POS, TotalPosNum, neg, TotalNegNum,
+                         TotalPosNum, &LearningModel->pool[i]);
+    }
+}
+
 void muObjectLearning_Init(muImage_t *img, muRect_t *box, muImage_t *ultraNeg)
 {
-    int  i, k, j, n, ix, iy, rm;
+    muObjectLearning_InitEx(img, box, ultraNeg, MU_LEARNING_MEAN);
+}
+
+void muObjectLearning_InitEx(muImage_t *img, muRect_t *box, muImage_t *ultraNeg, int mode)
+{
+    int  i, j, ix, iy, rm;
     int TotalPosNum, TotalNegNum;
     int NegPicActivated = 0;
     int Alpha = 5; //Threshold's pos weight
     int *sum1 = NULL;
     double *sqsum1 = NULL;
-    unsigned char *NewFrame1 = NULL;
     int *sum = NULL;
     double *sqsum = NULL;
-    unsigned char *NewFrame = NULL;
+    float *PosSorted = NULL;
     int PosIn;
     int PosRange;
-    int EndX;
-    int EndY;
-    int PosSartX;
-    int PosSartY;
-    int PosEndX;
-    int PosEndY;
-    double step;
+    int EndX, EndY;
+    int NegEndX, NegEndY;
+    muRect_t PosExclude;
     float minError;
     int featureindex;
-    int EraseFeatureIndex;
     FILE *fp = NULL;
     MuLearningModel *LearningModel;
+    muLearningSample_t PosSamples[MAX_POS];
+    muLearningSample_t NegSamples[MAX_NEG];
     //Pre-prepared neg image
     muSize_t FrameSize1 = {ultraNeg->width, ultraNeg->height};
     muSize_t sumSize1 = {(FrameSize1.width+1), (FrameSize1.height+1)};
@@ -339,331 +732,129 @@ void muObjectLearning_Init(muImage_t *img, muRect_t *box, muImage_t *ultraNeg)
     //MuLearningModel Model1;
     LearningModel = (MuLearningModel *)malloc(sizeof(MuLearningModel));
 
+    //positives never change, the sorted mode sorts a copy of them once
+    if(mode == MU_LEARNING_SORTED)
+    {
+        PosSorted = (float *)malloc(features_num*MAX_POS*sizeof(float));
+        if(LearningModel == NULL || PosSorted == NULL)
+        {
+            free(LearningModel);
+            free(PosSorted);
+            return;
+        }
+    }
+
     //=======================
     //generate feature pool
     //=======================
     randomfeaturepool(LearningModel, box);
-    printf("pool OK \n"); //flag
 
-    selectedIndex = muCreateSeq(sizeof(unsigned int));
-    poolIndex = muCreateSeq(sizeof(unsigned int));
-    
-    
+    memset(PoolUsed, 0, sizeof(PoolUsed));
+    SelectedNum = 0;
+
     /*Intergal Image of Negtive Picture*/
     sum1 = (int*)malloc(sizeof(int)*(sumSize1.height*sumSize1.width));
     sqsum1 = (double*)malloc(sizeof(double)*(sumSize1.height*sumSize1.width));
-    //Mat(ultraNeg) to C array(NewFrame1)
-    NewFrame1 = (unsigned char*)malloc(sizeof(unsigned char)*(FrameSize1.width*FrameSize1.height));
-
-    for(i=0;i<FrameSize1.width*FrameSize1.height;i++)
-        NewFrame1[i]=ultraNeg->imagedata[i];
-
-    muCalcIntegralImage(NewFrame1, sum1, sqsum1, FrameSize1); //set grayImg to integral img
-    free (NewFrame1);
+    muCalcIntegralImage(ultraNeg->imagedata, sum1, sqsum1, FrameSize1); //set grayImg to integral img
 
     //** Haar Values Calculation **//
     ///Integral Image Calculation///
     sum = (int*)malloc(sizeof(int)*(sumSize.height*sumSize.width));
     sqsum = (double*)malloc(sizeof(double)*(sumSize.height*sumSize.width));
-    
-    //Mat(img) to C array(NewFrame)
-    NewFrame = (unsigned char*)malloc(sizeof(unsigned char)*(FrameSize.width*FrameSize.height));
-
-    for(i=0;i<FrameSize.width*FrameSize.height;i++)
-        NewFrame[i]=img->imagedata[i];
-
-    muCalcIntegralImage(NewFrame, sum, sqsum, FrameSize);
-    free (NewFrame);
+    muCalcIntegralImage(img->imagedata, sum, sqsum, FrameSize);
 
     //Set haar pointers to integral image
     setLearningImage(LearningModel, sum, sqsum, sumSize);
 
     /// Pos(GoodBoxs) x featre values ///
-    memset(HaarValuePosMean,0,features_num*sizeof(double));
-
     PosIn=3; TotalPosNum=0;
     for(iy=box->y-PosIn; iy<=box->y+PosIn; iy++)
         for(ix=box->x-PosIn; ix<=box->x+PosIn; ix++)
         {
-            //Run for goodbox->x .y
-            int p_offset, pq_offset;
-            double mean, variance_norm_factor=-1;
+            int p_offset;
 
             if(ix<0 || ix>img->width-box->width || iy<0 || iy>img->height-box->height)
                 continue;
 
-            pq_offset = p_offset = iy * (sumSize.width) + ix; //offset of sum
-            mean = calc_sum(*LearningModel,p_offset)*LearningModel->inv_window_area; //
-        
-            variance_norm_factor = LearningModel->pq0[pq_offset] - LearningModel->pq1[pq_offset] -
-                                   LearningModel->pq2[pq_offset] + LearningModel->pq3[pq_offset];
-            variance_norm_factor = variance_norm_factor*LearningModel->inv_window_area - mean*mean; //Mean(Square sum) - mean(sum) square
-            
-            if( variance_norm_factor >= 0. )
-                variance_norm_factor = sqrt(variance_norm_factor);
-            else
-                variance_norm_factor = 1.;
-            
-            for( j = 0; j < LearningModel->count; j++ )
-            {
-                double HaarValue;
-                MuHaarFeature *feature = &LearningModel->pool[j].feature;
-                HaarValue = calc_sum(feature->rect[0],p_offset) * feature->rect[0].weight;
-                HaarValue += calc_sum(feature->rect[1],p_offset) * feature->rect[1].weight;
-                
-                if(LearningModel->pool[j].rect_num == 3)
-                    HaarValue += calc_sum(feature->rect[2],p_offset) * feature->rect[2].weight;
-
-                HaarValue = (HaarValue*LearningModel->inv_window_area)/variance_norm_factor;
-                HaarValuePos[TotalPosNum][j]=HaarValue;
-                HaarValuePosMean[j]+=HaarValue;
-                //HaarValuePosSqureSum[j]+=HaarValue*HaarValue;
-            }
+            p_offset = iy * (sumSize.width) + ix; //offset of sum
+            PosSamples[TotalPosNum].offset = p_offset;
+            PosSamples[TotalPosNum].norm = muLearningWindowNorm(LearningModel, p_offset);
             TotalPosNum++;
         }
+    muEvalFeaturePool(LearningModel, PosSamples, TotalPosNum, HaarValuePos[0], MAX_POS);
+
+    /// PosHaarMean ///
+    #pragma omp parallel for schedule(static)
+    for(j=0; j<features_num; j++)
+    {
+        float posSum = 0;
+        int s;
+
+        for(s=0; s<TotalPosNum; s++)
+            posSum += HaarValuePos[j][s];
+        HaarValuePosMean[j] = posSum/TotalPosNum;
+        if(mode == MU_LEARNING_SORTED)
+        {
+            memcpy(PosSorted + j*MAX_POS, HaarValuePos[j], TotalPosNum*sizeof(float));
+            qsort(PosSorted + j*MAX_POS, TotalPosNum, sizeof(float), muCompareFloat);
+        }
+    }
 
     /// Neg(BadBoxs) x featre values & Set neg indexes///
     PosRange=MU_MIN(box->width,box->height)*0.1;
     EndX=img->width-box->width;
     EndY=img->height-box->height;
-    PosSartX = box->x-PosRange;
-    PosSartY = box->y-PosRange;
-    PosEndX = box->x+PosRange;
-    PosEndY = box->y+PosRange;
-    step = sqrt((double)EndX*(double)EndY/(double)MAX_NEG);
-    step = muRound(step);
-    // >= second round: step = 1;
-    TotalNegNum = 0;
-    for(iy=0; iy<EndY; iy+=step)
-        for(ix=0; ix<EndX; ix+=step)
-        {
-            int p_offset, pq_offset;
-            double mean, variance_norm_factor=-1;
-            
-            if(iy>PosSartY && iy<PosEndY && ix>PosSartX && ix<PosEndX)
-                continue;
-            if(TotalNegNum>=MAX_NEG)
-                break;
-
-            //Run for badbox->x .y
-
-            pq_offset = p_offset = iy*sumSize.width+ix; //offset of sum
-
-            mean = calc_sum(*LearningModel,p_offset)*LearningModel->inv_window_area; //
-        
-            variance_norm_factor = LearningModel->pq0[pq_offset] - LearningModel->pq1[pq_offset] -
-                                   LearningModel->pq2[pq_offset] + LearningModel->pq3[pq_offset];
-            variance_norm_factor = variance_norm_factor*LearningModel->inv_window_area - mean*mean; //Mean(Square sum) - mean(sum) square
-            
-            if( variance_norm_factor >= 0. )
-                variance_norm_factor = sqrt(variance_norm_factor);
-            else
-                variance_norm_factor = 1.;
-            
-            // >= Second round: check detection result for selected feature
-            for( j = 0; j < LearningModel->count; j++ )
-            {
-                double HaarValue;
-
-                MuHaarFeature *feature = &LearningModel->pool[j].feature;
-                HaarValue = calc_sum(feature->rect[0],p_offset) * feature->rect[0].weight;
-                HaarValue += calc_sum(feature->rect[1],p_offset) * feature->rect[1].weight;
-                
-                if(LearningModel->pool[j].rect_num == 3)
-                    HaarValue += calc_sum(feature->rect[2],p_offset) * feature->rect[2].weight;
-
-                HaarValue = (HaarValue*LearningModel->inv_window_area)/variance_norm_factor;
-                HaarValueNeg[TotalNegNum][j]=HaarValue;
-            }
-
-            TotalNegNum++;
-        }// End ix
-        //End iy
-
-    /// PosHaarMean & Indexes ///
-    for(j=0; j<features_num; j++)
-    {
-        HaarValuePosMean[j]=HaarValuePosMean[j]/TotalPosNum;
-        //HaarValuePosSqureSum[j] = HaarValuePosSqureSum[j]/(PosBoxes.size()) - HaarValuePosMean[j]*HaarValuePosMean[j];
-        //HaarValuePosSqureSum[j] = sqrt(HaarValuePosSqureSum[j]);
-        muPushSeq(poolIndex, (MU_VOID *)&j);
-    }
+    NegEndX=ultraNeg->width-box->width;
+    NegEndY=ultraNeg->height-box->height;
+    PosExclude.x = box->x-PosRange;
+    PosExclude.y = box->y-PosRange;
+    PosExclude.width = PosExclude.height = 2*PosRange;
+    TotalNegNum = muCollectNegatives(LearningModel, sumSize, EndX, EndY, &PosExclude, NegSamples, MAX_NEG);
+    muEvalFeaturePool(LearningModel, NegSamples, TotalNegNum, HaarValueNeg[0], MAX_NEG);
 
     //Do While Loop
     do{
         //Select a weak-classifier
         //check for remained pos >= PosBoxes.size() and mini negremain
-        minError = FLOAT_MAX;
-        featureindex=0;
-        EraseFeatureIndex=-1;
+        if(mode == MU_LEARNING_SORTED)
+            muSweepWeakClassifiers(LearningModel, PosSorted, TotalPosNum, TotalNegNum);
+        else
+            muUpdateWeakClassifiers(LearningModel, TotalPosNum, TotalNegNum, Alpha);
 
-        memset(HaarValueNegMean,0,features_num*sizeof(double));
+        minError = FLOAT_MAX;
+        featureindex=-1;
         for(i=0; i<features_num; i++)
         {
-            //threshold
-            double TmpThreshold;
-            
-            //Calculate Neg Mean, threshold, polar
-            for(j=0; j<TotalNegNum; j++)
-                HaarValueNegMean[i] += HaarValueNeg[j][i];
-
-            //neg mean
-            HaarValueNegMean[i]=HaarValueNegMean[i]/TotalNegNum;
-            
-            LearningModel->pool[i].threshold = ((10-Alpha)*HaarValueNegMean[i] + Alpha*HaarValuePosMean[i])/10;
-
-            //polar
-            if(HaarValuePosMean[i]>HaarValueNegMean[i])
-                LearningModel->pool[i].polar = 1;
-            else
-                LearningModel->pool[i].polar = -1;
-
-            //Count remained neg (false potive) number for each weak classifiers
-            //reset remainNeg
-            LearningModel->pool[i].remainNeg = 0;
-
-            for(j=0; j<TotalNegNum; j++)
-            {
-                if(LearningModel->pool[i].polar==1)
-                {
-                    if(HaarValueNeg[j][i] > LearningModel->pool[i].threshold)
-                        LearningModel->pool[i].remainNeg++;
-                }
-                else
-                {
-                    if(HaarValueNeg[j][i] < LearningModel->pool[i].threshold)
-                        LearningModel->pool[i].remainNeg++;
-                }
-            }
-
-            //Count true positive number
-            //reset remainPos
-            LearningModel->pool[i].remainPos = 0;
-            for(j=0; j<TotalPosNum; j++)
-            {
-                if(LearningModel->pool[i].polar==1)
-                {
-                    if(HaarValuePos[j][i] > LearningModel->pool[i].threshold)
-                        LearningModel->pool[i].remainPos++;
-                }
-                else
-                {
-                    if(HaarValuePos[j][i] < LearningModel->pool[i].threshold)
-                        LearningModel->pool[i].remainPos++;
-                }
-            }
-        }// end for each feauture
-
-        
-        //for(i=0; i<poolIndex.size(); i++)
-        for(i=0; i<poolIndex->total; i++)
-        {
-            //n = poolIndex[i];
-            n = (*(int *)muGetSeqElement(&poolIndex, i+1));
-            if(minError > LearningModel->pool[n].remainNeg && 
-               LearningModel->pool[n].remainPos >= TotalPosNum)
+            if(PoolUsed[i])
+                continue;
+            if(minError > LearningModel->pool[i].remainNeg &&
+               LearningModel->pool[i].remainPos >= (MU_32U)TotalPosNum)
             {
-                minError = LearningModel->pool[n].remainNeg;
-                featureindex=n;
-                EraseFeatureIndex=i;
+                minError = LearningModel->pool[i].remainNeg;
+                featureindex=i;
             }
         }
-        
-        if(EraseFeatureIndex!=-1)
+
+        if(featureindex!=-1)
         {
-            //record selected index
-            //selectedIndex.push_back(featureindex);
-            muPushSeq(selectedIndex, &featureindex);
-            //Remove seleted feature index from poolindex
-            //poolIndex.erase(poolIndex.begin() + EraseFeatureIndex);
-            muRemoveIndexNode(&poolIndex, EraseFeatureIndex+1);
+            //record selected index and remove it from the pool
+            SelectedIndex[SelectedNum++] = featureindex;
+            PoolUsed[featureindex] = 1;
         }
         else
         {
-            if(Alpha > 0)
-                Alpha--;
+            //no weak classifier keeps all positives even at the neg mean
+            //(the sorted sweep always finds one, so it only stops here)
+            if(Alpha == 0 || mode == MU_LEARNING_SORTED)
+                break;
+            Alpha--;
             continue;
         }
 
         //Renew NegSamples and thier haar value
         TotalNegNum = 0;
-        step = 1;
-        if(NegPicActivated==0){
-        for(iy=0; iy<EndY; iy+=step)
-        for(ix=0; ix<EndX; ix+=step)
-        {
-            //Run for badbox->x .y
-            int p_offset, pq_offset;
-            double mean, variance_norm_factor=-1;
-            // >= Second round: check detection result for selected feature
-            int CurrResult=0;
-
-            if(iy>PosSartY && iy<PosEndY && ix>PosSartX && ix<PosEndX)
-                continue;
-            if(TotalNegNum>=MAX_NEG)
-                break;
-
-            pq_offset = p_offset = iy*sumSize.width+ix; //offset of sum
-
-            mean = calc_sum(*LearningModel,p_offset)*LearningModel->inv_window_area; //
-        
-            variance_norm_factor = LearningModel->pq0[pq_offset] - LearningModel->pq1[pq_offset] -
-                                   LearningModel->pq2[pq_offset] + LearningModel->pq3[pq_offset];
-            variance_norm_factor = variance_norm_factor*LearningModel->inv_window_area - mean*mean; //Mean(Square sum) - mean(sum) square
-            
-            if( variance_norm_factor >= 0. )
-                variance_norm_factor = sqrt(variance_norm_factor);
-            else
-                variance_norm_factor = 1.;
-            
-            
-            //for (j=0; j<selectedIndex.size(); j++)
-            for (j=0; j<selectedIndex->total; j++)
-            {   
-                double HaarValue;
-                MuHaarFeature *feature;
-                int pos_j = (*(int*)muGetSeqElement(&selectedIndex, j+1));
-
-                feature = &LearningModel->pool[pos_j].feature;
-                HaarValue = calc_sum(feature->rect[0],p_offset) * feature->rect[0].weight;
-                HaarValue += calc_sum(feature->rect[1],p_offset) * feature->rect[1].weight;
-
-                if(LearningModel->pool[pos_j].rect_num == 3)
-                    HaarValue += calc_sum(feature->rect[2],p_offset) * feature->rect[2].weight;
-
-                HaarValue = (HaarValue*LearningModel->inv_window_area)/variance_norm_factor;
-
-                if(LearningModel->pool[pos_j].polar==1)
-                {
-                    if(HaarValue <= LearningModel->pool[pos_j].threshold)
-                        CurrResult=1;
-                }
-                else
-                {
-                    if(HaarValue >= LearningModel->pool[pos_j].threshold)
-                        CurrResult=1;
-                }
-            }
-            if(CurrResult==1)
-                continue;
-
-            for( j = 0; j < LearningModel->count; j++ )
-            {
-                double HaarValue;
-                MuHaarFeature *feature = &LearningModel->pool[j].feature;
-                HaarValue = calc_sum(feature->rect[0],p_offset) * feature->rect[0].weight;
-                HaarValue += calc_sum(feature->rect[1],p_offset) * feature->rect[1].weight;
-                
-                if(LearningModel->pool[j].rect_num == 3)
-                    HaarValue += calc_sum(feature->rect[2],p_offset) * feature->rect[2].weight;
-
-                HaarValue = (HaarValue*LearningModel->inv_window_area)/variance_norm_factor;
-                HaarValueNeg[TotalNegNum][j]=HaarValue;
-                //HaarValueNegMean[j]+=HaarValue;
-            }
-            TotalNegNum++;
-        }// End ix //End iy
-        }// End if NegPic Activated
+        if(NegPicActivated==0)
+            TotalNegNum = muCollectNegatives(LearningModel, sumSize, EndX, EndY, &PosExclude, NegSamples, MAX_NEG);
 
         if(TotalNegNum <=0 && NegPicActivated==0 )
         {
@@ -672,131 +863,281 @@ void muObjectLearning_Init(muImage_t *img, muRect_t *box, muImage_t *ultraNeg)
         }
 
         if( NegPicActivated==1 )
-        {
-            //setLearningImage(LearningModel, sum1, sqsum1, sumSize1);
-            for(iy=0; iy<EndY; iy++)
-            for(ix=0; ix<EndX; ix++)
-            {
-                //Run for badbox->x .y
-                int p_offset, pq_offset;
-                double mean, variance_norm_factor=-1;
-                // >= Second round: check detection result for selected feature
-                int CurrResult=0;
-                //if(iy>PosSartY && iy<PosEndY && ix>PosSartX && ix<PosEndX)
-                //    continue;
-                if(TotalNegNum>=MAX_NEG)
-                    break;
-
-                pq_offset = p_offset = iy*sumSize.width+ix; //offset of sum
-
-                mean = calc_sum(*LearningModel,p_offset)*LearningModel->inv_window_area; //
-            
-                variance_norm_factor = LearningModel->pq0[pq_offset] - LearningModel->pq1[pq_offset] -
-                                       LearningModel->pq2[pq_offset] + LearningModel->pq3[pq_offset];
-                variance_norm_factor = variance_norm_factor*LearningModel->inv_window_area - mean*mean; //Mean(Square sum) - mean(sum) square
-                
-                if( variance_norm_factor >= 0. )
-                    variance_norm_factor = sqrt(variance_norm_factor);
-                else
-                    variance_norm_factor = 1.;
-                
-                
-                //for (j=0; j<selectedIndex.size(); j++)
-                for (j=0; j<selectedIndex->total; j++)
-                {
-                    double HaarValue;
-                    int pos_j = (*(int*)muGetSeqElement(&selectedIndex, j+1));
-                    MuHaarFeature *feature = &LearningModel->pool[pos_j].feature;
-                    HaarValue = calc_sum(feature->rect[0],p_offset) * feature->rect[0].weight;
-                    HaarValue += calc_sum(feature->rect[1],p_offset) * feature->rect[1].weight;
-
-                    if(LearningModel->pool[pos_j].rect_num == 3)
-                        HaarValue += calc_sum(feature->rect[2],p_offset) * feature->rect[2].weight;
-
-                    HaarValue = (HaarValue*LearningModel->inv_window_area)/variance_norm_factor;
-
-                    if(LearningModel->pool[pos_j].polar==1)
-                    {
-                        if(HaarValue <= LearningModel->pool[pos_j].threshold)
-                            CurrResult=1;
-                    }
-                    else
-                    {
-                        if(HaarValue >= LearningModel->pool[pos_j].threshold)
-                            CurrResult=1;
-                    }
-                }
-                if(CurrResult==1)
-                    continue;
+            TotalNegNum = muCollectNegatives(LearningModel, sumSize1, NegEndX, NegEndY, NULL, NegSamples, MAX_NEG);
 
-                for( j = 0; j < LearningModel->count; j++ )
-                {
-                    double HaarValue;
-                    MuHaarFeature *feature = &LearningModel->pool[j].feature;
-                    HaarValue = calc_sum(feature->rect[0],p_offset) * feature->rect[0].weight;
-                    HaarValue += calc_sum(feature->rect[1],p_offset) * feature->rect[1].weight;
-                    
-                    if(LearningModel->pool[j].rect_num == 3)
-                        HaarValue += calc_sum(feature->rect[2],p_offset) * feature->rect[2].weight;
-
-                    HaarValue = (HaarValue*LearningModel->inv_window_area)/variance_norm_factor;
-                    HaarValueNeg[TotalNegNum][j]=HaarValue;
-                }
-                TotalNegNum++;
-            }
-        }
-    } while(TotalNegNum>10 && selectedIndex->total<50);//while(TotalNegNum>0 && selectedIndex.size()<50);
+        muEvalFeaturePool(LearningModel, NegSamples, TotalNegNum, HaarValueNeg[0], MAX_NEG);
+    } while(TotalNegNum>10 && SelectedNum<MAX_SELECTED);
 
     //write selected features into txt
     fp = fopen("MuDetector.txt", "w");
     if (fp== NULL) {
         printf("Error in opening a file..");
     }
-    
-    fprintf(fp,"%d %d\n",box->width,box->height);
-    fprintf(fp,"%d\n",selectedIndex->total);
-
-    for (i = 0;i<selectedIndex->total;i++)
+    else
     {
-        int pos_i = (*(int*)muGetSeqElement(&selectedIndex, i+1));
+        fprintf(fp,"%d %d\n",box->width,box->height);
+        fprintf(fp,"%d\n",SelectedNum);
 
-        fprintf(fp,"%d\n",1);
-        fprintf(fp,"%d\n",1);
-        fprintf(fp,"%d\n",LearningModel->pool[pos_i].rect_num);
-        for (rm = 0; rm <LearningModel->pool[pos_i].rect_num ;rm++ )
-        {
-            MuHaarFeature *feature = &(LearningModel->pool[pos_i].feature);
-            fprintf(fp,"%d %d %d %d %f\n",feature->rect[rm].r.x, feature->rect[rm].r.y,feature->rect[rm].r.width,feature->rect[rm].r.height,feature->rect[rm].ori_weight);
-        }
-     
-        fprintf(fp,"%d\n",0);
-        //w-classifier's th
-        fprintf(fp,"%lf\n",LearningModel->pool[pos_i].threshold);
-        //left and right value
-        if(LearningModel->pool[pos_i].polar==1)
-        {
-            fprintf(fp,"%lf\n",(float)0);
-            fprintf(fp,"%lf\n",(float)1);
-        }
-        else
+        for (i = 0;i<SelectedNum;i++)
         {
-            fprintf(fp,"%lf\n",(float)1);
-            fprintf(fp,"%lf\n",(float)0);
-        }
+            int pos_i = SelectedIndex[i];
 
-        //fprintf(fp,"%lf\n",(float)(selectedIndex.size()-0.5));
-        fprintf(fp,"%lf\n",0.5);
-        fprintf(fp,"-1\n");
-        fprintf(fp,"-1\n");
-    }// end for selectedIndex (selected weak-classifiers)
-    
-    fclose(fp);
+            fprintf(fp,"%d\n",1);
+            fprintf(fp,"%d\n",1);
+            fprintf(fp,"%d\n",LearningModel->pool[pos_i].rect_num);
+            for (rm = 0; rm <LearningModel->pool[pos_i].rect_num ;rm++ )
+            {
+                MuHaarFeature *feature = &(LearningModel->pool[pos_i].feature);
+                fprintf(fp,"%d %d %d %d %f\n",feature->rect[rm].r.x, feature->rect[rm].r.y,feature->rect[rm].r.width,feature->rect[rm].r.height,feature->rect[rm].ori_weight);
+            }
+
+            fprintf(fp,"%d\n",0);
+            //w-classifier's th
+            fprintf(fp,"%lf\n",LearningModel->pool[pos_i].threshold);
+            //left and right value
+            if(LearningModel->pool[pos_i].polar==1)
+            {
+                fprintf(fp,"%lf\n",(float)0);
+                fprintf(fp,"%lf\n",(float)1);
+            }
+            else
+            {
+                fprintf(fp,"%lf\n",(float)1);
+                fprintf(fp,"%lf\n",(float)0);
+            }
+
+            fprintf(fp,"%lf\n",0.5);
+            fprintf(fp,"-1\n");
+            fprintf(fp,"-1\n");
+        }// end for SelectedIndex (selected weak-classifiers)
+
+        fclose(fp);
+    }
+
+    //Keep the model for muObjectLearning_Update: the candidates are the best
+    //remaining pool features of the last round
+    CandidateNum = 0;
+    for(i=0; i<features_num && CandidateNum<MAX_CANDIDATE; i++)
+        if(!PoolUsed[i])
+            CandidateIndex[CandidateNum++] = i;
+    for(; i<features_num; i++)
+    {
+        int worst = 0;
+
+        if(PoolUsed[i])
+            continue;
+        for(j=1; j<CandidateNum; j++)
+            if(LearningModel->pool[CandidateIndex[j]].remainNeg > LearningModel->pool[CandidateIndex[worst]].remainNeg)
+                worst = j;
+        if(LearningModel->pool[i].remainNeg < LearningModel->pool[CandidateIndex[worst]].remainNeg)
+            CandidateIndex[worst] = i;
+    }
+    LearnedPosNum = TotalPosNum;
+    LearnedNegNum = TotalNegNum;
+    PosNext = TotalPosNum % MAX_POS;
+    NegNext = TotalNegNum % MAX_NEG;
+    LearnedMode = mode;
+    LearnedAlpha = Alpha;
 
     free (sum);
     free (sqsum);
-    free(LearningModel);
-    muClearSeq(&selectedIndex);
-    muClearSeq(&poolIndex);
+    free (sum1);
+    free (sqsum1);
+    free (PosSorted);
+    if(LearnedModel != NULL)
+        free(LearnedModel);
+    LearnedModel = LearningModel;
 }
 
+//Evaluate a list of features on samples stored at the given ring slots
+static void muEvalFeatureSlots(MuLearningModel *LearningModel, const int *features, int featureNum,
+                               const muLearningSample_t *samples, const int *slots, int num, float *values, int stride)
+{
+    int j;
+
+    #pragma omp parallel for schedule(static)
+    for(j=0; j<featureNum; j++)
+    {
+        const MuLearningHaarClassifier *weak = &LearningModel->pool[features[j]];
+        float *row = values + features[j]*stride;
+        int s;
+
+        for(s=0; s<num; s++)
+            row[slots[s]] = (float)(muLearningHaarSum(weak, samples[s].offset)*samples[s].norm);
+    }
+}
+
+//Re-score one feature on the current sample rings with the rule it was learned
+//by. The sweep sorts copies so that slot s keeps holding the same sample in
+//every row.
+static void muRescoreFeature(MuLearningModel *LearningModel, int index)
+{
+    float pos[MAX_POS], neg[MAX_NEG];
+
+    if(LearnedMode != MU_LEARNING_SORTED)
+    {
+        float posSum = 0;
+        int s;
+
+        for(s=0; s<LearnedPosNum; s++)
+            posSum += HaarValuePos[index][s];
+        HaarValuePosMean[index] = posSum/LearnedPosNum;
+        muMeanWeakClassifier(LearningModel, index, LearnedPosNum, LearnedNegNum, LearnedAlpha);
+        return;
+    }
+
+    memcpy(pos, HaarValuePos[index], LearnedPosNum*sizeof(float));
+    memcpy(neg, HaarValueNeg[index], LearnedNegNum*sizeof(float));
+    qsort(pos, LearnedPosNum, sizeof(float), muCompareFloat);
+    qsort(neg, LearnedNegNum, sizeof(float), muCompareFloat);
+    muSweepThreshold(pos, LearnedPosNum, neg, LearnedNegNum, LearnedPosNum, &LearningModel->pool[index]);
+}
+
+//Copy a learned weak classifier into the single node of a detector stage
+static void muSetDetectorStage(MuSimpleDetector *Detector, int stage, const MuLearningHaarClassifier *weak)
+{
+    MuHaarStageClassifier *stage_classifier = Detector->stage_classifier + stage;
+    MuHaarTreeNode *node = &stage_classifier->classifier[0].node;
+    int rm;
+
+    for(rm=0; rm<weak->rect_num; rm++)
+    {
+        node->feature.rect[rm].r = weak->feature.rect[rm].r;
+        node->feature.rect[rm].ori_weight = weak->feature.rect[rm].ori_weight;
+    }
+    if(weak->rect_num == 2)
+        memset(&node->feature.rect[2], 0, sizeof(node->feature.rect[2]));
+    node->feature.tilted = 0;
+    node->two_rects = (weak->rect_num == 2);
+    stage_classifier->two_rects = node->two_rects;
+
+    node->threshold = weak->threshold;
+    node->left = (weak->polar==1) ? 0.f : 1.f;
+    node->right = (weak->polar==1) ? 1.f : 0.f;
+}
+
+/*
+ * Online refinement of the last learned detector with a new frame.
+ * The box (of the learned window size) adds positives, windows away from it
+ * that still pass the detector are taken as hard negatives. Only the
+ * selected weak classifiers and the candidate pool are re-scored, by the
+ * mean blend or the sorted sweep the model was learned with; every
+ * stage of Detector (loaded from the learned model) gets its new threshold
+ * and polarity, and the weakest stage is swapped for a better candidate.
+ */
+muError_t muObjectLearning_Update(muImage_t *img, muRect_t *box, MuSimpleDetector *Detector)
+{
+    int i, ix, iy, num, worst, best;
+    int *sum = NULL;
+    double *sqsum = NULL;
+    int active[MAX_SELECTED+MAX_CANDIDATE];
+    int slots[MAX_POS];
+    muLearningSample_t samples[MAX_POS];
+    muRect_t exclude;
+    muSize_t FrameSize, sumSize;
+    MuLearningModel *LearningModel = LearnedModel;
+
+    if(LearningModel == NULL || img == NULL || box == NULL || Detector == NULL)
+        return MU_ERR_NULL_POINTER;
+    if(Detector->count != SelectedNum ||
+       box->width != LearningModel->orig_window_size.width ||
+       box->height != LearningModel->orig_window_size.height)
+        return MU_ERR_INVALID_PARAMETER;
+    for(i=0; i<SelectedNum; i++)
+        if(Detector->stage_classifier[i].count != 1)
+            return MU_ERR_INVALID_PARAMETER;
+
+    FrameSize.width = img->width;
+    FrameSize.height = img->height;
+    sumSize.width = FrameSize.width+1;
+    sumSize.height = FrameSize.height+1;
+    sum = (int*)malloc(sizeof(int)*(sumSize.height*sumSize.width));
+    sqsum = (double*)malloc(sizeof(double)*(sumSize.height*sumSize.width));
+    if(sum == NULL || sqsum == NULL)
+    {
+        free(sum);
+        free(sqsum);
+        return MU_ERR_OUT_OF_MEMORY;
+    }
+    muCalcIntegralImage(img->imagedata, sum, sqsum, FrameSize);
+    setLearningImage(LearningModel, sum, sqsum, sumSize);
+
+    memcpy(active, SelectedIndex, SelectedNum*sizeof(int));
+    memcpy(active+SelectedNum, CandidateIndex, CandidateNum*sizeof(int));
+
+    //New positives: the box and its one pixel shifts
+    num = 0;
+    for(iy=box->y-1; iy<=box->y+1; iy++)
+        for(ix=box->x-1; ix<=box->x+1; ix++)
+        {
+            if(ix<0 || ix>img->width-box->width || iy<0 || iy>img->height-box->height)
+                continue;
+            samples[num].offset = iy*sumSize.width+ix;
+            samples[num].norm = muLearningWindowNorm(LearningModel, samples[num].offset);
+            slots[num] = PosNext;
+            PosNext = (PosNext+1) % MAX_POS;
+            num++;
+        }
+    muEvalFeatureSlots(LearningModel, active, SelectedNum+CandidateNum, samples, slots, num, HaarValuePos[0], MAX_POS);
+    LearnedPosNum = MU_MIN(LearnedPosNum+num, MAX_POS);
+
+    //Hard negatives: false alarms of the current cascade away from the box
+    exclude.x = box->x - box->width/2;
+    exclude.y = box->y - box->height/2;
+    exclude.width = box->width;
+    exclude.height = box->height;
+    num = muCollectNegatives(LearningModel, sumSize, img->width-box->width, img->height-box->height,
+                             &exclude, samples, MAX_ONLINE_NEG);
+    for(i=0; i<num; i++)
+    {
+        slots[i] = NegNext;
+        NegNext = (NegNext+1) % MAX_NEG;
+    }
+    muEvalFeatureSlots(LearningModel, active, SelectedNum+CandidateNum, samples, slots, num, HaarValueNeg[0], MAX_NEG);
+    LearnedNegNum = MU_MIN(LearnedNegNum+num, MAX_NEG);
+
+    //Re-score the selected and candidate weak classifiers
+    #pragma omp parallel for schedule(static)
+    for(i=0; i<SelectedNum+CandidateNum; i++)
+        muRescoreFeature(LearningModel, active[i]);
+
+    //Swap the weakest stage for the best candidate keeping every positive when it rejects more
+    worst = best = -1;
+    for(i=0; i<SelectedNum; i++)
+        if(worst < 0 || LearningModel->pool[SelectedIndex[i]].remainNeg > LearningModel->pool[SelectedIndex[worst]].remainNeg)
+            worst = i;
+    for(i=0; i<CandidateNum; i++)
+    {
+        if(LearningModel->pool[CandidateIndex[i]].remainPos < (MU_32U)LearnedPosNum)
+            continue;
+        if(best < 0 || LearningModel->pool[CandidateIndex[i]].remainNeg < LearningModel->pool[CandidateIndex[best]].remainNeg)
+            best = i;
+    }
+    if(worst >= 0 && best >= 0 &&
+       LearningModel->pool[CandidateIndex[best]].remainNeg < LearningModel->pool[SelectedIndex[worst]].remainNeg)
+    {
+        int tmp = SelectedIndex[worst];
+
+        SelectedIndex[worst] = CandidateIndex[best];
+        CandidateIndex[best] = tmp;
+        PoolUsed[SelectedIndex[worst]] = 1;
+        PoolUsed[tmp] = 0;
+    }
+
+    for(i=0; i<SelectedNum; i++)
+        muSetDetectorStage(Detector, i, &LearningModel->pool[SelectedIndex[i]]);
+
+    free(sum);
+    free(sqsum);
+
+    return MU_ERR_SUCCESS;
+}
+
+void muObjectLearning_Release()
+{
+    if(LearnedModel != NULL)
+        free(LearnedModel);
+    LearnedModel = NULL;
+    SelectedNum = CandidateNum = 0;
+}
 